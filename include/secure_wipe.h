@@ -1,6 +1,20 @@
 #pragma once
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define SECUREWIPE_HAS_COROUTINES 1
+#endif
+#endif
 
 namespace securewipe {
 
@@ -9,17 +23,275 @@ enum class Pattern {
     Random
 };
 
+// Which files a directory wipe selects. Patterns use gitignore syntax
+// ("*.log", "/build/", "cache/**", "!keep.txt"); age limits are in seconds.
+struct FilterRules {
+    std::vector<std::string> include;   // if non-empty, only matching files (or files below matching dirs)
+    std::vector<std::string> exclude;   // gitignore rules; the last matching rule wins
+    std::uint64_t min_size = 0;
+    std::uint64_t max_size = UINT64_MAX;
+    std::int64_t mtime_older_than = -1; // -1 = any age
+    std::int64_t atime_older_than = -1;
+    std::int64_t owner_uid = -1;        // -1 = any owner
+
+    bool empty() const {
+        return include.empty() && exclude.empty() && min_size == 0 && max_size == UINT64_MAX &&
+               mtime_older_than < 0 && atime_older_than < 0 && owner_uid < 0;
+    }
+};
+
+// Incremental re-scan for directory wipes repeated over the same tree.
+// Directories whose metadata has not changed since the previous run, and that
+// held no candidate files then, are not re-read.
+struct ScanIndexOptions {
+    std::string path;               // index file; empty = always walk everything
+    unsigned full_scan_every = 24;  // ignore the index every N runs (0 = never)
+};
+
+// Crash-safe progress journal: a killed job re-run with resume = true
+// continues large files from their last checkpoint instead of pass 1.
+struct JournalOptions {
+    std::string path;                   // journal file; empty = none
+    bool resume = false;                // continue the job recorded in `path`
+    unsigned sync_ms = 1000;            // fsync the journal at most this often (0 = every record)
+    std::uint64_t checkpoint_bytes = 64ULL << 20; // progress granularity inside a file
+};
+
+// Tamper-evident audit ledger: a hash-chained record of every file a job
+// overwrites, appended in batches by a background thread.
+struct LedgerOptions {
+    std::string path;                   // ledger file; empty = none
+    unsigned commit_ms = 200;           // group commit: gather records this long before a write + sync
+};
+
 struct WipeOptions {
     int passes = 1;                 // overwrite passes
     Pattern pattern = Pattern::Zeros;
     std::size_t block_size = 1 << 20; // 1 MiB
+    FilterRules filter;             // directory wipes only
+    ScanIndexOptions index;         // directory wipes only
+    bool one_file_system = false;   // directory wipes: do not descend into other mounts
+    bool skip_open_files = false;   // directory wipes: leave files other processes hold open
+    std::vector<std::string> if_contains; // directory wipes: only files containing one of these byte strings
+    bool calibrate = false;         // dry-run plan: time a probe write on each device
+    std::vector<std::string> protect; // extra protected subtrees, refused by every wipe
+    JournalOptions journal;         // wipe_file and directory wipes
+    LedgerOptions ledger;           // every wipe
+};
+
+// File counters of one job, or cumulative for a WipeSession.
+struct WipeStats {
+    std::uint64_t files_wiped = 0;
+    std::uint64_t files_failed = 0;
+    std::uint64_t files_skipped = 0;    // not attempted (cancelled or deadline)
+    std::uint64_t bytes_overwritten = 0;
 };
 
 struct WipeResult {
     bool ok = false;
     std::string message;  // error or info
+    WipeStats stats;      // filled by session jobs
 };
 
 WipeResult wipe_file(const std::string& path, const WipeOptions& opt);
+// Overwrite `length` bytes of `path` from `offset` (UINT64_MAX = to the end
+// of the file) with opt.passes synced passes. The file keeps its size; it
+// is deleted afterwards only if !keep_file.
+WipeResult wipe_range(const std::string& path, std::uint64_t offset, std::uint64_t length, const WipeOptions& opt,
+                      bool keep_file = true);
 WipeResult wipe_directory(const std::string& dir, const WipeOptions& opt, bool dry_run, bool yes);
-} // namespace securewipe
\ No newline at end of file
+
+struct SessionOptions {
+    unsigned threads = 0;           // worker threads (0 = hardware concurrency)
+};
+
+// Cancellation handle modelled on std::stop_token (C++17-compatible).
+class StopToken {
+public:
+    StopToken() = default;
+    bool stop_requested() const noexcept { return state_ && state_->load(std::memory_order_relaxed); }
+    bool stop_possible() const noexcept { return state_ != nullptr; }
+
+private:
+    friend class StopSource;
+    explicit StopToken(std::shared_ptr<std::atomic<bool>> s) : state_(std::move(s)) {}
+    std::shared_ptr<std::atomic<bool>> state_;
+};
+
+class StopSource {
+public:
+    StopSource() : state_(std::make_shared<std::atomic<bool>>(false)) {}
+    // Returns true if this call made the request.
+    bool request_stop() noexcept { return !state_->exchange(true); }
+    bool stop_requested() const noexcept { return state_->load(std::memory_order_relaxed); }
+    StopToken get_token() const noexcept { return StopToken(state_); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> state_;
+};
+
+using WipeCallback = std::function<void(const WipeResult&)>;
+
+struct SubmitOptions {
+    WipeCallback on_complete;       // runs on a worker thread; must not block on the session
+    StopToken stop_token;           // optional external cancellation
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max();  // max() = no deadline
+    bool dry_run = false;           // list instead of wiping; nothing is changed
+    bool recursive = false;         // allow a directory target; without it a directory fails
+    int priority = 0;               // queued work with higher priority runs first
+    // Directory jobs: called from the walk for each file selected for wiping
+    // (not its extra hard links), with its size. Runs on a worker thread.
+    std::function<void(const std::string&, std::uint64_t)> on_file;
+};
+
+// Handle to a submitted job. Copyable; all copies refer to the same job.
+class WipeTicket {
+public:
+    WipeTicket() = default;
+    WipeTicket(std::shared_future<WipeResult> f, StopSource s) : future_(std::move(f)), stop_(std::move(s)) {}
+
+    bool valid() const { return future_.valid(); }
+    bool ready() const {
+        return future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+    WipeResult get() const { return future_.get(); }  // blocks until the job completes
+    const std::shared_future<WipeResult>& future() const { return future_; }
+
+    // Ask the job to stop. Files not yet started are skipped; a file being
+    // overwritten is abandoned between blocks and left in place.
+    bool cancel() { return stop_.request_stop(); }
+    StopToken stop_token() const { return stop_.get_token(); }
+
+private:
+    std::shared_future<WipeResult> future_;
+    StopSource stop_;
+};
+
+#if defined(SECUREWIPE_HAS_COROUTINES)
+class WipeSession;
+
+// Hands a ready coroutine back to its event loop. Empty = resume inline on the
+// worker thread that completed the job (see wipe_file_async).
+using ResumeExecutor = std::function<void(std::coroutine_handle<>)>;
+
+// Result of WipeSession::wipe_file_async / wipe_directory_async.
+// The awaiting coroutine is suspended while the job runs on the session pool;
+// no thread is held waiting for it. Cancel through SubmitOptions::stop_token.
+class WipeAwaitable {
+public:
+    // directory: wipe `path` as a tree, behind the `yes` gate; otherwise as a
+    // single regular file.
+    WipeAwaitable(WipeSession& session, std::string path, const WipeOptions& opt,
+                  SubmitOptions so, ResumeExecutor resume_on, bool directory = false, bool yes = false)
+        : session_(session), path_(std::move(path)), opt_(opt), so_(std::move(so)),
+          resume_on_(std::move(resume_on)), directory_(directory), yes_(yes) {}
+
+    bool await_ready() const noexcept { return false; }
+    inline void await_suspend(std::coroutine_handle<> h);
+    WipeResult await_resume() { return std::move(result_); }
+
+private:
+    WipeSession& session_;
+    std::string path_;
+    WipeOptions opt_;
+    SubmitOptions so_;
+    ResumeExecutor resume_on_;
+    bool directory_;
+    bool yes_;
+    WipeResult result_;
+};
+#endif
+
+// Long-lived wipe engine for embedding.
+// Owns the worker threads, their I/O buffers and RNG engines, and a per-filesystem
+// strategy cache, so repeated calls pay the setup cost only once.
+// All member functions are thread-safe; they must not be called from a worker
+// thread of the same session.
+class WipeSession {
+public:
+    explicit WipeSession(const SessionOptions& so = SessionOptions());
+    ~WipeSession();
+
+    WipeSession(const WipeSession&) = delete;
+    WipeSession& operator=(const WipeSession&) = delete;
+
+    WipeResult wipe_file(const std::string& path, const WipeOptions& opt);
+    WipeResult wipe_directory(const std::string& dir, const WipeOptions& opt, bool dry_run, bool yes);
+
+    // Wipe many files in parallel; results are returned in input order.
+    std::vector<WipeResult> wipe_batch(const std::vector<std::string>& paths, const WipeOptions& opt);
+
+    // Wipe files produced by `next` (returns false when exhausted) without
+    // materialising the list: at most max_in_flight files are queued at once
+    // (0 = 256 per worker). Failures are reported on stderr as in wipe_directory.
+    // With dry_run each file is only checked and listed, as with submit().
+    WipeResult wipe_stream(const std::function<bool(std::string&)>& next, const WipeOptions& opt,
+                           std::size_t max_in_flight = 0, bool dry_run = false);
+
+    // Non-blocking: queue a file or a whole directory and return immediately.
+    // All outstanding jobs share the session's worker pool. A directory fails
+    // unless so.recursive is set; it is then wiped without the --yes gate (the
+    // flag is the confirmation) but still passes the dangerous-directory checks.
+    // With so.dry_run a file is only checked and listed, a directory only
+    // walked and listed.
+    WipeTicket submit(const std::string& path, const WipeOptions& opt,
+                      const SubmitOptions& so = SubmitOptions());
+
+    // submit() without the dispatch, for callers that already know the kind:
+    // submit_file fails unless `path` is a regular file when it is opened;
+    // submit_directory fails unless `dir` is a directory and, without
+    // so.dry_run, `yes` is set (as wipe_directory). so.recursive is ignored.
+    WipeTicket submit_file(const std::string& path, const WipeOptions& opt,
+                           const SubmitOptions& so = SubmitOptions());
+    WipeTicket submit_directory(const std::string& dir, const WipeOptions& opt, bool yes,
+                                const SubmitOptions& so = SubmitOptions());
+
+#if defined(SECUREWIPE_HAS_COROUTINES)
+    // Awaitable forms of wipe_file / wipe_directory (C++20):
+    //   WipeResult r = co_await session.wipe_file_async(path, opt);
+    //   WipeResult r = co_await session.wipe_directory_async(dir, opt, /*yes=*/true);
+    // wipe_file_async refuses anything but a regular file. wipe_directory_async
+    // needs `yes` (or so.dry_run) like wipe_directory. Both honour so.dry_run.
+    // Without resume_on the coroutine continues on the session's worker thread
+    // until its next suspension; there it may co_await again but must not
+    // block on this session (wipe_file, WipeTicket::get, ...), which can
+    // deadlock the pool. Pass resume_on to continue on your own thread.
+    WipeAwaitable wipe_file_async(const std::string& path, const WipeOptions& opt,
+                                  const SubmitOptions& so = SubmitOptions(),
+                                  ResumeExecutor resume_on = ResumeExecutor()) {
+        return WipeAwaitable(*this, path, opt, so, std::move(resume_on));
+    }
+    WipeAwaitable wipe_directory_async(const std::string& dir, const WipeOptions& opt, bool yes,
+                                       const SubmitOptions& so = SubmitOptions(),
+                                       ResumeExecutor resume_on = ResumeExecutor()) {
+        return WipeAwaitable(*this, dir, opt, so, std::move(resume_on), true, yes);
+    }
+#endif
+
+    WipeStats stats() const;
+    unsigned threads() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+#if defined(SECUREWIPE_HAS_COROUTINES)
+inline void WipeAwaitable::await_suspend(std::coroutine_handle<> h) {
+    // The job may complete (and the coroutine resume and destroy *this) before
+    // submit() returns, so nothing below may touch members after that call.
+    SubmitOptions so = so_;
+    WipeCallback user_cb = std::move(so.on_complete);
+    so.on_complete = [this, h, user_cb](const WipeResult& r) {
+        if (user_cb) user_cb(r);
+        result_ = r;
+        if (resume_on_) resume_on_(h);
+        else h.resume();
+    };
+    if (directory_) session_.submit_directory(path_, opt_, yes_, so);
+    else session_.submit_file(path_, opt_, so);
+}
+#endif
+
+} // namespace securewipe
@@ -0,0 +1,86 @@
+#ifndef SECURE_WIPE_C_H
+#define SECURE_WIPE_C_H
+/* Stable C ABI over WipeSession for embedding from C, Go, Rust, ...
+ * All handles are opaque; all structs are plain data owned by the caller. */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(SECUREWIPE_BUILD)
+#define SW_API __declspec(dllexport)
+#elif defined(__GNUC__) && defined(SECUREWIPE_BUILD)
+#define SW_API __attribute__((visibility("default")))
+#else
+#define SW_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped on any incompatible change to the declarations below. */
+#define SW_ABI_VERSION 1
+
+typedef struct sw_session sw_session;
+typedef uint64_t sw_job_id;    /* 0 is never a valid job */
+
+enum {
+    SW_PATTERN_ZEROS = 0,
+    SW_PATTERN_RANDOM = 1
+};
+
+enum {
+    SW_SUBMIT_DRY_RUN = 1u << 0,  /* list instead of wiping; files and directories are left untouched */
+    SW_SUBMIT_DIRECTORY = 1u << 1 /* allow a directory target and wipe it recursively */
+};
+
+typedef struct sw_options {
+    int32_t passes;
+    int32_t pattern;               /* SW_PATTERN_* */
+    uint64_t block_size;
+    uint32_t flags;                /* SW_SUBMIT_* */
+    uint32_t timeout_ms;           /* per-job deadline from submission; 0 = none */
+} sw_options;
+
+typedef struct sw_completion {
+    sw_job_id job;
+    int32_t ok;                    /* 1 on success */
+    char message[256];             /* NUL-terminated, truncated if longer */
+} sw_completion;
+
+typedef struct sw_stats {
+    uint64_t files_wiped;
+    uint64_t files_failed;
+    uint64_t bytes_overwritten;
+    uint64_t jobs_pending;         /* submitted but not yet polled as complete */
+} sw_stats;
+
+SW_API uint32_t sw_abi_version(void);
+
+/* Fill *opt with the library defaults. */
+SW_API void sw_options_init(sw_options* opt);
+
+/* threads = 0 uses one worker per CPU. Returns NULL on failure. */
+SW_API sw_session* sw_session_create(uint32_t threads);
+
+/* Waits for outstanding jobs, then frees the session. */
+SW_API void sw_session_destroy(sw_session* s);
+
+/* Queue a file, or a directory if opt->flags has SW_SUBMIT_DIRECTORY.
+ * opt may be NULL for defaults. Returns 0 on error, including a directory
+ * submitted without SW_SUBMIT_DIRECTORY. */
+SW_API sw_job_id sw_submit(sw_session* s, const char* path, const sw_options* opt);
+
+/* Request cancellation. Returns 1 if the job was still pending. */
+SW_API int sw_cancel(sw_session* s, sw_job_id job);
+
+/* Retrieve up to max finished jobs. timeout_ms: 0 = don't wait, -1 = wait for
+ * at least one. Returns the number of entries written to out. */
+SW_API int sw_poll(sw_session* s, sw_completion* out, int max, int timeout_ms);
+
+SW_API void sw_get_stats(sw_session* s, sw_stats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECURE_WIPE_C_H */
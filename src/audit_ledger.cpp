@@ -0,0 +1,380 @@
+#include "audit_ledger.h"
+#include "blake2b.h"
+#include "line_json.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/file.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+namespace {
+
+constexpr const char* kMagic = "securewipe-audit";
+constexpr std::size_t kMaxBatch = 8192;             // records per seal
+constexpr std::size_t kMaxQueued = 4 * kMaxBatch;   // producers wait beyond this
+constexpr std::size_t kTailChunk = 1 << 20;
+
+// Push buffered data of `f` to stable storage.
+bool sync_file(std::FILE* f) {
+    if (std::fflush(f) != 0) return false;
+#if defined(__linux__)
+    return ::fdatasync(::fileno(f)) == 0;
+#elif defined(__unix__) || defined(__APPLE__)
+    return ::fsync(::fileno(f)) == 0;
+#elif defined(_WIN32)
+    return ::_commit(::_fileno(f)) == 0;
+#else
+    return true;
+#endif
+}
+
+bool from_hex(const std::string& s, unsigned char* out, std::size_t n) {
+    if (s.size() != 2 * n) return false;
+    for (std::size_t i = 0; i < 2 * n; ++i) {
+        const char c = s[i];
+        int v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else return false;
+        out[i / 2] = static_cast<unsigned char>((i % 2) ? (out[i / 2] | v) : (v << 4));
+    }
+    return true;
+}
+
+bool is_header(const std::string& line) {
+    JsonObject o;
+    std::string err;
+    return o.parse(line, err) && o.get_string("ledger") == kMagic && o.get_int("version") == 1;
+}
+
+bool is_seal(const std::string& line) {
+    return line.compare(0, 9, "{\"batch\":") == 0;
+}
+
+// Seal line without its hash, and the hash it must carry.
+bool split_seal(const std::string& line, std::string& prefix, std::string& hash) {
+    const std::size_t at = line.rfind(",\"hash\":\"");
+    if (at == std::string::npos || line.size() != at + 9 + 64 + 2 || line.compare(line.size() - 2, 2, "\"}") != 0) {
+        return false;
+    }
+    prefix = line.substr(0, at);
+    hash = line.substr(at + 9, 64);
+    return true;
+}
+
+void hash_line(const std::string& line, unsigned char out[32]) {
+    Blake2b h(32);
+    h.update(line);
+    h.update("\n", 1);
+    h.final(out);
+}
+
+std::mutex g_registry_mu;
+std::map<std::string, std::weak_ptr<AuditLedger>> g_registry;
+
+} // namespace
+
+std::int64_t unix_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+std::shared_ptr<AuditLedger> AuditLedger::open(const LedgerOptions& lo, std::string& err) {
+    std::error_code ec;
+    const std::string key = fs::absolute(lo.path, ec).lexically_normal().string();
+    std::lock_guard<std::mutex> lk(g_registry_mu);
+    auto it = g_registry.find(key);
+    if (it != g_registry.end()) {
+        if (auto l = it->second.lock()) return l;
+    }
+
+    std::unique_ptr<AuditLedger> l(new AuditLedger);
+    l->commit_every_ = std::chrono::milliseconds(lo.commit_ms);
+    l->cwd_ = fs::current_path(ec);
+    if (!l->load(lo.path, err)) return nullptr;
+    l->writer_ = std::thread([p = l.get()] { p->run(); });
+    // Released under the registry lock, so that a re-open waits for the
+    // last batch and the file lock.
+    std::shared_ptr<AuditLedger> sp(l.release(), [key](AuditLedger* p) {
+        std::lock_guard<std::mutex> rl(g_registry_mu);
+        delete p;
+        auto e = g_registry.find(key);
+        if (e != g_registry.end() && e->second.expired()) g_registry.erase(e);
+    });
+    g_registry[key] = sp;
+    return sp;
+}
+
+bool AuditLedger::load(const std::string& path, std::string& err) {
+    f_ = std::fopen(path.c_str(), "ab");
+    if (!f_) {
+        err = "Cannot open ledger " + path + ": " + std::strerror(errno);
+        return false;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    if (::flock(::fileno(f_), LOCK_EX | LOCK_NB) != 0) {
+        err = "Ledger " + path + " is in use by another process";
+        return false;
+    }
+#endif
+    std::error_code ec;
+    const std::uint64_t size = fs::file_size(path, ec);
+    if (ec) {
+        err = "Cannot read ledger " + path + ": " + ec.message();
+        return false;
+    }
+    if (size == 0) {
+        const std::string header =
+            JsonWriter().add("ledger", kMagic).add("version", 1).add("created", unix_ms()).str();
+        hash_line(header, prev_);
+        if (std::fprintf(f_, "%s\n", header.c_str()) < 0 || !sync_file(f_)) {
+            err = "Cannot write ledger " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    std::string header;
+    if (!std::getline(in, header) || in.eof() || !is_header(header)) {
+        err = path + " is not a securewipe ledger";
+        return false;
+    }
+    // The chain continues from the last complete seal, found from the end.
+    std::string tail;
+    std::uint64_t pos = size;
+    std::uint64_t end = header.size() + 1;
+    std::string seal;
+    while (seal.empty()) {
+        for (std::size_t at = tail.rfind("\n{\"batch\":"); at != std::string::npos;
+             at = at == 0 ? std::string::npos : tail.rfind("\n{\"batch\":", at - 1)) {
+            const std::size_t nl = tail.find('\n', at + 1);
+            if (nl == std::string::npos) continue;
+            seal = tail.substr(at + 1, nl - at - 1);
+            end = pos + nl + 1;
+            break;
+        }
+        if (!seal.empty() || pos <= header.size()) break;
+        const std::uint64_t n = std::min<std::uint64_t>(pos, kTailChunk);
+        pos -= n;
+        std::string chunk(static_cast<std::size_t>(n), '\0');
+        in.clear();
+        in.seekg(static_cast<std::streamoff>(pos));
+        if (!in.read(&chunk[0], static_cast<std::streamsize>(n))) {
+            err = "Cannot read ledger " + path;
+            return false;
+        }
+        tail.insert(0, chunk);
+    }
+
+    if (seal.empty()) {
+        hash_line(header, prev_);
+    } else {
+        JsonObject o;
+        std::string prefix, hash;
+        if (!split_seal(seal, prefix, hash) || !o.parse(seal, err) || !from_hex(hash, prev_, sizeof prev_)) {
+            err = path + ": damaged seal at the end of the ledger; check it with ledger-verify";
+            return false;
+        }
+        batch_ = o.get_uint("batch") + 1;
+        written_seq_ = o.get_uint("first") + o.get_uint("records") - 1;
+    }
+    // Drop a batch torn by a crash: it was never committed.
+    if (end < size) {
+        fs::resize_file(path, end, ec);
+        if (ec) {
+            err = "Cannot truncate the torn tail of ledger " + path + ": " + ec.message();
+            return false;
+        }
+    }
+    queued_seq_ = synced_seq_ = written_seq_;
+    return true;
+}
+
+AuditLedger::~AuditLedger() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+    if (f_) std::fclose(f_);    // also releases the lock
+}
+
+void AuditLedger::record(const std::string& path, LedgerEntry&& e) {
+    Item item{path, std::move(e)};
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [&] { return queue_.size() < kMaxQueued; });
+    queue_.push_back(std::move(item));
+    ++queued_seq_;
+    if (queue_.size() == 1 || queue_.size() >= kMaxBatch) cv_.notify_all();
+}
+
+bool AuditLedger::commit(std::string& err) {
+    std::unique_lock<std::mutex> lk(mu_);
+    const std::uint64_t target = queued_seq_;
+    ++waiters_;
+    cv_.notify_all();
+    cv_.wait(lk, [&] { return synced_seq_ >= target; });
+    --waiters_;
+    if (!error_.empty()) {
+        err = error_;
+        return false;
+    }
+    return true;
+}
+
+void AuditLedger::run() {
+    std::unique_lock<std::mutex> lk(mu_);
+    for (;;) {
+        cv_.wait(lk, [&] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) return;
+        // Group commit: gather records for a while unless someone waits.
+        cv_.wait_for(lk, commit_every_, [&] { return stopping_ || waiters_ > 0 || queue_.size() >= kMaxBatch; });
+        std::deque<Item> batch;
+        if (queue_.size() <= kMaxBatch) {
+            batch.swap(queue_);
+        } else {
+            batch.insert(batch.end(), std::make_move_iterator(queue_.begin()),
+                         std::make_move_iterator(queue_.begin() + kMaxBatch));
+            queue_.erase(queue_.begin(), queue_.begin() + kMaxBatch);
+        }
+        const bool failed = !error_.empty();
+        cv_.notify_all();   // room for producers
+        lk.unlock();
+        std::string err;
+        // After a write error nothing more is appended: the chain would not
+        // continue from what is on disk.
+        const bool ok = failed || write_batch(batch, err);
+        lk.lock();
+        if (!ok) error_ = err;
+        synced_seq_ += batch.size();
+        cv_.notify_all();
+    }
+}
+
+bool AuditLedger::write_batch(std::deque<Item>& items, std::string& err) {
+    static const char* const schemes[] = {"zeros", "random"};
+    const std::uint64_t first = written_seq_ + 1;
+    std::string out;
+    out.reserve(items.size() * 256);
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const LedgerEntry& e = items[i].e;
+        JsonWriter w;
+        w.add("seq", first + i)
+            .add("path", Blake2b::hex_digest((cwd_ / items[i].path).lexically_normal().string(), 16))
+            .add("action", e.action)
+            .add("size", e.size)
+            .add("offset", e.offset)
+            .add("length", e.length)
+            .add("scheme", schemes[e.pattern == Pattern::Random ? 1 : 0])
+            .add("passes", e.passes)
+            .add("ok", e.ok);
+        if (!e.ok) w.add("error", e.error);
+        w.add("started", e.started_ms).add("finished", e.finished_ms);
+        out += w.str();
+        out += '\n';
+    }
+    std::string seal = JsonWriter()
+                           .add("batch", batch_)
+                           .add("first", first)
+                           .add("records", static_cast<std::uint64_t>(items.size()))
+                           .add("prev", to_hex(prev_, sizeof prev_))
+                           .add("time", unix_ms())
+                           .str();
+    seal.pop_back();    // the hash goes inside the object
+    Blake2b h(32);
+    h.update(prev_, sizeof prev_);
+    h.update(out);
+    h.update(seal);
+    h.final(prev_);
+    out += seal + ",\"hash\":\"" + to_hex(prev_, sizeof prev_) + "\"}\n";
+
+    if (std::fwrite(out.data(), 1, out.size(), f_) != out.size() || !sync_file(f_)) {
+        err = std::string("Ledger write failed: ") + std::strerror(errno);
+        return false;
+    }
+    ++batch_;
+    written_seq_ += items.size();
+    return true;
+}
+
+WipeResult verify_ledger(const std::string& path) {
+    WipeResult r;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        r.message = "Cannot open ledger " + path;
+        return r;
+    }
+    std::string line;
+    if (!std::getline(in, line) || !is_header(line)) {
+        r.message = path + " is not a securewipe ledger";
+        return r;
+    }
+    unsigned char prev[32];
+    hash_line(line, prev);
+
+    std::uint64_t lineno = 1, batch = 1, seq = 0, sealed = 0, pending = 0;
+    Blake2b h(32);
+    h.update(prev, sizeof prev);
+    auto fail = [&](const std::string& why) {
+        r.ok = false;
+        r.message = path + ":" + std::to_string(lineno) + ": " + why + " (" + std::to_string(sealed) +
+                    " records in " + std::to_string(batch - 1) + " batches verified before it)";
+        return r;
+    };
+    while (std::getline(in, line)) {
+        ++lineno;
+        if (in.eof()) return fail("incomplete last line");
+        if (!is_seal(line)) {
+            // A record: only its sequence number is checked, the hash covers the rest.
+            if (line.compare(0, 7, "{\"seq\":") != 0) return fail("not a ledger record");
+            char* endp = nullptr;
+            const std::uint64_t n = std::strtoull(line.c_str() + 7, &endp, 10);
+            if (n != seq + 1) return fail("record " + std::to_string(n) + " out of sequence");
+            seq = n;
+            h.update(line);
+            h.update("\n", 1);
+            ++pending;
+            continue;
+        }
+        std::string prefix, hash, err;
+        JsonObject o;
+        if (!split_seal(line, prefix, hash) || !o.parse(line, err)) return fail("malformed seal");
+        if (o.get_uint("batch") != batch) return fail("seal of batch " + std::to_string(o.get_uint("batch")) +
+                                                      " where batch " + std::to_string(batch) + " was expected");
+        if (o.get_uint("records") != pending || o.get_uint("first") != seq - pending + 1) {
+            return fail("seal does not cover the records before it");
+        }
+        if (o.get_string("prev") != to_hex(prev, sizeof prev)) return fail("chain broken: previous hash differs");
+        h.update(prefix);
+        h.final(prev);
+        if (to_hex(prev, sizeof prev) != hash) return fail("hash mismatch: batch " + std::to_string(batch) + " was altered");
+        h = Blake2b(32);
+        h.update(prev, sizeof prev);
+        sealed += pending;
+        pending = 0;
+        ++batch;
+    }
+    if (pending > 0) return fail(std::to_string(pending) + " record(s) after the last seal");
+    r.ok = true;
+    r.message = "Ledger intact: " + std::to_string(sealed) + " records in " + std::to_string(batch - 1) +
+                " batches; head " + to_hex(prev, sizeof prev);
+    return r;
+}
+
+} // namespace securewipe
@@ -0,0 +1,99 @@
+#pragma once
+// Tamper-evident audit ledger: one record per file a job overwrites.
+//
+// An append-only text file with one JSON object per line:
+//   {"ledger":"securewipe-audit","version":1,"created":MS}         header
+//   {"seq":N,"path":H,"action":A,"size":..,...,"finished":MS}      record
+//   {"batch":B,"first":N,"records":n,"prev":P,"time":MS,"hash":X}  seal
+// Workers only queue records; a writer thread appends everything queued as
+// one batch followed by its seal, in one write and one sync (group commit,
+// at most every commit_ms). X is BLAKE2b-256 over P (the previous seal's
+// hash, or the header line's for the first batch), the batch's record lines
+// and the seal line up to its "hash" field, so changing, dropping,
+// reordering or inserting any line breaks the chain from that batch on.
+// verify_ledger() walks the chain and reports the final hash; kept
+// elsewhere, it also exposes truncation or a rewritten file.
+//
+// Paths are recorded as BLAKE2b-128 of the absolute path: the ledger can
+// confirm that a given file was wiped without listing names. Lines after
+// the last seal (a batch torn by a crash, never reported as committed) are
+// cut off when the ledger is next opened for writing.
+#include "secure_wipe.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace securewipe {
+
+struct LedgerEntry {
+    const char* action = "wipe";    // "wipe", "range" (overwritten in place), "unlink" (further hard link)
+    std::uint64_t size = 0;         // file size
+    std::uint64_t offset = 0;       // overwritten bytes, per pass
+    std::uint64_t length = 0;
+    int passes = 0;
+    Pattern pattern = Pattern::Zeros;
+    bool ok = false;
+    std::string error;
+    std::int64_t started_ms = 0;    // Unix time
+    std::int64_t finished_ms = 0;
+};
+
+class AuditLedger {
+public:
+    // One instance per file and process, shared by every job using it; the
+    // file is locked against other processes while open.
+    static std::shared_ptr<AuditLedger> open(const LedgerOptions& lo, std::string& err);
+    ~AuditLedger();     // commits what is queued
+    AuditLedger(const AuditLedger&) = delete;
+    AuditLedger& operator=(const AuditLedger&) = delete;
+
+    // Queue a record for `path`; cheap, never blocks on I/O.
+    void record(const std::string& path, LedgerEntry&& e);
+    // Wait until every record queued so far is synced. False after a write
+    // error, with its message in `err`.
+    bool commit(std::string& err);
+
+private:
+    struct Item {
+        std::string path;   // made absolute by the writer
+        LedgerEntry e;
+    };
+
+    AuditLedger() = default;
+    bool load(const std::string& path, std::string& err);
+    void run();
+    bool write_batch(std::deque<Item>& items, std::string& err);
+
+    std::FILE* f_ = nullptr;
+    std::chrono::milliseconds commit_every_{0};
+    std::filesystem::path cwd_;     // relative paths are recorded against it
+    unsigned char prev_[32] = {};   // hash of the last seal (or of the header)
+    std::uint64_t batch_ = 1;       // next batch number
+    std::uint64_t written_seq_ = 0; // last sequence number in the file
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<Item> queue_;
+    std::uint64_t queued_seq_ = 0;  // last sequence number handed out
+    std::uint64_t synced_seq_ = 0;  // last one on disk
+    unsigned waiters_ = 0;          // commit() callers: write now
+    bool stopping_ = false;
+    std::string error_;
+    std::thread writer_;
+};
+
+// Milliseconds since the Unix epoch.
+std::int64_t unix_ms();
+
+// Check the hash chain of the ledger at `path`. On success the message
+// gives the record and batch counts and the final hash.
+WipeResult verify_ledger(const std::string& path);
+
+} // namespace securewipe
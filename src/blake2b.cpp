@@ -0,0 +1,211 @@
+#include "blake2b.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SECUREWIPE_BLAKE2B_AVX2 1
+#endif
+
+namespace securewipe {
+
+namespace {
+
+const std::uint64_t kIV[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+};
+
+const unsigned char kSigma[12][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+};
+
+std::uint64_t load64(const unsigned char* p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+#else
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+#endif
+}
+
+std::uint64_t rotr(std::uint64_t x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+void compress_portable(std::uint64_t h[8], const std::uint64_t m[16], std::uint64_t t0, std::uint64_t t1,
+                       bool last) {
+    std::uint64_t v[16];
+    for (int i = 0; i < 8; ++i) {
+        v[i] = h[i];
+        v[i + 8] = kIV[i];
+    }
+    v[12] ^= t0;
+    v[13] ^= t1;
+    if (last) v[14] = ~v[14];
+
+    auto g = [&](int a, int b, int c, int d, std::uint64_t x, std::uint64_t y) {
+        v[a] = v[a] + v[b] + x;
+        v[d] = rotr(v[d] ^ v[a], 32);
+        v[c] = v[c] + v[d];
+        v[b] = rotr(v[b] ^ v[c], 24);
+        v[a] = v[a] + v[b] + y;
+        v[d] = rotr(v[d] ^ v[a], 16);
+        v[c] = v[c] + v[d];
+        v[b] = rotr(v[b] ^ v[c], 63);
+    };
+    for (const auto& s : kSigma) {
+        g(0, 4, 8, 12, m[s[0]], m[s[1]]);
+        g(1, 5, 9, 13, m[s[2]], m[s[3]]);
+        g(2, 6, 10, 14, m[s[4]], m[s[5]]);
+        g(3, 7, 11, 15, m[s[6]], m[s[7]]);
+        g(0, 5, 10, 15, m[s[8]], m[s[9]]);
+        g(1, 6, 11, 12, m[s[10]], m[s[11]]);
+        g(2, 7, 8, 13, m[s[12]], m[s[13]]);
+        g(3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (int i = 0; i < 8; ++i) h[i] ^= v[i] ^ v[i + 8];
+}
+
+#if defined(SECUREWIPE_BLAKE2B_AVX2)
+// Row i of the 4x4 state in one register; a round is G on the four columns,
+// then (after rotating rows b, c, d into place) on the four diagonals.
+__attribute__((target("avx2"))) void compress_avx2(std::uint64_t h[8], const std::uint64_t m[16], std::uint64_t t0,
+                                                   std::uint64_t t1, bool last) {
+    const __m256i rot24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+                                           3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    const __m256i rot16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                           2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    const __m256i h0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h));
+    const __m256i h1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + 4));
+    __m256i a = h0;
+    __m256i b = h1;
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kIV));
+    __m256i d = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(kIV + 4)),
+                                 _mm256_set_epi64x(0, last ? -1 : 0, static_cast<long long>(t1),
+                                                   static_cast<long long>(t0)));
+
+// Lambdas would not inherit the target attribute, hence macros.
+#define SW_WORDS(s) _mm256_set_epi64x(static_cast<long long>(m[(s)[6]]), static_cast<long long>(m[(s)[4]]), \
+                                      static_cast<long long>(m[(s)[2]]), static_cast<long long>(m[(s)[0]]))
+#define SW_G1(x)                                                                   \
+    a = _mm256_add_epi64(_mm256_add_epi64(a, b), x);                               \
+    d = _mm256_shuffle_epi32(_mm256_xor_si256(d, a), _MM_SHUFFLE(2, 3, 0, 1));     \
+    c = _mm256_add_epi64(c, d);                                                    \
+    b = _mm256_shuffle_epi8(_mm256_xor_si256(b, c), rot24)
+#define SW_G2(y)                                                                   \
+    a = _mm256_add_epi64(_mm256_add_epi64(a, b), y);                               \
+    d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16);                        \
+    c = _mm256_add_epi64(c, d);                                                    \
+    b = _mm256_xor_si256(b, c);                                                    \
+    b = _mm256_or_si256(_mm256_srli_epi64(b, 63), _mm256_add_epi64(b, b))
+    for (const auto& s : kSigma) {
+        SW_G1(SW_WORDS(s));
+        SW_G2(SW_WORDS(s + 1));
+        b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1));
+        c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2));
+        d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3));
+        SW_G1(SW_WORDS(s + 8));
+        SW_G2(SW_WORDS(s + 9));
+        b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3));
+        c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2));
+        d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1));
+    }
+#undef SW_G2
+#undef SW_G1
+#undef SW_WORDS
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(h), _mm256_xor_si256(h0, _mm256_xor_si256(a, c)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(h + 4), _mm256_xor_si256(h1, _mm256_xor_si256(b, d)));
+}
+
+const bool g_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+} // namespace
+
+Blake2b::Blake2b(std::size_t digest_len) : digest_len_(std::min<std::size_t>(std::max<std::size_t>(digest_len, 1), kMaxDigest)) {
+    std::memcpy(h_, kIV, sizeof h_);
+    h_[0] ^= 0x01010000ULL ^ digest_len_;
+}
+
+void Blake2b::compress(const unsigned char* block, bool last) {
+    std::uint64_t m[16];
+    for (int i = 0; i < 16; ++i) m[i] = load64(block + 8 * i);
+#if defined(SECUREWIPE_BLAKE2B_AVX2)
+    if (g_avx2) {
+        compress_avx2(h_, m, t_[0], t_[1], last);
+        return;
+    }
+#endif
+    compress_portable(h_, m, t_[0], t_[1], last);
+}
+
+void Blake2b::update(const void* data, std::size_t n) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    // The final block is compressed by final(), so a full buffer is only
+    // flushed once more input arrives.
+    while (n > 0) {
+        if (buf_len_ == sizeof buf_) {
+            t_[0] += sizeof buf_;
+            if (t_[0] < sizeof buf_) ++t_[1];
+            compress(buf_, false);
+            buf_len_ = 0;
+        }
+        if (buf_len_ == 0) {
+            while (n > sizeof buf_) {
+                t_[0] += sizeof buf_;
+                if (t_[0] < sizeof buf_) ++t_[1];
+                compress(p, false);
+                p += sizeof buf_;
+                n -= sizeof buf_;
+            }
+        }
+        const std::size_t take = std::min(n, sizeof buf_ - buf_len_);
+        std::memcpy(buf_ + buf_len_, p, take);
+        buf_len_ += take;
+        p += take;
+        n -= take;
+    }
+}
+
+void Blake2b::final(unsigned char* out) {
+    t_[0] += buf_len_;
+    if (t_[0] < buf_len_) ++t_[1];
+    std::memset(buf_ + buf_len_, 0, sizeof buf_ - buf_len_);
+    compress(buf_, true);
+    for (std::size_t i = 0; i < digest_len_; ++i) out[i] = static_cast<unsigned char>(h_[i / 8] >> (8 * (i % 8)));
+}
+
+std::string Blake2b::hex_digest(const std::string& s, std::size_t digest_len) {
+    Blake2b b(digest_len);
+    b.update(s);
+    unsigned char out[kMaxDigest];
+    b.final(out);
+    return to_hex(out, b.digest_len_);
+}
+
+std::string to_hex(const unsigned char* p, std::size_t n) {
+    static const char digits[] = "0123456789abcdef";
+    std::string s(2 * n, '0');
+    for (std::size_t i = 0; i < n; ++i) {
+        s[2 * i] = digits[p[i] >> 4];
+        s[2 * i + 1] = digits[p[i] & 15];
+    }
+    return s;
+}
+
+} // namespace securewipe
@@ -0,0 +1,41 @@
+#pragma once
+// BLAKE2b (RFC 7693), unkeyed, for the audit ledger's hash chain and path
+// hashes. On x86-64 with GCC or Clang the compression function runs on AVX2
+// when the CPU has it (the four columns, then the four diagonals, of the
+// state in one 256-bit register per row); elsewhere it is the portable
+// 64-bit version. Both produce identical digests.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace securewipe {
+
+class Blake2b {
+public:
+    static constexpr std::size_t kMaxDigest = 64;
+
+    // Digest of `digest_len` bytes (1..64).
+    explicit Blake2b(std::size_t digest_len = 32);
+
+    void update(const void* data, std::size_t n);
+    void update(const std::string& s) { update(s.data(), s.size()); }
+    // Writes digest_len bytes; the object must not be updated afterwards.
+    void final(unsigned char* out);
+
+    // One-shot digest as lowercase hex.
+    static std::string hex_digest(const std::string& s, std::size_t digest_len = 32);
+
+private:
+    void compress(const unsigned char* block, bool last);
+
+    std::uint64_t h_[8];
+    std::uint64_t t_[2] = {0, 0};
+    unsigned char buf_[128];
+    std::size_t buf_len_ = 0;
+    std::size_t digest_len_;
+};
+
+// Lowercase hex of `n` bytes.
+std::string to_hex(const unsigned char* p, std::size_t n);
+
+} // namespace securewipe
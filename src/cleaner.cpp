@@ -0,0 +1,390 @@
+#include "cleaner.h"
+#include "output_sink.h"
+#include "path_filter.h"
+#include "protect.h"
+#include "tree_walk.h"
+#include "wipe_engine.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+static std::string trim(const std::string& s) {
+    const std::size_t b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return std::string();
+    const std::size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// Backslash-escape glob metacharacters so `s` matches literally.
+static std::string glob_escape(const std::string& s) {
+    std::string out;
+    for (const char c : s) {
+        if (c == '*' || c == '?' || c == '[' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+// "~/x", "$HOME/x", "${XDG_CACHE_HOME}/x". False if a variable is unset or empty.
+static bool expand_root(const std::string& in, std::string& out) {
+    out.clear();
+    std::size_t i = 0;
+    if (!in.empty() && in[0] == '~' && (in.size() == 1 || in[1] == '/')) {
+        const char* home = std::getenv("HOME");
+        if (!home || !*home) return false;
+        out = home;
+        i = 1;
+    }
+    while (i < in.size()) {
+        if (in[i] != '$') {
+            out.push_back(in[i++]);
+            continue;
+        }
+        std::string name;
+        if (i + 1 < in.size() && in[i + 1] == '{') {
+            const std::size_t close = in.find('}', i + 2);
+            if (close == std::string::npos) return false;
+            name = in.substr(i + 2, close - i - 2);
+            i = close + 1;
+        } else {
+            std::size_t j = i + 1;
+            while (j < in.size() && (std::isalnum(static_cast<unsigned char>(in[j])) || in[j] == '_')) ++j;
+            name = in.substr(i + 1, j - i - 1);
+            i = j;
+        }
+        const char* v = name.empty() ? nullptr : std::getenv(name.c_str());
+        if (!v || !*v) return false;
+        out += v;
+    }
+    return !out.empty();
+}
+
+bool load_rule_pack(const std::string& path, RulePack& pack, std::string& err) {
+    std::ifstream in(path);
+    if (!in) {
+        err = "Cannot open rule pack: " + path;
+        return false;
+    }
+
+    std::set<std::string> ids;
+    for (const auto& c : pack.cleaners) ids.insert(c.id);
+
+    CleanerRule* cur = nullptr;
+    std::string line;
+    unsigned lineno = 0;
+    auto fail = [&](const std::string& why) {
+        err = path + ":" + std::to_string(lineno) + ": " + why;
+        return false;
+    };
+
+    while (std::getline(in, line)) {
+        ++lineno;
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+
+        if (line[0] == '[') {
+            if (line.back() != ']' || line.size() < 3) return fail("bad section header");
+            const std::string id = trim(line.substr(1, line.size() - 2));
+            if (!ids.insert(id).second) return fail("duplicate cleaner id: " + id);
+            pack.cleaners.emplace_back();
+            cur = &pack.cleaners.back();
+            cur->id = id;
+            continue;
+        }
+
+        const std::size_t eq = line.find('=');
+        if (eq == std::string::npos) return fail("expected key = value");
+        const std::string key = trim(line.substr(0, eq));
+        const std::string val = trim(line.substr(eq + 1));
+        if (val.empty()) return fail("empty value for " + key);
+
+        if (!cur) {
+            if (key != "exclude") return fail("only 'exclude' is allowed before the first [cleaner]");
+            pack.exclude.push_back(val);
+            continue;
+        }
+
+        if (key == "description") {
+            cur->description = val;
+        } else if (key == "root") {
+            cur->roots.push_back(val);
+        } else if (key == "include") {
+            cur->include.push_back(val);
+        } else if (key == "file") {
+            cur->include.push_back("/" + glob_escape(val));
+        } else if (key == "older-than") {
+            if (!parse_duration(val, cur->opt.filter.mtime_older_than)) return fail("bad duration: " + val);
+        } else if (key == "min-size") {
+            if (!parse_size(val, cur->opt.filter.min_size)) return fail("bad size: " + val);
+        } else if (key == "max-size") {
+            if (!parse_size(val, cur->opt.filter.max_size)) return fail("bad size: " + val);
+        } else if (key == "passes") {
+            try {
+                cur->opt.passes = std::stoi(val);
+            } catch (...) {
+                return fail("bad passes: " + val);
+            }
+        } else if (key == "pattern") {
+            if (val == "zeros") cur->opt.pattern = Pattern::Zeros;
+            else if (val == "random") cur->opt.pattern = Pattern::Random;
+            else return fail("unknown pattern: " + val);
+        } else if (key == "enabled") {
+            if (val == "true" || val == "yes" || val == "1") cur->enabled = true;
+            else if (val == "false" || val == "no" || val == "0") cur->enabled = false;
+            else return fail("bad boolean: " + val);
+        } else {
+            return fail("unknown key: " + key);
+        }
+    }
+
+    for (const auto& c : pack.cleaners) {
+        if (c.roots.empty() || c.include.empty()) {
+            err = path + ": cleaner [" + c.id + "] needs at least one root and one include or file";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Is `p` equal to or below `root`? Both are normalized absolute paths.
+static bool is_under(const fs::path& p, const fs::path& root) {
+    auto pi = p.begin();
+    for (auto ri = root.begin(); ri != root.end(); ++ri, ++pi) {
+        if (ri->empty()) continue;      // trailing separator
+        if (pi == p.end() || *pi != *ri) return false;
+    }
+    return true;
+}
+
+// Re-anchor a root-relative pattern under `rel` (the cleaner's root relative
+// to the walk root).
+static std::string reanchor(const std::string& pat, const fs::path& rel) {
+    if (rel.empty() || rel == ".") return pat;
+    std::string prefix = "/";
+    for (const auto& part : rel) prefix += glob_escape(part.string()) + "/";
+
+    // Same anchoring rule as PathFilter: a leading or inner '/' anchors.
+    if (!pat.empty() && pat[0] == '/') return prefix + pat.substr(1);
+    const std::size_t end = pat.find_last_not_of('/');
+    if (end != std::string::npos && pat.find('/') < end) return prefix + pat;
+    return prefix + "**/" + pat;
+}
+
+std::string describe_rule_pack(const RulePack& pack) {
+    std::string out;
+    for (const auto& c : pack.cleaners) {
+        out += (c.enabled ? "  [x] " : "  [ ] ") + c.id;
+        if (!c.description.empty()) out += " - " + c.description;
+        out += "\n";
+        for (const auto& r : c.roots) {
+            std::string x;
+            out += "        " + r;
+            if (!expand_root(r, x)) out += "  (unset)";
+            else if (x != r) out += "  -> " + x;
+            out += "\n";
+        }
+    }
+    return out;
+}
+
+WipeResult run_clean(WipeSession& session, const RulePack& pack, const CleanOptions& co) {
+    WipeResult r;
+
+    // Selected cleaners: the --only list (which may name disabled ones), else all enabled.
+    std::vector<std::size_t> selected;
+    for (const auto& id : co.only) {
+        auto it = std::find_if(pack.cleaners.begin(), pack.cleaners.end(),
+                               [&](const CleanerRule& c) { return c.id == id; });
+        if (it == pack.cleaners.end()) {
+            r.message = "Unknown cleaner: " + id;
+            return r;
+        }
+        selected.push_back(static_cast<std::size_t>(it - pack.cleaners.begin()));
+    }
+    if (co.only.empty()) {
+        for (std::size_t i = 0; i < pack.cleaners.size(); ++i) {
+            if (pack.cleaners[i].enabled) selected.push_back(i);
+        }
+    }
+    std::sort(selected.begin(), selected.end());
+    selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+
+    // Expand roots; keep those that exist.
+    struct RootUse {
+        fs::path root;
+        std::size_t cleaner;
+    };
+    std::vector<RootUse> uses;
+    for (const std::size_t ci : selected) {
+        for (const auto& raw : pack.cleaners[ci].roots) {
+            std::string expanded;
+            if (!expand_root(raw, expanded)) continue;
+            std::error_code ec;
+            fs::path canon = fs::weakly_canonical(fs::absolute(expanded, ec), ec);
+            if (ec || !fs::is_directory(canon, ec)) continue;
+            // Held to the same dangerous/protected-directory rules as wipe-dir.
+            const WipeResult chk = detail::check_directory_target(canon.string(), true, true, co.protect);
+            if (!chk.ok) {
+                r.message = "Refusing cleaner root [" + pack.cleaners[ci].id + "] " + raw + ": " + chk.message;
+                return r;
+            }
+            uses.push_back(RootUse{canon, ci});
+        }
+    }
+
+    // Merge nested roots: every root below another one is walked as part of it.
+    std::vector<fs::path> walk_roots;
+    {
+        std::vector<fs::path> all;
+        for (const auto& u : uses) all.push_back(u.root);
+        std::sort(all.begin(), all.end(), [](const fs::path& a, const fs::path& b) {
+            return std::distance(a.begin(), a.end()) < std::distance(b.begin(), b.end());
+        });
+        for (const auto& p : all) {
+            bool nested = false;
+            for (const auto& w : walk_roots) {
+                if (is_under(p, w)) {
+                    nested = true;
+                    break;
+                }
+            }
+            if (!nested) walk_roots.push_back(p);
+        }
+    }
+
+    // Per-cleaner predicates (age, size), checked after the tagged match.
+    std::vector<PathFilter> preds(pack.cleaners.size());
+    for (const std::size_t ci : selected) {
+        FilterRules fr = pack.cleaners[ci].opt.filter;
+        fr.include.clear();
+        fr.exclude.clear();
+        std::string err;
+        if (!preds[ci].compile(fr, err)) {
+            r.message = "[" + pack.cleaners[ci].id + "] " + err;
+            return r;
+        }
+    }
+
+    std::vector<std::vector<std::string>> files(pack.cleaners.size());
+    std::vector<std::uint64_t> planned_bytes(pack.cleaners.size(), 0);
+    const std::int64_t now = static_cast<std::int64_t>(std::time(nullptr));
+
+    const auto protect = ProtectedPaths::get(co.protect);
+    std::uint64_t protected_skipped = 0;
+
+    for (const auto& w : walk_roots) {
+        PathFilter filter;
+        FilterRules shared;
+        shared.exclude = pack.exclude;
+        std::string err;
+        if (!filter.compile(shared, err)) {
+            r.message = err;
+            return r;
+        }
+        // Cleaners are added in pack order, so the first cleaner's rule wins a tie.
+        for (const std::size_t ci : selected) {
+            for (const auto& u : uses) {
+                if (u.cleaner != ci || !is_under(u.root, w)) continue;
+                const fs::path rel = u.root.lexically_relative(w);
+                for (const auto& pat : pack.cleaners[ci].include) {
+                    if (!filter.add_include(reanchor(pat, rel), static_cast<std::uint32_t>(ci), err)) {
+                        r.message = "[" + pack.cleaners[ci].id + "] " + err;
+                        return r;
+                    }
+                }
+            }
+        }
+
+        // Protected subtrees below a root are pruned, as in wipe-dir.
+        const bool check_protect = protect->has_below(protect->normalize(w.string()));
+        auto is_protected = [&](const std::string& p) {
+            if (!check_protect || !protect->check(protect->normalize(p), false)) return false;
+            ++protected_skipped;
+            OutputSink::out().record(OutputSink::Skip, p, "protected");
+            return true;
+        };
+
+        WalkCallbacks cb;
+        cb.enter_dir = [&](const std::string& d, const EntryInfo&) { return !is_protected(d); };
+        cb.on_file = [&](const std::string& f, const EntryInfo& info, std::int32_t tag, std::uint32_t) {
+            if (tag < 0) return;
+            if (is_protected(f)) return;
+            const std::size_t ci = static_cast<std::size_t>(tag);
+            if (!preds[ci].accept_file(FilterState(), info, now)) return;
+            if (co.dry_run) {
+                OutputSink::out().record(OutputSink::WouldWipe, f, pack.cleaners[ci].id);
+            }
+            files[ci].push_back(f);
+            planned_bytes[ci] += info.size;
+        };
+        walk_tree(w.string(), &filter, cb);
+    }
+
+    std::uint64_t total_files = 0, total_wiped = 0, total_failed = 0, total_bytes = 0;
+    std::string lines;
+    for (const std::size_t ci : selected) {
+        const CleanerRule& c = pack.cleaners[ci];
+        const std::vector<std::string>& list = files[ci];
+        total_files += list.size();
+        if (co.dry_run) {
+            total_bytes += planned_bytes[ci];
+            lines += "\n  " + c.id + ": files=" + std::to_string(list.size()) +
+                     ", bytes=" + std::to_string(planned_bytes[ci]);
+            continue;
+        }
+
+        std::uint64_t wiped = 0, failed = 0, bytes = 0;
+        if (!list.empty()) {
+            WipeOptions opt = c.opt;
+            opt.protect.insert(opt.protect.end(), co.protect.begin(), co.protect.end());
+            const std::vector<WipeResult> results = session.wipe_batch(list, opt);
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                bytes += results[i].stats.bytes_overwritten;
+                if (results[i].ok) {
+                    ++wiped;
+                } else {
+                    ++failed;
+                    OutputSink::err().record(OutputSink::Fail, list[i], results[i].message);
+                }
+            }
+        }
+        total_wiped += wiped;
+        total_failed += failed;
+        total_bytes += bytes;
+        lines += "\n  " + c.id + ": wiped=" + std::to_string(wiped) + ", failed=" + std::to_string(failed) +
+                 ", bytes=" + std::to_string(bytes);
+    }
+
+    r.stats.files_wiped = total_wiped;
+    r.stats.files_failed = total_failed;
+    r.stats.bytes_overwritten = total_bytes;
+    if (co.dry_run) {
+        r.ok = true;
+        r.message = "Dry-run complete. Cleaners=" + std::to_string(selected.size()) +
+                    ", trees=" + std::to_string(walk_roots.size()) +
+                    ", files to wipe: " + std::to_string(total_files) +
+                    " (" + std::to_string(total_bytes) + " bytes). Re-run with --yes to execute.";
+        if (protected_skipped > 0) r.message += " Protected skipped: " + std::to_string(protected_skipped) + ".";
+        r.message += lines;
+        return r;
+    }
+    r.ok = total_failed == 0;
+    r.message = "clean complete. cleaners=" + std::to_string(selected.size()) +
+                ", trees=" + std::to_string(walk_roots.size()) +
+                ", total=" + std::to_string(total_files) +
+                ", wiped=" + std::to_string(total_wiped) +
+                ", failed=" + std::to_string(total_failed);
+    if (protected_skipped > 0) r.message += ", protected skipped=" + std::to_string(protected_skipped);
+    r.message += lines;
+    return r;
+}
+
+} // namespace securewipe
@@ -0,0 +1,64 @@
+#pragma once
+// BleachBit-style cleaners loaded from rule packs.
+//
+// A rule pack is an INI-like text file. Lines before the first section apply
+// to every cleaner in the pack; each [section] is one cleaner:
+//
+//   # shared by all cleaners: never wipe below a .git directory
+//   exclude = .git/
+//
+//   [thumbnails]
+//   description = Thumbnail cache
+//   root = ${XDG_CACHE_HOME}/thumbnails
+//   root = ~/.cache/thumbnails
+//   include = **
+//   older-than = 7d
+//
+// Keys: description, root ($VAR, ${VAR} and a leading ~ expand; unset or
+// missing roots are skipped), include (gitignore syntax relative to each
+// root), file (a literal path relative to each root), older-than, min-size,
+// max-size, passes, pattern, enabled. Lines starting with # or ; are comments.
+//
+// All enabled cleaners are compiled into one tagged PathFilter. Roots are
+// merged so that each tree is walked once: a cleaner whose root lies below
+// another root has its rules re-anchored under that root, and every file is
+// credited to the first cleaner whose rule selects it.
+#include "secure_wipe.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+struct CleanerRule {
+    std::string id;
+    std::string description;
+    std::vector<std::string> roots;     // as written; expanded at run time
+    std::vector<std::string> include;   // gitignore patterns relative to a root
+    WipeOptions opt;                    // passes / pattern, min-size and age in opt.filter
+    bool enabled = true;
+};
+
+struct RulePack {
+    std::vector<std::string> exclude;   // shared by all cleaners
+    std::vector<CleanerRule> cleaners;
+};
+
+// Parse `path` and append its cleaners to `pack`. Ids must be unique.
+bool load_rule_pack(const std::string& path, RulePack& pack, std::string& err);
+
+struct CleanOptions {
+    std::vector<std::string> only;      // cleaner ids to run (empty = all enabled)
+    std::vector<std::string> protect;   // extra protected paths (--protect), as for wipe-dir
+    bool dry_run = false;
+};
+
+// Walk every merged root once and wipe what the cleaners select. A root that
+// wipe-dir would refuse (dangerous or protected) fails the whole run.
+// The message holds one line per cleaner plus a total.
+WipeResult run_clean(WipeSession& session, const RulePack& pack, const CleanOptions& co);
+
+// One line per cleaner: id, enabled flag, description and expanded roots.
+std::string describe_rule_pack(const RulePack& pack);
+
+} // namespace securewipe
@@ -0,0 +1,566 @@
+#include "cluster.h"
+#include "line_json.h"
+#include "net_util.h"
+#include "output_sink.h"
+#include "protect.h"
+#include "shard.h"
+#include "size_histogram.h"
+#include "tree_walk.h"
+#include "wipe_engine.h"
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace securewipe {
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string agent_name() {
+    char host[256] = {0};
+    ::gethostname(host, sizeof(host) - 1);
+    return std::string(host) + ":" + std::to_string(::getpid());
+}
+
+// ---------------------------------------------------------------- agent side
+
+std::string exec_shard(WipeSession& session, const JsonObject& req, const StopToken& stop) {
+    const std::uint64_t id = req.get_uint("id");
+    std::string kind = req.get_string("kind");
+    const std::string path = req.get_string("path");
+    const bool dry_run = req.get_bool("dry_run");
+
+    WipeOptions opt;
+    opt.passes = static_cast<int>(req.get_int("passes", opt.passes));
+    opt.pattern = req.get_string("pattern") == "random" ? Pattern::Random : Pattern::Zeros;
+
+    JsonWriter ev;
+    ev.add("event", "done").add("id", id);
+
+    std::error_code ec;
+    const fs::file_status st = fs::symlink_status(path, ec);
+    if (kind == "auto") kind = fs::is_directory(st) ? "tree" : "file";
+
+    SizeHistogram hist;
+    if (kind == "tree") {
+        // A whole subtree is an ordinary recursive job: walked and wiped
+        // beneath one descriptor for the root, protected subtrees pruned.
+        std::uint64_t files = 0;
+        SubmitOptions so;
+        so.stop_token = stop;
+        so.dry_run = dry_run;
+        so.recursive = true;
+        so.on_file = [&](const std::string&, std::uint64_t size) {
+            hist.add(size);
+            ++files;
+        };
+        const WipeResult r = session.submit(path, opt, so).get();
+        return ev.add("ok", r.ok)
+            .add("message", r.message)
+            .add("files", files)
+            .add("wiped", r.stats.files_wiped)
+            .add("failed", r.stats.files_failed)
+            .add("skipped", r.stats.files_skipped)
+            .add("bytes", r.stats.bytes_overwritten)
+            .add("hist", hist.to_vector())
+            .str();
+    }
+
+    std::vector<std::string> files;
+    std::uint64_t protected_skipped = 0;
+    if (kind == "loose") {
+        // The top level of a directory only, with the shared walk: one stat per
+        // entry, symlinks never followed, protected files skipped.
+        const auto protect = ProtectedPaths::get(opt.protect);
+        const fs::path root_abs = fs::weakly_canonical(fs::absolute(path, ec), ec);
+        const bool check_protect = !ec && protect->has_below(protect->normalize(root_abs.string()));
+        WalkCallbacks cb;
+        cb.enter_dir = [](const std::string&, const EntryInfo&) { return false; };
+        cb.on_file = [&](const std::string& f, const EntryInfo& info, std::int32_t, std::uint32_t) {
+            const std::string abs = (root_abs / fs::path(f).lexically_relative(path)).string();
+            if (check_protect && protect->check(protect->normalize(abs), false)) {
+                ++protected_skipped;
+                OutputSink::out().record(OutputSink::Skip, f, "protected");
+                return;
+            }
+            hist.add(info.size);
+            files.push_back(f);
+        };
+        cb.should_stop = [&] { return stop.stop_requested(); };
+        walk_tree(path, nullptr, cb);
+    } else if (kind == "file") {
+        EntryInfo info;
+        if (stat_entry(path, info) && info.kind == EntryInfo::Regular) {
+            hist.add(info.size);
+            files.push_back(path);
+        }
+    } else {
+        return ev.add("ok", false).add("message", "unknown shard kind: " + kind).str();
+    }
+
+    WipeStats s;
+    std::string message;
+    if (dry_run) {
+        for (const auto& f : files) OutputSink::out().record(OutputSink::WouldWipe, f);
+        OutputSink::out().flush();
+        message = "dry-run";
+    } else {
+        std::size_t next = 0;
+        const WipeResult r = session.wipe_stream(
+            [&](std::string& p) {
+                if (next == files.size() || stop.stop_requested()) return false;
+                p = files[next++];
+                return true;
+            },
+            opt);
+        s = r.stats;
+        s.files_skipped = files.size() - next;
+        message = r.message;
+    }
+
+    if (protected_skipped > 0) message += ", protected skipped=" + std::to_string(protected_skipped);
+    return ev.add("ok", s.files_failed == 0 && s.files_skipped == 0)
+        .add("message", message)
+        .add("files", static_cast<std::uint64_t>(files.size()))
+        .add("wiped", s.files_wiped)
+        .add("failed", s.files_failed)
+        .add("skipped", s.files_skipped)
+        .add("bytes", s.bytes_overwritten)
+        .add("hist", hist.to_vector())
+        .str();
+}
+
+// Token comparison whose time depends only on the expected token's length.
+bool token_matches(const std::string& got, const std::string& want) {
+    unsigned char diff = got.size() == want.size() ? 0 : 1;
+    for (std::size_t i = 0; i < want.size(); ++i) {
+        const unsigned char g = i < got.size() ? static_cast<unsigned char>(got[i]) : 0;
+        diff |= static_cast<unsigned char>(g ^ static_cast<unsigned char>(want[i]));
+    }
+    return diff == 0;
+}
+
+const unsigned kHelloTimeoutMs = 10000;
+// How often an agent reports that it is alive; the coordinator's
+// --agent-timeout must comfortably exceed this.
+const std::chrono::seconds kProgressInterval(5);
+
+// Serve one coordinator connection until it closes.
+void serve_coordinator(int fd, WipeSession& session, const AgentOptions& opt) {
+    net::LineReader reader(fd);
+    std::string line, err;
+    JsonObject hello;
+    // A peer that connects and stays silent must not hold the agent.
+    net::set_recv_timeout(fd, kHelloTimeoutMs);
+    if (!reader.read_line(line) || !hello.parse(line, err) || hello.get_string("op") != "hello") {
+        return;
+    }
+    net::set_recv_timeout(fd, 0);
+    if (!token_matches(hello.get_string("token"), opt.token)) {
+        net::send_line(fd, JsonWriter().add("event", "error").add("message", "bad token").str());
+        return;
+    }
+    const unsigned slots = std::max(1u, opt.slots);
+    net::send_line(fd, JsonWriter()
+                           .add("event", "hello")
+                           .add("agent", agent_name())
+                           .add("slots", static_cast<std::uint64_t>(slots))
+                           .str());
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<JsonObject> queue;
+    bool closing = false;
+    std::mutex write_mu;
+    std::condition_variable beat_cv;
+    StopSource stop;
+
+    // Progress events let the coordinator tell a long shard from a hung agent.
+    std::thread beat([&] {
+        std::unique_lock<std::mutex> lk(mu);
+        while (!beat_cv.wait_for(lk, kProgressInterval, [&] { return closing; })) {
+            lk.unlock();
+            {
+                std::lock_guard<std::mutex> wlk(write_mu);
+                net::send_line(fd, JsonWriter().add("event", "progress").str());
+            }
+            lk.lock();
+        }
+    });
+
+    std::vector<std::thread> runners;
+    for (unsigned i = 0; i < slots; ++i) {
+        runners.emplace_back([&] {
+            for (;;) {
+                JsonObject req;
+                {
+                    std::unique_lock<std::mutex> lk(mu);
+                    cv.wait(lk, [&] { return closing || !queue.empty(); });
+                    if (queue.empty()) return;
+                    req = std::move(queue.front());
+                    queue.pop_front();
+                }
+                const std::string ev = exec_shard(session, req, stop.get_token());
+                std::lock_guard<std::mutex> lk(write_mu);
+                net::send_line(fd, ev);
+            }
+        });
+    }
+
+    while (reader.read_line(line)) {
+        JsonObject req;
+        if (!req.parse(line, err) || req.get_string("op") != "shard") continue;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            queue.push_back(std::move(req));
+        }
+        cv.notify_one();
+    }
+
+    // Coordinator gone: its shards will be re-dispatched, so stop ours early.
+    stop.request_stop();
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        closing = true;
+        queue.clear();
+    }
+    cv.notify_all();
+    beat_cv.notify_all();
+    for (auto& t : runners) t.join();
+    beat.join();
+}
+
+// ---------------------------------------------------------- coordinator side
+
+struct Shard {
+    std::string kind;
+    std::string path;
+    unsigned attempts = 0;
+};
+
+struct Agent {
+    std::string addr;
+    std::string name;
+    int fd = -1;
+    unsigned slots = 1;
+    net::LineBuffer in;
+    std::set<std::size_t> inflight;
+    std::chrono::steady_clock::time_point last_heard;  // last byte received while busy
+    std::uint64_t shards_done = 0;
+    WipeStats stats;
+};
+
+bool handshake(Agent& a, const std::string& token, std::string& err) {
+    a.fd = net::connect_tcp(a.addr, err);
+    if (a.fd < 0) return false;
+    if (!net::send_line(a.fd, JsonWriter().add("op", "hello").add("token", token).str())) {
+        err = "send failed";
+        return false;
+    }
+    // Read byte-wise so nothing past the hello line is consumed here.
+    std::string line;
+    char c;
+    while (::read(a.fd, &c, 1) == 1 && c != '\n') line += c;
+    JsonObject ev;
+    if (!ev.parse(line, err) || ev.get_string("event") != "hello") {
+        err = ev.get_string("message", "no hello from agent");
+        return false;
+    }
+    a.name = ev.get_string("agent", a.addr);
+    a.slots = static_cast<unsigned>(std::max<std::uint64_t>(1, ev.get_uint("slots", 1)));
+    return true;
+}
+
+void add_stats(WipeStats& into, const WipeStats& s) {
+    into.files_wiped += s.files_wiped;
+    into.files_failed += s.files_failed;
+    into.files_skipped += s.files_skipped;
+    into.bytes_overwritten += s.bytes_overwritten;
+}
+
+std::string format_stats(const WipeStats& s) {
+    return "wiped=" + std::to_string(s.files_wiped) + ", failed=" + std::to_string(s.files_failed) +
+           ", skipped=" + std::to_string(s.files_skipped) + ", bytes=" + std::to_string(s.bytes_overwritten);
+}
+
+} // namespace
+
+int run_agent(const AgentOptions& opt) {
+    if (opt.token.empty()) {
+        std::cerr << "Error: agent requires a shared token (--token or SECUREWIPE_TOKEN)\n";
+        return 2;
+    }
+    std::string err;
+    const int lfd = net::listen_tcp(opt.listen, err);
+    if (lfd < 0) {
+        std::cerr << "Error: " << err << "\n";
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    SessionOptions so;
+    so.threads = opt.threads;
+    WipeSession session(so);
+    std::cout << "securewipe agent listening on " << opt.listen << " (" << session.threads() << " workers, "
+              << std::max(1u, opt.slots) << " slots)" << std::endl;
+
+    // One thread per connection, so that a slow or stuck peer delays no one else.
+    std::mutex conn_mu;
+    std::condition_variable conn_cv;
+    unsigned active = 0;
+    for (;;) {
+        const int fd = ::accept(lfd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: accept: " << std::strerror(errno) << "\n";
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lk(conn_mu);
+            ++active;
+        }
+        std::thread([&, fd] {
+            serve_coordinator(fd, session, opt);
+            ::close(fd);
+            std::lock_guard<std::mutex> lk(conn_mu);
+            --active;
+            conn_cv.notify_all();
+        }).detach();
+    }
+    ::close(lfd);
+    std::unique_lock<std::mutex> lk(conn_mu);
+    conn_cv.wait(lk, [&] { return active == 0; });
+    return 1;
+}
+
+WipeResult run_coordinator(const CoordinatorOptions& co, const std::vector<std::string>& targets,
+                           const WipeOptions& opt, bool dry_run) {
+    WipeResult r;
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Split targets into shards. Directories visible here are split further.
+    std::vector<Shard> shards;
+    std::vector<std::string> local_dirs;
+    for (const auto& t : targets) {
+        std::error_code ec;
+        const std::string abs = fs::absolute(t, ec).lexically_normal().string();
+        const fs::file_status st = fs::symlink_status(abs, ec);
+        if (fs::is_directory(st)) {
+            WipeResult chk = detail::check_directory_target(abs, dry_run, true);
+            if (!chk.ok) {
+                chk.message = abs + ": " + chk.message;
+                return chk;
+            }
+            for (const auto& u : split_tree(abs, std::max(1u, co.depth))) {
+                shards.push_back(Shard{u.recursive ? "tree" : "loose",
+                                       (fs::path(abs) / u.rel).lexically_normal().string()});
+            }
+            local_dirs.push_back(abs);
+        } else if (fs::is_regular_file(st)) {
+            shards.push_back(Shard{"file", abs});
+        } else {
+            shards.push_back(Shard{"auto", abs});   // not visible here; the agent decides
+        }
+    }
+
+    std::vector<Agent> agents(co.agents.size());
+    std::size_t alive = 0;
+    for (std::size_t i = 0; i < agents.size(); ++i) {
+        agents[i].addr = co.agents[i];
+        std::string err;
+        if (handshake(agents[i], co.token, err)) {
+            ++alive;
+        } else {
+            std::cerr << "[AGENT] " << agents[i].addr << " unavailable: " << err << "\n";
+            net::close_fd(agents[i].fd);
+            agents[i].fd = -1;
+        }
+    }
+    if (alive == 0) {
+        r.message = "No agent reachable";
+        return r;
+    }
+
+    std::deque<std::size_t> queue;
+    for (std::size_t i = 0; i < shards.size(); ++i) queue.push_back(i);
+    std::size_t completed = 0;
+    std::uint64_t failed_shards = 0;
+    WipeStats total;
+    SizeHistogram hist;
+
+    using Clock = std::chrono::steady_clock;
+    const std::chrono::seconds timeout(std::max<std::int64_t>(1, co.agent_timeout));
+
+    auto drop_agent = [&](Agent& a) {
+        std::cerr << "[AGENT] " << a.name << " lost; re-dispatching " << a.inflight.size() << " shard(s)\n";
+        net::close_fd(a.fd);
+        a.fd = -1;
+        --alive;
+        for (std::size_t id : a.inflight) {
+            if (shards[id].attempts >= co.max_attempts) {
+                std::cerr << "[FAIL] " << shards[id].path << " : gave up after " << shards[id].attempts
+                          << " attempts\n";
+                ++failed_shards;
+                ++completed;
+            } else {
+                queue.push_front(id);
+            }
+        }
+        a.inflight.clear();
+    };
+
+    std::vector<pollfd> fds;
+    std::vector<Agent*> polled;
+    while (completed < shards.size()) {
+        // Hand out work to every agent with a free slot.
+        for (auto& a : agents) {
+            while (a.fd >= 0 && a.inflight.size() < a.slots && !queue.empty()) {
+                const std::size_t id = queue.front();
+                queue.pop_front();
+                Shard& sh = shards[id];
+                ++sh.attempts;
+                const std::string msg = JsonWriter()
+                                            .add("op", "shard")
+                                            .add("id", static_cast<std::uint64_t>(id))
+                                            .add("kind", sh.kind)
+                                            .add("path", sh.path)
+                                            .add("passes", opt.passes)
+                                            .add("pattern", opt.pattern == Pattern::Random ? "random" : "zeros")
+                                            .add("dry_run", dry_run)
+                                            .str();
+                if (a.inflight.empty()) a.last_heard = Clock::now();
+                a.inflight.insert(id);
+                if (!net::send_line(a.fd, msg)) {
+                    drop_agent(a);
+                    break;
+                }
+            }
+        }
+        if (alive == 0) {
+            std::cerr << "[FAIL] all agents lost with " << (shards.size() - completed) << " shard(s) left\n";
+            failed_shards += shards.size() - completed;
+            break;
+        }
+
+        // Wait for events, but no longer than the nearest liveness deadline
+        // of an agent that holds shards.
+        fds.clear();
+        polled.clear();
+        int wait_ms = -1;
+        const Clock::time_point now = Clock::now();
+        for (auto& a : agents) {
+            if (a.fd < 0) continue;
+            fds.push_back(pollfd{a.fd, POLLIN, 0});
+            polled.push_back(&a);
+            if (a.inflight.empty()) continue;
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(a.last_heard + timeout - now);
+            const int ms = static_cast<int>(std::max<std::int64_t>(0, left.count()));
+            if (wait_ms < 0 || ms < wait_ms) wait_ms = ms;
+        }
+        if (::poll(fds.data(), fds.size(), wait_ms) < 0) {
+            if (errno == EINTR) continue;
+            r.message = std::string("poll: ") + std::strerror(errno);
+            return r;
+        }
+
+        for (std::size_t k = 0; k < fds.size(); ++k) {
+            if (!(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            Agent& a = *polled[k];
+            char tmp[8192];
+            const ssize_t n = ::read(a.fd, tmp, sizeof(tmp));
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                drop_agent(a);
+                continue;
+            }
+            a.last_heard = Clock::now();
+            a.in.append(tmp, static_cast<std::size_t>(n));
+            std::string line, err;
+            while (a.in.next_line(line)) {
+                JsonObject ev;
+                if (!ev.parse(line, err) || ev.get_string("event") != "done") continue;
+                const std::size_t id = static_cast<std::size_t>(ev.get_uint("id"));
+                if (!a.inflight.erase(id)) continue;
+
+                WipeStats s;
+                s.files_wiped = ev.get_uint("wiped");
+                s.files_failed = ev.get_uint("failed");
+                s.files_skipped = ev.get_uint("skipped");
+                s.bytes_overwritten = ev.get_uint("bytes");
+                add_stats(total, s);
+                add_stats(a.stats, s);
+                hist.merge_vector(ev.get_uint_array("hist"));
+                ++a.shards_done;
+                ++completed;
+                if (!ev.get_bool("ok")) {
+                    ++failed_shards;
+                    std::cerr << "[FAIL] " << shards[id].path << " on " << a.name << " : "
+                              << ev.get_string("message") << "\n";
+                }
+            }
+        }
+
+        // An agent that holds shards but has gone silent is treated as lost.
+        const Clock::time_point after = Clock::now();
+        for (auto& a : agents) {
+            if (a.fd < 0 || a.inflight.empty() || after - a.last_heard < timeout) continue;
+            std::cerr << "[AGENT] " << a.name << " silent for " << timeout.count() << "s\n";
+            drop_agent(a);
+        }
+    }
+
+    for (auto& a : agents) net::close_fd(a.fd);
+    if (!dry_run) {
+        for (const auto& d : local_dirs) detail::remove_empty_dirs(d);
+    }
+
+    r.ok = (failed_shards == 0);
+    r.stats = total;
+    r.message = std::string(dry_run ? "coordinate dry-run complete. " : "coordinate complete. ") +
+                "shards=" + std::to_string(shards.size()) + ", failed_shards=" + std::to_string(failed_shards) +
+                ", " + format_stats(total) + "\n";
+    for (const auto& a : agents) {
+        if (a.name.empty()) continue;
+        r.message += "  agent " + a.name + ": shards=" + std::to_string(a.shards_done) + ", " +
+                     format_stats(a.stats) + "\n";
+    }
+    r.message += "size histogram (" + std::string(dry_run ? "files to wipe" : "files seen") + "):\n";
+    r.message += hist.format("  ");
+    if (!r.message.empty() && r.message.back() == '\n') r.message.pop_back();
+    return r;
+}
+
+#else
+
+int run_agent(const AgentOptions&) {
+    std::cerr << "Error: agent mode is not supported on this platform\n";
+    return 2;
+}
+
+WipeResult run_coordinator(const CoordinatorOptions&, const std::vector<std::string>&, const WipeOptions&, bool) {
+    WipeResult r;
+    r.message = "coordinate is not supported on this platform";
+    return r;
+}
+
+#endif
+
+} // namespace securewipe
@@ -0,0 +1,50 @@
+#pragma once
+// Fan-out of one job over several `securewipe agent` processes.
+//
+// The coordinator splits each target into shards (a single file, the loose
+// files of a directory, or a whole subtree) and hands them to agents over TCP
+// on demand: each agent holds at most `slots` shards, and the next shard goes
+// to whichever agent frees a slot first, so fast agents drain the queue while
+// slow ones keep their current work. Shards of an agent whose connection drops
+// are re-dispatched to the others, as are those of an agent that holds shards
+// but sends nothing for `agent_timeout` seconds. Agents report counters and a size histogram
+// per shard; the coordinator prints the aggregate.
+//
+// Protocol: line-JSON as in daemon.h.
+//   -> {"op":"hello","token":"..."}
+//   <- {"event":"hello","agent":"host:pid","slots":2}
+//   -> {"op":"shard","id":7,"kind":"tree|loose|file|auto","path":"/abs","passes":1,
+//       "pattern":"zeros","dry_run":false}
+//      ("auto" is sent for a target the coordinator cannot see; the agent
+//      treats it as "tree" if it is a directory there, else as "file")
+//   <- {"event":"progress"}                   (every few seconds while connected)
+//   <- {"event":"done","id":7,"ok":true,"message":"...","wiped":..,"failed":..,
+//       "skipped":..,"bytes":..,"hist":[..]}
+#include "secure_wipe.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+struct AgentOptions {
+    std::string listen = "127.0.0.1:7421";
+    unsigned threads = 0;       // wipe workers
+    unsigned slots = 2;         // shards executed concurrently per coordinator
+    std::string token;          // shared secret required from the coordinator; must not be empty
+};
+
+struct CoordinatorOptions {
+    std::vector<std::string> agents;    // host:port
+    std::string token;
+    unsigned depth = 1;                 // split depth for directory targets
+    unsigned max_attempts = 3;          // dispatches per shard before giving up
+    std::int64_t agent_timeout = 60;    // seconds of silence before a busy agent is dropped
+};
+
+int run_agent(const AgentOptions& opt);
+
+WipeResult run_coordinator(const CoordinatorOptions& co, const std::vector<std::string>& targets,
+                           const WipeOptions& opt, bool dry_run);
+
+} // namespace securewipe
@@ -0,0 +1,266 @@
+#include "content_match.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace securewipe {
+
+namespace {
+
+// Upper bound on the summed pattern length: the DFA costs 1 KiB per state.
+constexpr std::size_t kMaxPatternBytes = 16384;
+constexpr std::size_t kReadSize = 1 << 20;
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool unescape(const std::string& in, std::string& out, std::string& err) {
+    out.clear();
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        if (in[i] != '\\' || i + 1 == in.size()) {
+            out += in[i];
+            continue;
+        }
+        const char c = in[++i];
+        switch (c) {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case '0': out += '\0'; break;
+        case '\\': out += '\\'; break;
+        case 'x': {
+            const int hi = i + 1 < in.size() ? hex_value(in[i + 1]) : -1;
+            const int lo = i + 2 < in.size() ? hex_value(in[i + 2]) : -1;
+            if (hi < 0 || lo < 0) {
+                err = "Bad \\x escape in pattern: " + in;
+                return false;
+            }
+            out += static_cast<char>((hi << 4) | lo);
+            i += 2;
+            break;
+        }
+        default:
+            out += '\\';
+            out += c;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool ContentMatcher::compile(const std::vector<std::string>& patterns, std::string& err) {
+    patterns_.clear();
+    next_.clear();
+    accept_from_ = 0;
+    n_starts_ = 0;
+    pairs_.assign(1024, 0);
+    std::fill(std::begin(first_), std::end(first_), false);
+
+    std::size_t total = 0;
+    for (const auto& raw : patterns) {
+        std::string p;
+        if (!unescape(raw, p, err)) return false;
+        if (p.empty()) {
+            err = "Empty --if-contains pattern";
+            return false;
+        }
+        total += p.size();
+        const unsigned b0 = static_cast<unsigned char>(p[0]);
+        first_[b0] = true;
+        for (unsigned b1 = 0; b1 < 256; ++b1) {
+            // A one-byte pattern starts with any pair beginning with it.
+            if (p.size() == 1 || b1 == static_cast<unsigned char>(p[1])) {
+                const unsigned bit = b0 | (b1 << 8);
+                pairs_[bit >> 6] |= std::uint64_t(1) << (bit & 63);
+            }
+        }
+        patterns_.push_back(std::move(p));
+    }
+    if (total > kMaxPatternBytes) {
+        err = "--if-contains patterns too large (" + std::to_string(total) + " bytes, limit " +
+              std::to_string(kMaxPatternBytes) + ")";
+        return false;
+    }
+    if (patterns_.empty()) return true;
+
+    // Trie of the patterns; -1 = no edge yet.
+    std::vector<std::array<std::int32_t, 256>> go(1);
+    go[0].fill(-1);
+    std::vector<char> accept(1, 0);
+    for (const auto& p : patterns_) {
+        std::int32_t s = 0;
+        for (unsigned char c : p) {
+            if (go[s][c] < 0) {
+                go[s][c] = static_cast<std::int32_t>(go.size());
+                go.emplace_back();
+                go.back().fill(-1);
+                accept.push_back(0);
+            }
+            s = go[s][c];
+        }
+        accept[s] = 1;
+    }
+
+    // Breadth-first: fill missing edges through the failure links, which
+    // turns the trie into a DFA, and inherit acceptance along them.
+    std::vector<std::int32_t> fail(go.size(), 0), order;
+    order.reserve(go.size());
+    for (int c = 0; c < 256; ++c) {
+        if (go[0][c] < 0) go[0][c] = 0;
+        else order.push_back(go[0][c]);
+    }
+    for (std::size_t q = 0; q < order.size(); ++q) {
+        const std::int32_t u = order[q];
+        if (accept[fail[u]]) accept[u] = 1;
+        for (int c = 0; c < 256; ++c) {
+            const std::int32_t v = go[u][c];
+            if (v < 0) {
+                go[u][c] = go[fail[u]][c];
+            } else {
+                fail[v] = go[fail[u]][c];
+                order.push_back(v);
+            }
+        }
+    }
+
+    // The scan stops at the first match, so every accepting state folds into
+    // one absorbing state numbered after all the others.
+    std::vector<std::uint32_t> id(go.size());
+    std::uint32_t live = 0;
+    for (std::size_t s = 0; s < go.size(); ++s) {
+        if (!accept[s]) id[s] = live++;
+    }
+    accept_from_ = live;
+    for (std::size_t s = 0; s < go.size(); ++s) {
+        if (accept[s]) id[s] = live;
+    }
+    next_.assign((static_cast<std::size_t>(live) + 1) * 256, live);
+    for (std::size_t s = 0; s < go.size(); ++s) {
+        if (accept[s]) continue;
+        std::uint32_t* row = &next_[static_cast<std::size_t>(id[s]) * 256];
+        for (int c = 0; c < 256; ++c) row[c] = id[go[s][c]];
+    }
+
+    // Distinct first bytes, for the vector compare.
+    unsigned n = 0;
+    for (int c = 0; c < 256 && n <= 8; ++c) {
+        if (first_[c]) {
+            if (n < 8) starts_[n] = static_cast<unsigned char>(c);
+            ++n;
+        }
+    }
+    n_starts_ = n <= 8 ? n : 0;
+    for (unsigned i = n_starts_; i > 0 && i < 8; ++i) starts_[i] = starts_[0];
+    return true;
+}
+
+std::size_t ContentMatcher::skip_to_start(const unsigned char* p, std::size_t n) const {
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    if (n_starts_ > 0) {
+        __m128i want[8];
+        for (int k = 0; k < 8; ++k) want[k] = _mm_set1_epi8(static_cast<char>(starts_[k]));
+        for (; i + 16 <= n; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            __m128i hit = _mm_cmpeq_epi8(v, want[0]);
+            for (int k = 1; k < 8; ++k) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, want[k]));
+            for (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit)); mask != 0; mask &= mask - 1) {
+                const std::size_t at = i + static_cast<std::size_t>(__builtin_ctz(mask));
+                if (at + 1 == n || pair_at(p + at)) return at;
+            }
+        }
+    }
+#endif
+    for (; i + 1 < n; ++i) {
+        if (pair_at(p + i)) return i;
+    }
+    // The last byte's successor is in the next chunk.
+    return i < n && first_[p[i]] ? i : n;
+}
+
+bool ContentMatcher::feed(State& st, const unsigned char* data, std::size_t n) const {
+    std::uint32_t s = st.s;
+    if (patterns_.empty() || s >= accept_from_) return !patterns_.empty();
+    const std::uint32_t* next = next_.data();
+    std::size_t i = 0;
+    while (i < n) {
+        if (s == 0) {
+            i += skip_to_start(data + i, n - i);
+            if (i == n) break;
+        }
+        s = next[static_cast<std::size_t>(s) * 256 + data[i++]];
+        if (s >= accept_from_) {
+            st.s = s;
+            return true;
+        }
+    }
+    st.s = s;
+    return false;
+}
+
+int ContentMatcher::scan_file(const std::string& path, std::vector<unsigned char>& buf) const {
+    if (buf.size() < kReadSize) buf.resize(kReadSize);
+    State st;
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) return -1;
+#if defined(__linux__)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    int found = 0;
+    for (;;) {
+        const ssize_t got = ::read(fd, buf.data(), buf.size());
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) found = -1;
+        if (got <= 0) break;
+        if (feed(st, buf.data(), static_cast<std::size_t>(got))) {
+            found = 1;
+            break;
+        }
+    }
+    ::close(fd);
+    return found;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return -1;
+    while (in) {
+        in.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+        const std::streamsize got = in.gcount();
+        if (got <= 0) break;
+        if (feed(st, buf.data(), static_cast<std::size_t>(got))) return 1;
+    }
+    return in.bad() ? -1 : 0;
+#endif
+}
+
+bool ContentMatcher::load_patterns_file(const std::string& path, std::vector<std::string>& out, std::string& err) {
+    std::ifstream in(path);
+    if (!in) {
+        err = "Cannot open pattern file: " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        out.push_back(line);
+    }
+    return true;
+}
+
+} // namespace securewipe
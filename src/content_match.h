@@ -0,0 +1,58 @@
+#pragma once
+// Multi-pattern byte scanner for content-triggered wipes (--if-contains).
+//
+// The patterns are compiled into an Aho-Corasick automaton flattened into a
+// full 256-way DFA, so the inner loop is one table load per byte with no
+// failure-link chasing, and accepting states are numbered last so a match
+// is a single compare. While the automaton sits in its start state (almost
+// always, on data that does not match) the scan jumps ahead to the next
+// place a pattern can begin: SSE2 compares find the patterns' first bytes 16
+// at a time (up to 8 distinct ones), and each hit is confirmed against a
+// 64 Kbit table of the patterns' first two bytes before the automaton runs.
+// Files are streamed in large reads and the scan stops at the first match.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+class ContentMatcher {
+public:
+    // Patterns are byte strings; "\xHH", "\n", "\t", "\r", "\0" and "\\"
+    // are unescaped. Fails on an empty pattern or an oversized set.
+    bool compile(const std::vector<std::string>& patterns, std::string& err);
+    bool empty() const { return patterns_.empty(); }
+
+    // Carried across the chunks of one stream.
+    struct State {
+        std::uint32_t s = 0;
+    };
+    // Feed `n` bytes; true once any pattern has been seen.
+    bool feed(State& st, const unsigned char* data, std::size_t n) const;
+
+    // Read `path` (not following a final symlink) until a match or EOF,
+    // through `buf`. Returns 1 on a match, 0 if none, -1 if it cannot be read.
+    int scan_file(const std::string& path, std::vector<unsigned char>& buf) const;
+
+    // Lines of `path` appended to `out`; blank lines and "#" comments are skipped.
+    static bool load_patterns_file(const std::string& path, std::vector<std::string>& out, std::string& err);
+
+private:
+    std::size_t skip_to_start(const unsigned char* p, std::size_t n) const;
+
+    std::vector<std::string> patterns_;     // unescaped
+    std::vector<std::uint32_t> next_;       // state * 256 + byte
+    std::uint32_t accept_from_ = 0;         // states >= this have matched
+    bool pair_at(const unsigned char* p) const {
+        const unsigned bit = p[0] | (static_cast<unsigned>(p[1]) << 8);
+        return (pairs_[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    unsigned char starts_[8] = {};          // first bytes, when there are at most 8
+    unsigned n_starts_ = 0;                 // 0 = more; scan with the pair table alone
+    std::vector<std::uint64_t> pairs_;      // bit (b0 | b1 << 8): a pattern can start "b0 b1"
+    bool first_[256] = {};                  // a pattern starts with this byte
+};
+
+} // namespace securewipe
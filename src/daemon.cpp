@@ -0,0 +1,496 @@
+#include "daemon.h"
+#include "line_json.h"
+#include "net_util.h"
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace securewipe {
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::size_t kMaxOutbox = 16u << 20;   // drop clients that stop reading
+
+volatile std::sig_atomic_t g_stop = 0;
+int g_wake_fd = -1;
+
+void on_signal(int) {
+    g_stop = 1;
+    if (g_wake_fd >= 0) {
+        const char b = 's';
+        (void)!::write(g_wake_fd, &b, 1);
+    }
+}
+
+void set_nonblocking(int fd) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+// Token bucket for accepted jobs; touched only by the event loop.
+struct Bucket {
+    double tokens = -1;     // < 0: not used yet, starts full
+    std::chrono::steady_clock::time_point refilled;
+
+    bool take(double rate, double burst, std::chrono::steady_clock::time_point now) {
+        if (rate <= 0) return true;
+        if (tokens < 0) {
+            tokens = burst;
+        } else {
+            tokens = std::min(burst, tokens + std::chrono::duration<double>(now - refilled).count() * rate);
+        }
+        refilled = now;
+        if (tokens < 1.0) return false;
+        tokens -= 1.0;
+        return true;
+    }
+};
+
+struct Client {
+    int fd = -1;
+    net::LineBuffer in;
+
+    std::mutex mu;      // guards everything below; taken by worker callbacks
+    std::string out;
+    std::unordered_map<std::string, StopSource> jobs;
+    bool closed = false;
+
+    uid_t uid = static_cast<uid_t>(-1);     // peer credentials, taken at accept
+    Bucket bucket;                          // --rate, this connection only
+};
+
+uid_t peer_uid(int fd) {
+#if defined(SO_PEERCRED)
+    ucred cred;
+    socklen_t len = sizeof(cred);
+    if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) return cred.uid;
+#else
+    uid_t uid;
+    gid_t gid;
+    if (::getpeereid(fd, &uid, &gid) == 0) return uid;
+#endif
+    return static_cast<uid_t>(-1);
+}
+using ClientPtr = std::shared_ptr<Client>;
+
+class Daemon {
+public:
+    Daemon(const DaemonOptions& opt, WipeSession& session, int wake_w)
+        : opt_(opt), session_(session), wake_w_(wake_w) {
+        burst_ = opt.burst > 0 ? opt.burst : std::max(1.0, opt.rate);
+        uid_burst_ = opt.burst > 0 ? opt.burst : std::max(1.0, opt.uid_rate);
+    }
+
+    void add_client(int fd) {
+        set_nonblocking(fd);
+        auto c = std::make_shared<Client>();
+        c->fd = fd;
+        c->uid = peer_uid(fd);
+        clients_.push_back(c);
+    }
+
+    std::vector<ClientPtr>& clients() { return clients_; }
+
+    void emit(const ClientPtr& c, const std::string& line) {
+        {
+            std::lock_guard<std::mutex> lk(c->mu);
+            if (c->closed) return;
+            c->out += line;
+            c->out += '\n';
+        }
+        const char b = 'e';
+        (void)!::write(wake_w_, &b, 1);
+    }
+
+    // Returns false when the connection should be closed.
+    bool on_readable(const ClientPtr& c) {
+        char tmp[8192];
+        for (;;) {
+            const ssize_t n = ::read(c->fd, tmp, sizeof(tmp));
+            if (n > 0) {
+                c->in.append(tmp, static_cast<std::size_t>(n));
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            return false;   // EOF or error
+        }
+        std::string line;
+        while (c->in.next_line(line)) {
+            if (!line.empty()) handle(c, line);
+        }
+        return c->in.pending() <= kMaxOutbox;
+    }
+
+    // Returns false when the connection should be closed.
+    bool flush(const ClientPtr& c) {
+        std::lock_guard<std::mutex> lk(c->mu);
+        while (!c->out.empty()) {
+            const ssize_t w = ::send(c->fd, c->out.data(), c->out.size(), MSG_NOSIGNAL);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+            c->out.erase(0, static_cast<std::size_t>(w));
+        }
+        return c->out.size() <= kMaxOutbox;
+    }
+
+    bool wants_write(const ClientPtr& c) {
+        std::lock_guard<std::mutex> lk(c->mu);
+        return !c->out.empty();
+    }
+
+    void close_client(const ClientPtr& c) {
+        // Jobs already accepted keep running; their events are dropped.
+        std::lock_guard<std::mutex> lk(c->mu);
+        c->closed = true;
+        ::close(c->fd);
+        c->fd = -1;
+    }
+
+private:
+    // The connection's own bucket first, then the cap shared by every
+    // connection of the peer's uid (which also outlives reconnects).
+    bool take_token(Client& c) {
+        const auto now = std::chrono::steady_clock::now();
+        if (opt_.uid_rate > 0) {
+            Bucket& u = uid_buckets_[c.uid];
+            Bucket probe = u;
+            if (!probe.take(opt_.uid_rate, uid_burst_, now)) return false;
+            if (!c.bucket.take(opt_.rate, burst_, now)) return false;
+            u = probe;
+            return true;
+        }
+        return c.bucket.take(opt_.rate, burst_, now);
+    }
+
+    void reply_error(const ClientPtr& c, const std::string& id, const std::string& msg) {
+        JsonWriter w;
+        w.add("event", "error");
+        if (!id.empty()) w.add("id", id);
+        w.add("message", msg);
+        emit(c, w.str());
+    }
+
+    void handle(const ClientPtr& c, const std::string& line) {
+        JsonObject req;
+        std::string err;
+        if (!req.parse(line, err)) {
+            reply_error(c, "", "bad request: " + err);
+            return;
+        }
+        const std::string op = req.get_string("op");
+        const std::string id = req.get_string("id");
+
+        if (op == "ping") {
+            emit(c, JsonWriter().add("event", "pong").str());
+        } else if (op == "stats") {
+            const WipeStats st = session_.stats();
+            emit(c, JsonWriter()
+                        .add("event", "stats")
+                        .add("files_wiped", st.files_wiped)
+                        .add("files_failed", st.files_failed)
+                        .add("bytes_overwritten", st.bytes_overwritten)
+                        .str());
+        } else if (op == "cancel") {
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lk(c->mu);
+                auto it = c->jobs.find(id);
+                if (it != c->jobs.end()) {
+                    it->second.request_stop();
+                    found = true;
+                }
+            }
+            if (!found) reply_error(c, id, "no such job");
+        } else if (op == "wipe") {
+            submit(c, req, id);
+        } else {
+            reply_error(c, id, "unknown op: " + op);
+        }
+    }
+
+    void submit(const ClientPtr& c, const JsonObject& req, const std::string& id) {
+        const std::string path = req.get_string("path");
+        if (id.empty() || path.empty()) {
+            reply_error(c, id, "wipe requires \"id\" and \"path\"");
+            return;
+        }
+        if (path[0] != '/') {
+            reply_error(c, id, "path must be absolute");
+            return;
+        }
+        // "file" (the default) never recurses; a directory job needs
+        // "kind":"dir" plus "yes" or "dry_run", as wipe-dir does.
+        const std::string kind = req.get_string("kind", "file");
+        const bool dry_run = req.get_bool("dry_run");
+        std::error_code ec;
+        const bool is_dir = fs::is_directory(fs::symlink_status(path, ec));
+        if (kind == "file") {
+            if (is_dir) {
+                reply_error(c, id, "path is a directory; wipe-dir (\"kind\":\"dir\") is required");
+                return;
+            }
+        } else if (kind == "dir") {
+            if (!is_dir) {
+                reply_error(c, id, "Path is not a directory");
+                return;
+            }
+            if (!dry_run && !req.get_bool("yes")) {
+                reply_error(c, id, "Safety stop: wipe-dir requires --dry-run (preview) or --yes (execute).");
+                return;
+            }
+        } else {
+            reply_error(c, id, "unknown kind: " + kind);
+            return;
+        }
+
+        WipeOptions opt;
+        opt.passes = static_cast<int>(req.get_int("passes", opt.passes));
+        const std::string pattern = req.get_string("pattern", "zeros");
+        if (pattern == "zeros") opt.pattern = Pattern::Zeros;
+        else if (pattern == "random") opt.pattern = Pattern::Random;
+        else {
+            reply_error(c, id, "unknown pattern: " + pattern);
+            return;
+        }
+
+        if (!take_token(*c)) {
+            reply_error(c, id, "rate limited");
+            return;
+        }
+
+        SubmitOptions so;
+        so.dry_run = dry_run;
+        so.priority = static_cast<int>(req.get_int("priority"));
+        const std::int64_t timeout_ms = req.get_int("timeout_ms");
+        if (timeout_ms > 0) {
+            so.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        }
+
+        StopSource stop;
+        so.stop_token = stop.get_token();
+        bool inserted;
+        {
+            std::lock_guard<std::mutex> lk(c->mu);
+            inserted = c->jobs.emplace(id, stop).second;
+        }
+        if (!inserted) {
+            reply_error(c, id, "duplicate job id");
+            return;
+        }
+
+        so.on_complete = [this, c, id](const WipeResult& r) {
+            {
+                std::lock_guard<std::mutex> lk(c->mu);
+                c->jobs.erase(id);
+            }
+            emit(c, JsonWriter()
+                        .add("event", "done")
+                        .add("id", id)
+                        .add("ok", r.ok)
+                        .add("message", r.message)
+                        .str());
+        };
+        emit(c, JsonWriter().add("event", "accepted").add("id", id).str());
+        // The kind checked above decides the job: a path that changes type
+        // before the worker opens it fails instead of switching modes.
+        if (is_dir) session_.submit_directory(path, opt, req.get_bool("yes"), so);
+        else session_.submit_file(path, opt, so);
+    }
+
+    DaemonOptions opt_;
+    WipeSession& session_;
+    int wake_w_;
+    double burst_;
+    double uid_burst_;
+    std::vector<ClientPtr> clients_;
+    std::unordered_map<uid_t, Bucket> uid_buckets_;
+};
+
+} // namespace
+
+int run_daemon(const DaemonOptions& opt) {
+    if (opt.socket_path.empty()) {
+        std::cerr << "Error: daemon requires --socket <path>\n";
+        return 2;
+    }
+
+    int wake[2];
+    if (::pipe(wake) != 0) {
+        std::cerr << "Error: pipe: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    set_nonblocking(wake[0]);
+    set_nonblocking(wake[1]);
+
+    std::string err;
+    const int lfd = net::listen_unix(opt.socket_path, err);
+    if (lfd < 0) {
+        std::cerr << "Error: " << err << "\n";
+        ::close(wake[0]);
+        ::close(wake[1]);
+        return 1;
+    }
+    set_nonblocking(lfd);
+
+    g_stop = 0;
+    g_wake_fd = wake[1];
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    {
+        SessionOptions so;
+        so.threads = opt.threads;
+        // Reset below, before `d`: draining jobs complete through d.emit().
+        std::unique_ptr<WipeSession> session(new WipeSession(so));
+        Daemon d(opt, *session, wake[1]);
+        std::cout << "securewipe daemon listening on " << opt.socket_path << " (" << session->threads()
+                  << " workers)" << std::endl;
+
+        std::vector<pollfd> fds;
+        while (!g_stop) {
+            auto& clients = d.clients();
+            fds.clear();
+            fds.push_back(pollfd{lfd, POLLIN, 0});
+            fds.push_back(pollfd{wake[0], POLLIN, 0});
+            for (const auto& c : clients) {
+                short ev = POLLIN;
+                if (d.wants_write(c)) ev |= POLLOUT;
+                fds.push_back(pollfd{c->fd, ev, 0});
+            }
+
+            if (::poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "Error: poll: " << std::strerror(errno) << "\n";
+                break;
+            }
+
+            if (fds[1].revents & POLLIN) {
+                char tmp[256];
+                while (::read(wake[0], tmp, sizeof(tmp)) > 0) {
+                }
+            }
+
+            // Existing clients first: `clients` and `fds[2..]` line up until accept.
+            std::vector<ClientPtr> alive;
+            alive.reserve(clients.size());
+            for (std::size_t i = 0; i < clients.size(); ++i) {
+                const ClientPtr& c = clients[i];
+                const short re = fds[i + 2].revents;
+                bool ok = true;
+                if (re & (POLLIN | POLLHUP | POLLERR)) ok = d.on_readable(c);
+                if (ok) ok = d.flush(c);
+                if (ok) alive.push_back(c);
+                else d.close_client(c);
+            }
+            clients.swap(alive);
+
+            if (fds[0].revents & POLLIN) {
+                for (;;) {
+                    const int cfd = ::accept(lfd, nullptr, nullptr);
+                    if (cfd < 0) break;
+                    d.add_client(cfd);
+                }
+            }
+        }
+
+        std::cout << "securewipe daemon shutting down; waiting for running jobs" << std::endl;
+        ::close(lfd);
+        ::unlink(opt.socket_path.c_str());
+        for (const auto& c : d.clients()) {
+            d.flush(c);
+            d.close_client(c);
+        }
+        session.reset();    // drains outstanding jobs
+    }
+
+    g_wake_fd = -1;
+    ::close(wake[0]);
+    ::close(wake[1]);
+    return 0;
+}
+
+WipeResult daemon_request(const std::string& socket_path, const std::string& path, const WipeOptions& opt,
+                          bool directory, bool dry_run, bool yes, int priority) {
+    WipeResult r;
+    std::string err;
+    const int fd = net::connect_unix(socket_path, err);
+    if (fd < 0) {
+        r.message = "Cannot reach daemon: " + err;
+        return r;
+    }
+
+    const std::string id = std::to_string(::getpid());
+    const std::string req = JsonWriter()
+                                .add("op", "wipe")
+                                .add("id", id)
+                                .add("path", path)
+                                .add("kind", directory ? "dir" : "file")
+                                .add("passes", opt.passes)
+                                .add("pattern", opt.pattern == Pattern::Random ? "random" : "zeros")
+                                .add("priority", priority)
+                                .add("dry_run", dry_run)
+                                .add("yes", yes)
+                                .str();
+    if (!net::send_line(fd, req)) {
+        ::close(fd);
+        r.message = "Failed to send request to daemon";
+        return r;
+    }
+
+    net::LineReader reader(fd);
+    std::string line;
+    r.message = "Daemon closed the connection";
+    while (reader.read_line(line)) {
+        JsonObject ev;
+        if (!ev.parse(line, err) || ev.get_string("id") != id) continue;
+        const std::string kind = ev.get_string("event");
+        if (kind == "done" || kind == "error") {
+            r.ok = (kind == "done") && ev.get_bool("ok");
+            r.message = ev.get_string("message");
+            break;
+        }
+    }
+    ::close(fd);
+    return r;
+}
+
+#else
+
+int run_daemon(const DaemonOptions&) {
+    std::cerr << "Error: daemon mode is not supported on this platform\n";
+    return 2;
+}
+
+WipeResult daemon_request(const std::string&, const std::string&, const WipeOptions&, bool, bool, bool, int) {
+    WipeResult r;
+    r.message = "daemon mode is not supported on this platform";
+    return r;
+}
+
+#endif
+
+} // namespace securewipe
@@ -0,0 +1,35 @@
+#pragma once
+// `securewipe daemon`: a warm WipeSession serving jobs over a Unix socket.
+//
+// Protocol: one JSON object per line in each direction.
+//   -> {"op":"wipe","id":"a1","path":"/abs/path","kind":"file","passes":1,
+//       "pattern":"zeros","priority":0,"dry_run":false,"yes":false,"timeout_ms":0}
+//   -> {"op":"cancel","id":"a1"}   {"op":"stats"}   {"op":"ping"}
+//   <- {"event":"accepted","id":"a1"}
+//   <- {"event":"done","id":"a1","ok":true,"message":"..."}
+//   <- {"event":"error","id":"a1","message":"..."}
+//   <- {"event":"stats",...}   {"event":"pong"}
+// Completion events stream back on the submitting connection as jobs finish.
+// "kind" is "file" (default; directories are refused, as by `wipe`) or "dir",
+// which like `wipe-dir` requires "yes" unless "dry_run".
+#include "secure_wipe.h"
+#include <string>
+
+namespace securewipe {
+
+struct DaemonOptions {
+    std::string socket_path;
+    unsigned threads = 0;       // session workers (0 = hardware concurrency)
+    double rate = 0;            // accepted jobs per second per connection (0 = unlimited)
+    double burst = 0;           // token bucket depth (0 = max(1, rate))
+    double uid_rate = 0;        // cap over all connections of one peer uid (0 = none)
+};
+
+// Serve until SIGINT/SIGTERM. Returns a process exit code.
+int run_daemon(const DaemonOptions& opt);
+
+// Submit one job to a running daemon and wait for its completion event.
+WipeResult daemon_request(const std::string& socket_path, const std::string& path, const WipeOptions& opt,
+                          bool directory, bool dry_run, bool yes, int priority);
+
+} // namespace securewipe
@@ -0,0 +1,245 @@
+#include "dir_index.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+namespace {
+
+const char kIndexMagic[8] = {'S', 'W', 'D', 'I', 'R', 'I', 'X', '1'};
+
+struct IndexHeader {
+    char magic[8];
+    std::uint32_t record_size;
+    std::uint32_t count;
+    std::uint64_t fingerprint;
+    std::uint64_t runs_since_full;
+    std::uint64_t names_size;
+};
+
+std::int64_t to_ns(std::int64_t sec, std::uint32_t nsec) {
+    return sec * 1000000000LL + nsec;
+}
+
+std::uint64_t fnv1a(std::uint64_t h, const std::string& s) {
+    for (const unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= 0xff;      // field separator
+    h *= 1099511628211ULL;
+    return h;
+}
+
+} // namespace
+
+std::uint64_t index_fingerprint(const std::string& root, const WipeOptions& opt) {
+    const FilterRules& rules = opt.filter;
+    std::error_code ec;
+    const fs::path canon = fs::weakly_canonical(fs::absolute(root, ec), ec);
+    std::uint64_t h = 14695981039346656037ULL;
+    h = fnv1a(h, ec ? root : canon.string());
+    for (const auto& p : rules.include) h = fnv1a(h, "+" + p);
+    for (const auto& p : rules.exclude) h = fnv1a(h, "-" + p);
+    h = fnv1a(h, std::to_string(rules.min_size) + "/" + std::to_string(rules.max_size) + "/" +
+                     std::to_string(rules.mtime_older_than) + "/" + std::to_string(rules.atime_older_than) + "/" +
+                     std::to_string(rules.owner_uid));
+    h = fnv1a(h, opt.one_file_system ? "xdev" : "");
+    std::vector<std::string> protect = opt.protect;
+    std::sort(protect.begin(), protect.end());
+    for (const auto& p : protect) h = fnv1a(h, "!" + p);
+    return h;
+}
+
+// --- DirIndex --------------------------------------------------------------
+
+DirIndex::~DirIndex() {
+    unmap();
+}
+
+void DirIndex::unmap() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (base_ && heap_.empty()) ::munmap(const_cast<unsigned char*>(base_), size_);
+#endif
+    heap_.clear();
+    base_ = nullptr;
+    size_ = 0;
+    records_ = nullptr;
+    names_ = nullptr;
+    count_ = 0;
+    runs_since_full_ = 0;
+}
+
+bool DirIndex::load(const std::string& path, std::uint64_t fingerprint) {
+    unmap();
+
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(IndexHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* m = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) return false;
+    base_ = static_cast<const unsigned char*>(m);
+    size_ = static_cast<std::size_t>(st.st_size);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    heap_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (heap_.size() < sizeof(IndexHeader)) {
+        heap_.clear();
+        return false;
+    }
+    base_ = heap_.data();
+    size_ = heap_.size();
+#endif
+
+    IndexHeader h;
+    std::memcpy(&h, base_, sizeof(h));
+    const std::uint64_t need = sizeof(IndexHeader) + static_cast<std::uint64_t>(h.count) * sizeof(DirRecord) + h.names_size;
+    if (std::memcmp(h.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || h.record_size != sizeof(DirRecord) ||
+        h.fingerprint != fingerprint || need != size_ || h.count == 0) {
+        unmap();
+        return false;
+    }
+    records_ = reinterpret_cast<const DirRecord*>(base_ + sizeof(IndexHeader));
+    names_ = reinterpret_cast<const char*>(records_ + h.count);
+
+    // Children must follow their parent, which also rules out cycles.
+    for (std::uint32_t i = 0; i < h.count; ++i) {
+        const DirRecord& r = records_[i];
+        const std::uint64_t child_end = static_cast<std::uint64_t>(r.first_child) + r.child_count;
+        if (static_cast<std::uint64_t>(r.name_off) + r.name_len > h.names_size ||
+            (r.child_count > 0 && (r.first_child <= i || child_end > h.count))) {
+            unmap();
+            return false;
+        }
+    }
+    count_ = h.count;
+    runs_since_full_ = h.runs_since_full;
+    return true;
+}
+
+std::string DirIndex::name(std::uint32_t i) const {
+    return std::string(names_ + records_[i].name_off, records_[i].name_len);
+}
+
+std::uint32_t DirIndex::find_child(std::uint32_t parent, const std::string& name) const {
+    if (parent == npos) return npos;
+    const DirRecord& p = records_[parent];
+    std::uint32_t lo = p.first_child, hi = p.first_child + p.child_count;
+    while (lo < hi) {
+        const std::uint32_t mid = lo + (hi - lo) / 2;
+        const DirRecord& r = records_[mid];
+        const int c = name.compare(0, std::string::npos, names_ + r.name_off, r.name_len);
+        if (c == 0) return mid;
+        if (c < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return npos;
+}
+
+bool DirIndex::unchanged(std::uint32_t i, const EntryInfo& info) const {
+    const DirRecord& r = records_[i];
+    return !(r.flags & kRacy) && r.dev == info.dev && r.ino == info.ino &&
+           r.mtime_ns == to_ns(info.mtime, info.mtime_nsec) && r.ctime_ns == to_ns(info.ctime, info.ctime_nsec);
+}
+
+// --- DirIndexBuilder -------------------------------------------------------
+
+std::uint32_t DirIndexBuilder::add(std::uint32_t parent, const std::string& name, const EntryInfo& info) {
+    Node n;
+    n.rec = DirRecord{};
+    n.rec.dev = info.dev;
+    n.rec.ino = info.ino;
+    n.rec.mtime_ns = to_ns(info.mtime, info.mtime_nsec);
+    n.rec.ctime_ns = to_ns(info.ctime, info.ctime_nsec);
+    // A change in the same second as the walk may not have moved the timestamps.
+    if (info.mtime >= racy_after_ || info.ctime >= racy_after_) n.rec.flags |= DirIndex::kRacy;
+    n.name = name;
+    const std::uint32_t id = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back(std::move(n));
+    if (parent != DirIndex::npos) nodes_[parent].children.push_back(id);
+    return id;
+}
+
+bool DirIndexBuilder::write(const std::string& path, std::uint64_t fingerprint, std::uint64_t runs_since_full,
+                            std::string& err) const {
+    if (nodes_.empty()) {
+        err = "empty index";
+        return false;
+    }
+
+    // Breadth-first from the root, children sorted by name.
+    std::vector<DirRecord> out;
+    std::string names;
+    out.reserve(nodes_.size());
+    std::vector<std::uint32_t> order{0};
+    out.push_back(nodes_[0].rec);
+    for (std::size_t pos = 0; pos < order.size(); ++pos) {
+        const Node& n = nodes_[order[pos]];
+        DirRecord& r = out[pos];
+        r.name_off = static_cast<std::uint32_t>(names.size());
+        r.name_len = static_cast<std::uint32_t>(n.name.size());
+        names += n.name;
+
+        std::vector<std::uint32_t> kids = n.children;
+        std::sort(kids.begin(), kids.end(),
+                  [this](std::uint32_t a, std::uint32_t b) { return nodes_[a].name < nodes_[b].name; });
+        r.first_child = static_cast<std::uint32_t>(order.size());
+        r.child_count = static_cast<std::uint32_t>(kids.size());
+        for (const std::uint32_t k : kids) {
+            order.push_back(k);
+            out.push_back(nodes_[k].rec);
+        }
+    }
+
+    IndexHeader h;
+    std::memcpy(h.magic, kIndexMagic, sizeof(kIndexMagic));
+    h.record_size = sizeof(DirRecord);
+    h.count = static_cast<std::uint32_t>(out.size());
+    h.fingerprint = fingerprint;
+    h.runs_since_full = runs_since_full;
+    h.names_size = names.size();
+
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        f.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size() * sizeof(DirRecord)));
+        f.write(names.data(), static_cast<std::streamsize>(names.size()));
+        f.flush();
+        if (!f) {
+            err = "Failed to write scan index: " + tmp;
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        err = "Failed to replace scan index: " + ec.message();
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace securewipe
@@ -0,0 +1,105 @@
+#pragma once
+// Persistent directory index for incremental re-scans.
+//
+// After each walk the directories that were traversed are written to an index
+// file: identity (dev, ino), mtime and ctime in nanoseconds, and how many
+// candidate files each one held. The next run maps the file and, for every
+// directory whose metadata still matches and that held no candidates, walks
+// the recorded child directories instead of reading the directory again.
+//
+// Directory mtimes do not propagate upwards, so children of an unchanged
+// directory are still visited (one stat each); only readdir and the per-entry
+// stats are saved. Directories modified within a second of the walk are
+// marked racy and always re-read.
+//
+// Layout (native endian; the file is private to one host):
+//   IndexHeader
+//   DirRecord[count]      breadth-first; children contiguous, sorted by name
+//   char names[names_size]
+#include "secure_wipe.h"
+#include "tree_walk.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+struct DirRecord {
+    std::uint64_t dev;
+    std::uint64_t ino;
+    std::int64_t mtime_ns;
+    std::int64_t ctime_ns;
+    std::uint32_t name_off;
+    std::uint32_t name_len;
+    std::uint32_t first_child;
+    std::uint32_t child_count;
+    std::uint32_t pending;      // candidate files seen in the directory
+    std::uint32_t flags;        // kRacy
+};
+
+class DirIndex {
+public:
+    static constexpr std::uint32_t npos = UINT32_MAX;
+    static constexpr std::uint32_t kRacy = 1;
+
+    DirIndex() = default;
+    ~DirIndex();
+    DirIndex(const DirIndex&) = delete;
+    DirIndex& operator=(const DirIndex&) = delete;
+
+    // Map `path`. Returns false (and stays empty) if it is missing, damaged or
+    // was written for a different root or rule set.
+    bool load(const std::string& path, std::uint64_t fingerprint);
+
+    bool empty() const { return count_ == 0; }
+    std::uint64_t runs_since_full() const { return runs_since_full_; }
+    std::uint32_t root() const { return count_ ? 0 : npos; }
+    const DirRecord& at(std::uint32_t i) const { return records_[i]; }
+    std::string name(std::uint32_t i) const;
+    std::uint32_t find_child(std::uint32_t parent, const std::string& name) const;
+
+    // Does `info` still describe the directory recorded at `i`?
+    bool unchanged(std::uint32_t i, const EntryInfo& info) const;
+
+private:
+    void unmap();
+
+    const unsigned char* base_ = nullptr;
+    std::size_t size_ = 0;
+    std::vector<unsigned char> heap_;   // fallback when the file cannot be mapped
+    const DirRecord* records_ = nullptr;
+    const char* names_ = nullptr;
+    std::uint32_t count_ = 0;
+    std::uint64_t runs_since_full_ = 0;
+};
+
+// Collects the directories of one walk and writes the next index.
+class DirIndexBuilder {
+public:
+    explicit DirIndexBuilder(std::int64_t racy_after) : racy_after_(racy_after) {}
+
+    // Returns the node id; parent is DirIndex::npos for the root.
+    std::uint32_t add(std::uint32_t parent, const std::string& name, const EntryInfo& info);
+    void set_pending(std::uint32_t node, std::uint32_t pending) { nodes_[node].rec.pending = pending; }
+    std::size_t size() const { return nodes_.size(); }
+
+    // Atomically replace `path` (write to a temporary file, then rename).
+    bool write(const std::string& path, std::uint64_t fingerprint, std::uint64_t runs_since_full,
+               std::string& err) const;
+
+private:
+    struct Node {
+        DirRecord rec;
+        std::string name;
+        std::vector<std::uint32_t> children;
+    };
+    std::vector<Node> nodes_;
+    std::int64_t racy_after_;
+};
+
+// Identifies the root and everything that prunes the walk below it: the
+// filter rules, --one-file-system and the extra protected paths.
+std::uint64_t index_fingerprint(const std::string& root, const WipeOptions& opt);
+
+} // namespace securewipe
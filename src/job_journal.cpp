@@ -0,0 +1,258 @@
+#include "job_journal.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+namespace {
+
+const char kJournalMagic[8] = {'S', 'W', 'J', 'R', 'N', 'L', '0', '1'};
+
+constexpr std::uint32_t kProgress = 1;
+constexpr std::uint32_t kDone = 2;
+
+struct JournalHeader {
+    char magic[8];
+    std::uint32_t record_size;
+    std::uint32_t reserved;
+    std::uint64_t fingerprint;
+};
+
+struct JournalRecord {
+    std::uint32_t type;
+    std::uint32_t pass;
+    std::uint64_t key;
+    std::uint64_t ino;
+    std::uint64_t size;
+    std::uint64_t offset;
+    std::uint64_t check;    // FNV-1a of the fields above
+};
+
+std::uint64_t fnv1a(std::uint64_t h, const void* p, std::size_t n) {
+    const unsigned char* b = static_cast<const unsigned char*>(p);
+    for (std::size_t i = 0; i < n; ++i) {
+        h ^= b[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+std::uint64_t record_check(const JournalRecord& r) {
+    return fnv1a(14695981039346656037ULL, &r, offsetof(JournalRecord, check));
+}
+
+// Push buffered data of `f` to stable storage.
+bool sync_file(std::FILE* f) {
+    if (std::fflush(f) != 0) return false;
+#if defined(__linux__)
+    return ::fdatasync(::fileno(f)) == 0;
+#elif defined(__unix__) || defined(__APPLE__)
+    return ::fsync(::fileno(f)) == 0;
+#elif defined(_WIN32)
+    return ::_commit(::_fileno(f)) == 0;
+#else
+    return true;
+#endif
+}
+
+// Make a rename in `dir` durable (best effort).
+void sync_dir(const fs::path& dir) {
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)dir;
+#endif
+}
+
+} // namespace
+
+std::uint64_t journal_path_hash(const std::string& path) {
+    return fnv1a(14695981039346656037ULL, path.data(), path.size());
+}
+
+std::uint64_t journal_fingerprint(const std::string& target, const WipeOptions& opt, std::uint64_t offset,
+                                  std::uint64_t length) {
+    std::error_code ec;
+    const fs::path canon = fs::weakly_canonical(fs::absolute(target, ec), ec);
+    const std::string t = ec ? target : canon.string();
+    std::uint64_t h = journal_path_hash(t);
+    const std::int64_t settings[2] = {opt.passes, static_cast<std::int64_t>(opt.pattern)};
+    h = fnv1a(h, settings, sizeof(settings));
+    if (offset == 0 && length == UINT64_MAX) return h;
+    const std::uint64_t range[2] = {offset, length};
+    return fnv1a(h, range, sizeof(range));
+}
+
+JobJournal::~JobJournal() {
+    close(false);
+}
+
+bool JobJournal::open(const JournalOptions& jo, std::uint64_t fingerprint, std::string& err) {
+    path_ = jo.path;
+    fingerprint_ = fingerprint;
+    checkpoint_ = std::max<std::uint64_t>(jo.checkpoint_bytes, 1);
+    sync_every_ = std::chrono::milliseconds(jo.sync_ms);
+
+    std::error_code ec;
+    const bool exists = fs::exists(path_, ec);
+    if (exists && !jo.resume) {
+        err = "Journal " + path_ + " belongs to an unfinished job; resume it or delete the file";
+        return false;
+    }
+    std::lock_guard<std::mutex> lk(mu_);
+    if (exists && !load(err)) return false;
+    // Start from a compact file: drops superseded records and a torn tail.
+    return rewrite(err);
+}
+
+bool JobJournal::load(std::string& err) {
+    std::FILE* f = std::fopen(path_.c_str(), "rb");
+    if (!f) {
+        err = "Failed to open journal " + path_ + ": " + std::strerror(errno);
+        return false;
+    }
+    JournalHeader h;
+    if (std::fread(&h, sizeof(h), 1, f) != 1 || std::memcmp(h.magic, kJournalMagic, 8) != 0 ||
+        h.record_size != sizeof(JournalRecord)) {
+        std::fclose(f);
+        err = path_ + " is not a wipe journal";
+        return false;
+    }
+    if (h.fingerprint != fingerprint_) {
+        std::fclose(f);
+        err = "Journal " + path_ + " was written for a different target or overwrite settings";
+        return false;
+    }
+
+    JournalRecord r;
+    while (std::fread(&r, sizeof(r), 1, f) == 1 && r.check == record_check(r)) {
+        if (r.type == kProgress) {
+            live_[r.key] = Entry{r.ino, r.size, r.pass, r.offset};
+        } else if (r.type == kDone) {
+            live_.erase(r.key);
+        }
+    }
+    std::fclose(f);
+    return true;
+}
+
+bool JobJournal::rewrite(std::string& err) {
+    const std::string tmp = path_ + ".tmp";
+    std::FILE* t = std::fopen(tmp.c_str(), "wb");
+    if (!t) {
+        err = "Failed to create journal " + tmp + ": " + std::strerror(errno);
+        return false;
+    }
+    JournalHeader h{};
+    std::memcpy(h.magic, kJournalMagic, 8);
+    h.record_size = sizeof(JournalRecord);
+    h.fingerprint = fingerprint_;
+    bool ok = std::fwrite(&h, sizeof(h), 1, t) == 1;
+    for (const auto& kv : live_) {
+        JournalRecord r{kProgress, kv.second.pass, kv.first, kv.second.ino, kv.second.size, kv.second.offset, 0};
+        r.check = record_check(r);
+        ok = ok && std::fwrite(&r, sizeof(r), 1, t) == 1;
+    }
+    ok = sync_file(t) && ok;
+    ok = (std::fclose(t) == 0) && ok;
+    std::error_code ec;
+    if (ok) fs::rename(tmp, path_, ec);
+    if (!ok || ec) {
+        fs::remove(tmp, ec);
+        err = "Failed to write journal " + path_;
+        return false;
+    }
+    sync_dir(fs::path(path_).parent_path());
+
+    std::FILE* f = std::fopen(path_.c_str(), "ab");
+    if (!f) {
+        err = "Failed to open journal " + path_ + ": " + std::strerror(errno);
+        return false;
+    }
+    if (f_) std::fclose(f_);
+    f_ = f;
+    records_ = live_.size();
+    dirty_ = false;
+    last_sync_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void JobJournal::append(std::uint32_t type, std::uint64_t key, const Entry& e) {
+    if (!f_) return;
+    JournalRecord r{type, e.pass, key, e.ino, e.size, e.offset, 0};
+    r.check = record_check(r);
+    // A lost record only means more work is redone on resume.
+    std::fwrite(&r, sizeof(r), 1, f_);
+    ++records_;
+    dirty_ = true;
+
+    std::string err;
+    if (records_ >= std::max<std::uint64_t>(1024, 4 * live_.size()) && rewrite(err)) return;
+    if (std::chrono::steady_clock::now() - last_sync_ >= sync_every_) sync();
+}
+
+void JobJournal::sync() {
+    sync_file(f_);
+    dirty_ = false;
+    last_sync_ = std::chrono::steady_clock::now();
+}
+
+void JobJournal::resume_point(const JournalKey& k, int& pass, std::uint64_t& offset) {
+    pass = 1;
+    offset = 0;
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = live_.find(k.path);
+    if (it == live_.end() || it->second.ino != k.ino || it->second.size != k.size) return;
+    pass = static_cast<int>(it->second.pass);
+    offset = it->second.offset;
+    ++resumed_;
+}
+
+bool JobJournal::started(std::uint64_t path_hash) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return live_.count(path_hash) != 0;
+}
+
+void JobJournal::progress(const JournalKey& k, int pass, std::uint64_t offset) {
+    std::lock_guard<std::mutex> lk(mu_);
+    const Entry e{k.ino, k.size, static_cast<std::uint32_t>(pass), offset};
+    live_[k.path] = e;
+    append(kProgress, k.path, e);
+}
+
+void JobJournal::done(const JournalKey& k) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (live_.erase(k.path) == 0) return;
+    append(kDone, k.path, Entry{k.ino, k.size, 0, 0});
+}
+
+void JobJournal::close(bool remove) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (f_) {
+        if (dirty_) sync();
+        std::fclose(f_);
+        f_ = nullptr;
+    }
+    if (remove && !path_.empty()) {
+        std::error_code ec;
+        fs::remove(path_, ec);
+    }
+}
+
+} // namespace securewipe
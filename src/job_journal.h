@@ -0,0 +1,101 @@
+#pragma once
+// Crash-safe progress journal for long wipe jobs.
+//
+// A finished file is deleted, so a re-run never sees it again; what is lost
+// when a job is killed is the progress inside large files. The journal is an
+// append-only log of (pass, offset) checkpoints for files bigger than one
+// checkpoint interval, and a "done" record once such a file is deleted. Small
+// files never appear in it, which keeps it tiny however many files the job
+// has. Checkpoints are only logged after the file data before them has been
+// synced, so a resumed file never has an old gap behind its checkpoint.
+//
+// The log is fsync'd at most every sync_ms and rewritten with only the live
+// entries (compacted) whenever it holds several times more records than
+// that. A torn record at the tail (crash during append) is ignored on load.
+// The journal is removed when its job completes.
+//
+// Layout (native endian; the file is private to one host):
+//   JournalHeader
+//   JournalRecord...      appended; each carries a checksum
+#include "secure_wipe.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace securewipe {
+
+// Identity of one file: path hash, plus inode and size so that progress is
+// never applied to a different file that took the same name.
+struct JournalKey {
+    std::uint64_t path = 0;
+    std::uint64_t ino = 0;
+    std::uint64_t size = 0;
+};
+
+class JobJournal {
+public:
+    JobJournal() = default;
+    ~JobJournal();
+    JobJournal(const JobJournal&) = delete;
+    JobJournal& operator=(const JobJournal&) = delete;
+
+    // Create the journal, or with jo.resume load an existing one for the
+    // same job (a missing file starts fresh). Refuses to clobber the journal
+    // of an interrupted job unless resuming.
+    bool open(const JournalOptions& jo, std::uint64_t fingerprint, std::string& err);
+
+    std::uint64_t checkpoint_bytes() const { return checkpoint_; }
+    std::uint64_t resumed() const { return resumed_.load(); }
+
+    // Where to start overwriting `k`: 1-based pass and offset within it.
+    void resume_point(const JournalKey& k, int& pass, std::uint64_t& offset);
+    // Whether progress is recorded for the path with this hash, i.e. an
+    // earlier run of the job began overwriting it.
+    bool started(std::uint64_t path_hash) const;
+    // Data of `k` is durable up to (pass, offset).
+    void progress(const JournalKey& k, int pass, std::uint64_t offset);
+    // `k` was deleted.
+    void done(const JournalKey& k);
+
+    // Flush and close; `remove` deletes the file (the job completed).
+    void close(bool remove);
+
+private:
+    struct Entry {
+        std::uint64_t ino;
+        std::uint64_t size;
+        std::uint32_t pass;
+        std::uint64_t offset;
+    };
+
+    bool load(std::string& err);
+    bool rewrite(std::string& err);     // compaction; mu_ held
+    void append(std::uint32_t type, std::uint64_t key, const Entry& e);
+    void sync();
+
+    mutable std::mutex mu_;
+    std::string path_;
+    std::FILE* f_ = nullptr;
+    std::uint64_t fingerprint_ = 0;
+    std::uint64_t checkpoint_ = 0;
+    std::chrono::milliseconds sync_every_{0};
+    std::chrono::steady_clock::time_point last_sync_;
+    bool dirty_ = false;
+    std::uint64_t records_ = 0;         // records in the file
+    std::unordered_map<std::uint64_t, Entry> live_;
+    std::atomic<std::uint64_t> resumed_{0};
+};
+
+// Identifies the job a journal belongs to: target, overwrite settings and,
+// for a ranged wipe, the range.
+std::uint64_t journal_fingerprint(const std::string& target, const WipeOptions& opt, std::uint64_t offset = 0,
+                                  std::uint64_t length = UINT64_MAX);
+
+// Hash used for JournalKey::path.
+std::uint64_t journal_path_hash(const std::string& path);
+
+} // namespace securewipe
@@ -0,0 +1,298 @@
+#include "line_json.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace securewipe {
+
+namespace {
+
+struct Parser {
+    const std::string& s;
+    std::size_t i = 0;
+
+    void ws() {
+        while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n')) ++i;
+    }
+    bool eat(char c) {
+        ws();
+        if (i < s.size() && s[i] == c) {
+            ++i;
+            return true;
+        }
+        return false;
+    }
+
+    static void put_utf8(std::string& out, unsigned cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool hex4(unsigned& cp) {
+        if (i + 4 > s.size()) return false;
+        cp = 0;
+        for (int k = 0; k < 4; ++k) {
+            const char c = s[i++];
+            cp <<= 4;
+            if (c >= '0' && c <= '9') cp |= c - '0';
+            else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+
+    bool string(std::string& out) {
+        if (!eat('"')) return false;
+        out.clear();
+        while (i < s.size()) {
+            const char c = s[i++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (i >= s.size()) return false;
+            const char e = s[i++];
+            switch (e) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned cp;
+                if (!hex4(cp)) return false;
+                if (cp >= 0xD800 && cp < 0xDC00 && i + 1 < s.size() && s[i] == '\\' && s[i + 1] == 'u') {
+                    i += 2;
+                    unsigned lo;
+                    if (!hex4(lo) || lo < 0xDC00 || lo > 0xDFFF) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                put_utf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool number(std::string& out) {
+        ws();
+        const std::size_t b = i;
+        if (i < s.size() && s[i] == '-') ++i;
+        while (i < s.size() && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.' || s[i] == 'e' ||
+                                s[i] == 'E' || s[i] == '+' || s[i] == '-')) {
+            ++i;
+        }
+        out = s.substr(b, i - b);
+        return !out.empty() && out != "-";
+    }
+
+    bool literal(const char* word) {
+        ws();
+        std::size_t n = 0;
+        while (word[n]) ++n;
+        if (s.compare(i, n, word) != 0) return false;
+        i += n;
+        return true;
+    }
+};
+
+} // namespace
+
+bool JsonObject::parse(const std::string& text, std::string& err) {
+    values_.clear();
+    Parser p{text};
+    if (!p.eat('{')) {
+        err = "expected '{'";
+        return false;
+    }
+    if (p.eat('}')) return true;
+    for (;;) {
+        std::string k;
+        if (!p.string(k)) {
+            err = "expected key";
+            return false;
+        }
+        if (!p.eat(':')) {
+            err = "expected ':'";
+            return false;
+        }
+        p.ws();
+        Value v;
+        const char c = p.i < text.size() ? text[p.i] : '\0';
+        bool ok;
+        if (c == '"') {
+            v.kind = Kind::String;
+            ok = p.string(v.text);
+        } else if (c == 't' || c == 'f') {
+            v.kind = Kind::Bool;
+            ok = p.literal(c == 't' ? "true" : "false");
+            v.text = (c == 't') ? "true" : "false";
+        } else if (c == 'n') {
+            v.kind = Kind::Null;
+            ok = p.literal("null");
+        } else if (c == '[') {
+            v.kind = Kind::Array;
+            ++p.i;
+            ok = true;
+            if (!p.eat(']')) {
+                for (;;) {
+                    std::string num;
+                    if (!p.number(num)) {
+                        ok = false;
+                        break;
+                    }
+                    if (!v.text.empty()) v.text += ',';
+                    v.text += num;
+                    if (p.eat(']')) break;
+                    if (!p.eat(',')) {
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+        } else {
+            v.kind = Kind::Number;
+            ok = p.number(v.text);
+        }
+        if (!ok) {
+            err = "bad value for '" + k + "'";
+            return false;
+        }
+        values_[k] = std::move(v);
+        if (p.eat('}')) break;
+        if (!p.eat(',')) {
+            err = "expected ',' or '}'";
+            return false;
+        }
+    }
+    p.ws();
+    if (p.i != text.size()) {
+        err = "trailing data";
+        return false;
+    }
+    return true;
+}
+
+std::string JsonObject::get_string(const std::string& key, const std::string& def) const {
+    auto it = values_.find(key);
+    if (it == values_.end() || it->second.kind != Kind::String) return def;
+    return it->second.text;
+}
+
+std::int64_t JsonObject::get_int(const std::string& key, std::int64_t def) const {
+    auto it = values_.find(key);
+    if (it == values_.end() || it->second.kind != Kind::Number) return def;
+    return std::strtoll(it->second.text.c_str(), nullptr, 10);
+}
+
+std::uint64_t JsonObject::get_uint(const std::string& key, std::uint64_t def) const {
+    auto it = values_.find(key);
+    if (it == values_.end() || it->second.kind != Kind::Number || it->second.text[0] == '-') return def;
+    return std::strtoull(it->second.text.c_str(), nullptr, 10);
+}
+
+bool JsonObject::get_bool(const std::string& key, bool def) const {
+    auto it = values_.find(key);
+    if (it == values_.end() || it->second.kind != Kind::Bool) return def;
+    return it->second.text == "true";
+}
+
+std::vector<std::uint64_t> JsonObject::get_uint_array(const std::string& key) const {
+    std::vector<std::uint64_t> out;
+    auto it = values_.find(key);
+    if (it == values_.end() || it->second.kind != Kind::Array) return out;
+    const char* p = it->second.text.c_str();
+    while (*p) {
+        char* end;
+        const std::uint64_t v = std::strtoull(p, &end, 10);
+        if (end == p) break;
+        out.push_back(v);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return out;
+}
+
+void json_quote(std::string& out, const std::string& s) {
+    out += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char tmp[8];
+                std::snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+                out += tmp;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+void JsonWriter::key(const std::string& k) {
+    if (buf_.size() > 1) buf_ += ',';
+    json_quote(buf_, k);
+    buf_ += ':';
+}
+
+JsonWriter& JsonWriter::add(const std::string& k, const std::string& v) {
+    key(k);
+    json_quote(buf_, v);
+    return *this;
+}
+
+JsonWriter& JsonWriter::add(const std::string& k, std::int64_t v) {
+    key(k);
+    buf_ += std::to_string(v);
+    return *this;
+}
+
+JsonWriter& JsonWriter::add(const std::string& k, std::uint64_t v) {
+    key(k);
+    buf_ += std::to_string(v);
+    return *this;
+}
+
+JsonWriter& JsonWriter::add(const std::string& k, bool v) {
+    key(k);
+    buf_ += v ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::add(const std::string& k, const std::vector<std::uint64_t>& v) {
+    key(k);
+    buf_ += '[';
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        if (i) buf_ += ',';
+        buf_ += std::to_string(v[i]);
+    }
+    buf_ += ']';
+    return *this;
+}
+
+} // namespace securewipe
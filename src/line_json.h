@@ -0,0 +1,51 @@
+#pragma once
+// Minimal JSON for the line-oriented socket protocols: one flat object per line
+// whose values are strings, numbers, booleans, null or arrays of numbers.
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+class JsonObject {
+public:
+    bool parse(const std::string& text, std::string& err);
+
+    bool has(const std::string& key) const { return values_.count(key) != 0; }
+    std::string get_string(const std::string& key, const std::string& def = std::string()) const;
+    std::int64_t get_int(const std::string& key, std::int64_t def = 0) const;
+    std::uint64_t get_uint(const std::string& key, std::uint64_t def = 0) const;
+    bool get_bool(const std::string& key, bool def = false) const;
+    std::vector<std::uint64_t> get_uint_array(const std::string& key) const;
+
+private:
+    enum class Kind { String, Number, Bool, Null, Array };
+    struct Value {
+        Kind kind;
+        std::string text;   // unescaped string, number literal, or comma-joined array
+    };
+    std::map<std::string, Value> values_;
+};
+
+// Builds one object; str() yields it without a trailing newline.
+class JsonWriter {
+public:
+    JsonWriter& add(const std::string& key, const std::string& v);
+    JsonWriter& add(const std::string& key, const char* v) { return add(key, std::string(v)); }
+    JsonWriter& add(const std::string& key, std::int64_t v);
+    JsonWriter& add(const std::string& key, std::uint64_t v);
+    JsonWriter& add(const std::string& key, int v) { return add(key, static_cast<std::int64_t>(v)); }
+    JsonWriter& add(const std::string& key, bool v);
+    JsonWriter& add(const std::string& key, const std::vector<std::uint64_t>& v);
+    std::string str() const { return buf_ + "}"; }
+
+private:
+    void key(const std::string& k);
+    std::string buf_ = "{";
+};
+
+// Append `s` to `out` as a quoted JSON string.
+void json_quote(std::string& out, const std::string& s);
+
+} // namespace securewipe
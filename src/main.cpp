@@ -1,20 +1,124 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <string>
 #include <vector>
 #include "secure_wipe.h"
+#include "audit_ledger.h"
+#include "cleaner.h"
+#include "cluster.h"
+#include "content_match.h"
+#include "daemon.h"
+#include "line_json.h"
+#include "output_sink.h"
+#include "path_filter.h"
+#include "path_list.h"
+#include "shard.h"
+#include "sqlite_scrub.h"
+#include "watch.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pwd.h>
+#endif
+
+// User name or numeric uid.
+static bool parse_owner(const std::string& s, std::int64_t& out) {
+    if (!s.empty() && s.find_first_not_of("0123456789") == std::string::npos) {
+        out = std::stoll(s);
+        return true;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    if (const struct passwd* pw = ::getpwnam(s.c_str())) {
+        out = pw->pw_uid;
+        return true;
+    }
+#endif
+    return false;
+}
+
+static bool parse_output(const std::string& s, securewipe::OutputFormat& out) {
+    if (s == "text") out = securewipe::OutputFormat::Text;
+    else if (s == "nul") out = securewipe::OutputFormat::Nul;
+    else if (s == "jsonl") out = securewipe::OutputFormat::Jsonl;
+    else return false;
+    return true;
+}
+
+// Final line of a command, after the per-path records. With --output nul it
+// goes to stderr (stdout carries only paths), with jsonl it is one more record.
+static int print_result(const securewipe::WipeResult& res, const char* failed) {
+    securewipe::OutputSink::flush_all();
+    const securewipe::OutputFormat f = securewipe::OutputSink::format();
+    if (f == securewipe::OutputFormat::Jsonl) {
+        std::cout << securewipe::JsonWriter().add("event", "summary").add("ok", res.ok).add("message", res.message).str()
+                  << "\n";
+    } else if (!res.ok) {
+        std::cerr << failed << res.message << "\n";
+    } else {
+        (f == securewipe::OutputFormat::Nul ? std::cerr : std::cout) << res.message << "\n";
+    }
+    return res.ok ? 0 : 1;
+}
+
 static void print_help() {
     std::cout <<
 R"(SecureWipe-Cpp (prototype)
 
 Usage:
   securewipe --help
-  securewipe wipe <path> [--passes N] [--pattern zeros|random]
-  securewipe wipe-dir <dir> [--passes N] [--pattern zeros|random] [--dry-run] [--yes]
+  securewipe wipe <path> [--passes N] [--pattern zeros|random] [--journal FILE [--resume] [--journal-sync MS]]
+                  [--protect PATH] [--ledger FILE [--ledger-commit MS]] [--daemon SOCKET [--priority N]]
+                  [--output text|nul|jsonl] [--dry-run]
+  securewipe wipe-range <file> [--offset N[K|M|G]] [--length N[K|M|G]] [--passes N] [--pattern zeros|random]
+                        [--delete] [--journal FILE [--resume] [--journal-sync MS]] [--protect PATH] [--ledger FILE]
+  securewipe wipe --from-file <list|-> [--jobs N] [--passes N] [--pattern zeros|random] [--dry-run]
+  securewipe wipe --from0 <list|-> [--jobs N] [--passes N] [--pattern zeros|random] [--dry-run]
+  securewipe wipe-dir <dir> [--passes N] [--pattern zeros|random] [--jobs N] [--dry-run] [--yes]
+  securewipe wipe-dir <dir> ... [--include PAT] [--exclude PAT] [--exclude-from FILE]
+                        [--min-size N[K|M|G]] [--max-size N[K|M|G]] [--mtime-older DUR]
+                        [--atime-older DUR] [--owner USER|UID] [--index FILE [--full-scan-every N]]
+                        [--journal FILE [--resume] [--journal-sync MS]] [--one-file-system]
+                        [--protect PATH] [--skip-open-files] [--if-contains STR] [--if-contains-from FILE]
+                        [--calibrate] [--ledger FILE [--ledger-commit MS]] [--daemon SOCKET [--priority N]]
+                        [--output text|nul|jsonl]
+  securewipe wipe-dir <dir> --yes --lease-dir <shared-dir> [--worker-id ID] [--lease-ttl SEC] [--shard-depth N]
+  securewipe clean --rules <pack> [--rules <pack>...] [--only ID[,ID...]] [--jobs N] [--protect PATH]
+                   [--list] [--dry-run] [--yes] [--output text|nul|jsonl]
+  securewipe ledger-verify <ledger>
+  securewipe sqlite-scrub <db> [--passes N] [--pattern zeros|random] [--freelist-only] [--dry-run] [--yes]
+  securewipe watch <dir> [--ttl DUR] [--jobs N] [--passes N] [--pattern zeros|random]
+                   [wipe-dir filters] [--dry-run] [--yes] [--output text|nul|jsonl]
+  securewipe daemon --socket <path> [--jobs N] [--rate JOBS_PER_SEC] [--burst N] [--uid-rate JOBS_PER_SEC]
+  securewipe agent [--listen HOST:PORT] [--jobs N] [--slots N] [--token T]
+  securewipe coordinate --agents HOST:PORT[,HOST:PORT...] [--token T] [--shard-depth N] [--agent-timeout DUR]
+                        [--passes N] [--pattern zeros|random] [--job FILE] [--dry-run] [--yes] <target>...
+
+Notes:
+  Filters use gitignore syntax; the last matching rule wins. DUR is N[s|m|h|d].
+  --from-file reads one path per line, --from0 NUL-delimited paths; '-' is stdin.
+  --lease-dir: processes sharing the directory split one tree; use a fresh one per job.
+  --index FILE skips directories unchanged since the previous run.
+  --journal FILE lets a killed job continue mid-file with --resume.
+  --ledger FILE keeps a hash-chained record of every overwrite; check it with ledger-verify.
+  --if-contains wipes only files containing one of the strings (\xHH escapes allowed).
+  --calibrate times a probe write per device for the dry-run plan.
+  --rate/--burst limit daemon jobs per connection; --uid-rate caps one uid overall.
+  coordinate needs a token ($SECUREWIPE_TOKEN); agents listen on 127.0.0.1:7421.
+  Protected system paths, $HOME and every --protect PATH are never wiped.
 
 Examples:
   securewipe wipe test.txt --passes 1 --pattern zeros
   securewipe wipe-dir ./tmp --dry-run
+  securewipe wipe-range app.log.1 --length 10M
   securewipe wipe-dir ./tmp --passes 1 --pattern zeros --yes
+  securewipe wipe-dir ./build --exclude '.git/' --include '*.o' --mtime-older 7d --yes
+  securewipe wipe-dir ./cache --dry-run --output nul | xargs -0 ls -l
+  find /scratch -name '*.tmp' -print0 | securewipe wipe --from0 - --jobs 8
+  securewipe clean --rules caches.pack --only thumbnails --dry-run
+  securewipe daemon --socket /run/securewipe.sock --jobs 8 &
+  securewipe wipe /tmp/secret.txt --daemon /run/securewipe.sock
 )";
 }
 
@@ -27,19 +131,324 @@ int main(int argc, char* argv[]) {
     }
 
     const std::string cmd = args[0];
-    if (cmd == "wipe" || cmd == "wipe-dir") {
+    if (cmd == "daemon") {
+        securewipe::DaemonOptions dopt;
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--socket" && i + 1 < args.size()) {
+                dopt.socket_path = args[++i];
+            } else if (args[i] == "--jobs" && i + 1 < args.size()) {
+                dopt.threads = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (args[i] == "--rate" && i + 1 < args.size()) {
+                dopt.rate = std::stod(args[++i]);
+            } else if (args[i] == "--burst" && i + 1 < args.size()) {
+                dopt.burst = std::stod(args[++i]);
+            } else if (args[i] == "--uid-rate" && i + 1 < args.size()) {
+                dopt.uid_rate = std::stod(args[++i]);
+            } else {
+                std::cerr << "Error: unknown option: " << args[i] << "\n";
+                return 2;
+            }
+        }
+        return securewipe::run_daemon(dopt);
+    }
+
+    if (cmd == "sqlite-scrub") {
+        if (args.size() < 2 || args[1].empty() || args[1][0] == '-') {
+            std::cerr << "Error: missing <db>\n\n";
+            print_help();
+            return 2;
+        }
+        securewipe::WipeOptions opt;
+        securewipe::SqliteScrubOptions so;
+        bool yes = false;
+        for (size_t i = 2; i < args.size(); ++i) {
+            if (args[i] == "--passes" && i + 1 < args.size()) {
+                opt.passes = std::stoi(args[++i]);
+            } else if (args[i] == "--pattern" && i + 1 < args.size()) {
+                const auto& p = args[++i];
+                if (p == "zeros") opt.pattern = securewipe::Pattern::Zeros;
+                else if (p == "random") opt.pattern = securewipe::Pattern::Random;
+                else {
+                    std::cerr << "Error: unknown pattern: " << p << "\n";
+                    return 2;
+                }
+            } else if (args[i] == "--freelist-only") {
+                so.freelist_only = true;
+            } else if (args[i] == "--dry-run") {
+                so.dry_run = true;
+            } else if (args[i] == "--yes") {
+                yes = true;
+            } else {
+                std::cerr << "Error: unknown option: " << args[i] << "\n";
+                return 2;
+            }
+        }
+        if (!so.dry_run && !yes) {
+            std::cerr << "Sqlite-scrub failed: Safety stop: sqlite-scrub requires --dry-run (preview) or --yes (execute).\n";
+            return 1;
+        }
+        auto res = securewipe::sqlite_scrub(args[1], opt, so);
+        if (!res.ok) {
+            std::cerr << "Sqlite-scrub failed: " << res.message << "\n";
+            return 1;
+        }
+        std::cout << res.message << "\n";
+        return 0;
+    }
+
+    if (cmd == "wipe-range") {
+        if (args.size() < 2 || args[1].empty() || args[1][0] == '-') {
+            std::cerr << "Error: missing <file>\n\n";
+            print_help();
+            return 2;
+        }
+        securewipe::WipeOptions opt;
+        std::uint64_t offset = 0;
+        std::uint64_t length = UINT64_MAX;
+        bool keep = true;
+        for (size_t i = 2; i < args.size(); ++i) {
+            if ((args[i] == "--offset" || args[i] == "--length") && i + 1 < args.size()) {
+                std::uint64_t& v = (args[i] == "--offset") ? offset : length;
+                if (!securewipe::parse_size(args[i + 1], v)) {
+                    std::cerr << "Error: bad size: " << args[i + 1] << "\n";
+                    return 2;
+                }
+                ++i;
+            } else if (args[i] == "--passes" && i + 1 < args.size()) {
+                opt.passes = std::stoi(args[++i]);
+            } else if (args[i] == "--pattern" && i + 1 < args.size()) {
+                const auto& p = args[++i];
+                if (p == "zeros") opt.pattern = securewipe::Pattern::Zeros;
+                else if (p == "random") opt.pattern = securewipe::Pattern::Random;
+                else {
+                    std::cerr << "Error: unknown pattern: " << p << "\n";
+                    return 2;
+                }
+            } else if (args[i] == "--delete") {
+                keep = false;
+            } else if (args[i] == "--journal" && i + 1 < args.size()) {
+                opt.journal.path = args[++i];
+            } else if (args[i] == "--resume") {
+                opt.journal.resume = true;
+            } else if (args[i] == "--journal-sync" && i + 1 < args.size()) {
+                opt.journal.sync_ms = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (args[i] == "--protect" && i + 1 < args.size()) {
+                opt.protect.push_back(args[++i]);
+            } else if (args[i] == "--ledger" && i + 1 < args.size()) {
+                opt.ledger.path = args[++i];
+            } else {
+                std::cerr << "Error: unknown option: " << args[i] << "\n";
+                return 2;
+            }
+        }
+        if (opt.journal.resume && opt.journal.path.empty()) {
+            std::cerr << "Error: --resume requires --journal FILE\n";
+            return 2;
+        }
+        auto res = securewipe::wipe_range(args[1], offset, length, opt, keep);
+        if (!res.ok) {
+            std::cerr << "Wipe-range failed: " << res.message << "\n";
+            return 1;
+        }
+        std::cout << res.message << "\n";
+        return 0;
+    }
+
+    if (cmd == "ledger-verify") {
+        if (args.size() != 2 || args[1].empty() || args[1][0] == '-') {
+            std::cerr << "Error: ledger-verify takes one <ledger>\n\n";
+            print_help();
+            return 2;
+        }
+        auto res = securewipe::verify_ledger(args[1]);
+        if (!res.ok) {
+            std::cerr << "Ledger-verify failed: " << res.message << "\n";
+            return 1;
+        }
+        std::cout << res.message << "\n";
+        return 0;
+    }
+
+    if (cmd == "clean") {
+        securewipe::RulePack pack;
+        securewipe::CleanOptions copt;
+        unsigned jobs = 0;
+        bool list = false;
+        bool yes = false;
+        bool have_rules = false;
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--rules" && i + 1 < args.size()) {
+                std::string err;
+                if (!securewipe::load_rule_pack(args[++i], pack, err)) {
+                    std::cerr << "Error: " << err << "\n";
+                    return 2;
+                }
+                have_rules = true;
+            } else if (args[i] == "--only" && i + 1 < args.size()) {
+                const std::string& ids = args[++i];
+                size_t b = 0;
+                while (b <= ids.size()) {
+                    const size_t e = std::min(ids.find(',', b), ids.size());
+                    if (e > b) copt.only.push_back(ids.substr(b, e - b));
+                    b = e + 1;
+                }
+            } else if (args[i] == "--jobs" && i + 1 < args.size()) {
+                jobs = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (args[i] == "--protect" && i + 1 < args.size()) {
+                copt.protect.push_back(args[++i]);
+            } else if (args[i] == "--list") {
+                list = true;
+            } else if (args[i] == "--output" && i + 1 < args.size()) {
+                securewipe::OutputFormat f;
+                if (!parse_output(args[++i], f)) {
+                    std::cerr << "Error: unknown output format: " << args[i] << "\n";
+                    return 2;
+                }
+                securewipe::OutputSink::set_format(f);
+            } else if (args[i] == "--dry-run") {
+                copt.dry_run = true;
+            } else if (args[i] == "--yes") {
+                yes = true;
+            } else {
+                std::cerr << "Error: unknown option: " << args[i] << "\n";
+                return 2;
+            }
+        }
+        if (!have_rules) {
+            std::cerr << "Error: clean needs --rules <pack>\n\n";
+            print_help();
+            return 2;
+        }
+        if (list) {
+            std::cout << securewipe::describe_rule_pack(pack);
+            return 0;
+        }
+        if (!copt.dry_run && !yes) {
+            std::cerr << "Clean failed: Safety stop: clean requires --dry-run (preview) or --yes (execute).\n";
+            return 1;
+        }
+        securewipe::SessionOptions so;
+        so.threads = jobs;
+        securewipe::WipeSession session(so);
+        return print_result(securewipe::run_clean(session, pack, copt), "Clean failed: ");
+    }
+
+    if (cmd == "agent") {
+        securewipe::AgentOptions aopt;
+        if (const char* t = std::getenv("SECUREWIPE_TOKEN")) aopt.token = t;
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--listen" && i + 1 < args.size()) {
+                aopt.listen = args[++i];
+            } else if (args[i] == "--jobs" && i + 1 < args.size()) {
+                aopt.threads = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (args[i] == "--slots" && i + 1 < args.size()) {
+                aopt.slots = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (args[i] == "--token" && i + 1 < args.size()) {
+                aopt.token = args[++i];
+            } else {
+                std::cerr << "Error: unknown option: " << args[i] << "\n";
+                return 2;
+            }
+        }
+        return securewipe::run_agent(aopt);
+    }
+
+    if (cmd == "coordinate") {
+        securewipe::CoordinatorOptions copt;
+        if (const char* t = std::getenv("SECUREWIPE_TOKEN")) copt.token = t;
+        securewipe::WipeOptions opt;
+        std::vector<std::string> targets;
+        bool dry_run = false;
+        bool yes = false;
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--agents" && i + 1 < args.size()) {
+                const std::string& list = args[++i];
+                size_t b = 0;
+                while (b <= list.size()) {
+                    const size_t e = std::min(list.find(',', b), list.size());
+                    if (e > b) copt.agents.push_back(list.substr(b, e - b));
+                    b = e + 1;
+                }
+            } else if (args[i] == "--token" && i + 1 < args.size()) {
+                copt.token = args[++i];
+            } else if (args[i] == "--shard-depth" && i + 1 < args.size()) {
+                copt.depth = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (args[i] == "--agent-timeout" && i + 1 < args.size()) {
+                if (!securewipe::parse_duration(args[i + 1], copt.agent_timeout) || copt.agent_timeout <= 0) {
+                    std::cerr << "Error: bad duration: " << args[i + 1] << "\n";
+                    return 2;
+                }
+                ++i;
+            } else if (args[i] == "--passes" && i + 1 < args.size()) {
+                opt.passes = std::stoi(args[++i]);
+            } else if (args[i] == "--pattern" && i + 1 < args.size()) {
+                const auto& p = args[++i];
+                if (p == "zeros") opt.pattern = securewipe::Pattern::Zeros;
+                else if (p == "random") opt.pattern = securewipe::Pattern::Random;
+                else {
+                    std::cerr << "Error: unknown pattern: " << p << "\n";
+                    return 2;
+                }
+            } else if (args[i] == "--job" && i + 1 < args.size()) {
+                securewipe::PathListReader reader;
+                std::string err, line;
+                if (!reader.open(args[++i], '\n', err)) {
+                    std::cerr << "Error: " << err << "\n";
+                    return 2;
+                }
+                while (reader.next(line)) targets.push_back(line);
+            } else if (args[i] == "--dry-run") {
+                dry_run = true;
+            } else if (args[i] == "--yes") {
+                yes = true;
+            } else if (!args[i].empty() && args[i][0] != '-') {
+                targets.push_back(args[i]);
+            } else {
+                std::cerr << "Error: unknown option: " << args[i] << "\n";
+                return 2;
+            }
+        }
+        if (copt.agents.empty() || targets.empty()) {
+            std::cerr << "Error: coordinate needs --agents and at least one target\n\n";
+            print_help();
+            return 2;
+        }
+        if (!dry_run && !yes) {
+            std::cerr << "Coordinate failed: Safety stop: coordinate requires --dry-run (preview) or --yes (execute).\n";
+            return 1;
+        }
+        auto res = securewipe::run_coordinator(copt, targets, opt, dry_run);
+        if (!res.ok) {
+            std::cerr << "Coordinate failed: " << res.message << "\n";
+            return 1;
+        }
+        std::cout << res.message << "\n";
+        return 0;
+    }
+
+    if (cmd == "wipe" || cmd == "wipe-dir" || cmd == "watch") {
         if (args.size() < 2) {
             std::cerr << "Error: missing <path>\n\n";
             print_help();
             return 2;
         }
-        const std::string path = args[1];
+        // Manifest mode has no positional path.
+        const bool has_path = !(cmd == "wipe" && (args[1] == "--from-file" || args[1] == "--from0"));
+        const std::string path = has_path ? args[1] : std::string();
 
         securewipe::WipeOptions opt;
         bool dry_run = false;
         bool yes = false;
+        unsigned jobs = 0;
+        std::string list_source;
+        char list_delim = '\n';
+        std::string daemon_socket;
+        int priority = 0;
+        securewipe::ShardOptions shard;
+        securewipe::WatchOptions watch;
+        const bool dir_cmd = cmd == "wipe-dir" || cmd == "watch";
 
-        for (size_t i = 2; i < args.size(); ++i) {
+        for (size_t i = has_path ? 2 : 1; i < args.size(); ++i) {
             if (args[i] == "--passes" && i + 1 < args.size()) {
                 opt.passes = std::stoi(args[i + 1]);
                 ++i;
@@ -52,6 +461,98 @@ int main(int argc, char* argv[]) {
                     return 2;
                 }
                 ++i;
+            } else if (args[i] == "--jobs" && i + 1 < args.size()) {
+                jobs = static_cast<unsigned>(std::stoul(args[i + 1]));
+                ++i;
+            } else if (cmd == "wipe" && (args[i] == "--from-file" || args[i] == "--from0") && i + 1 < args.size()) {
+                list_delim = (args[i] == "--from0") ? '\0' : '\n';
+                list_source = args[i + 1];
+                ++i;
+            } else if (args[i] == "--daemon" && i + 1 < args.size()) {
+                daemon_socket = args[++i];
+            } else if (args[i] == "--priority" && i + 1 < args.size()) {
+                priority = std::stoi(args[++i]);
+            } else if (cmd == "wipe-dir" && args[i] == "--lease-dir" && i + 1 < args.size()) {
+                shard.lease_dir = args[++i];
+            } else if (cmd == "wipe-dir" && args[i] == "--worker-id" && i + 1 < args.size()) {
+                shard.worker_id = args[++i];
+            } else if (cmd == "wipe-dir" && args[i] == "--lease-ttl" && i + 1 < args.size()) {
+                shard.lease_ttl = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (cmd == "wipe-dir" && args[i] == "--shard-depth" && i + 1 < args.size()) {
+                shard.depth = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (dir_cmd && args[i] == "--include" && i + 1 < args.size()) {
+                opt.filter.include.push_back(args[++i]);
+            } else if (dir_cmd && args[i] == "--exclude" && i + 1 < args.size()) {
+                opt.filter.exclude.push_back(args[++i]);
+            } else if (dir_cmd && args[i] == "--exclude-from" && i + 1 < args.size()) {
+                std::string err;
+                if (!securewipe::PathFilter::load_rules_file(args[++i], opt.filter.exclude, err)) {
+                    std::cerr << "Error: " << err << "\n";
+                    return 2;
+                }
+            } else if (dir_cmd && (args[i] == "--min-size" || args[i] == "--max-size") && i + 1 < args.size()) {
+                std::uint64_t& v = (args[i] == "--min-size") ? opt.filter.min_size : opt.filter.max_size;
+                if (!securewipe::parse_size(args[i + 1], v)) {
+                    std::cerr << "Error: bad size: " << args[i + 1] << "\n";
+                    return 2;
+                }
+                ++i;
+            } else if (dir_cmd && (args[i] == "--mtime-older" || args[i] == "--atime-older") && i + 1 < args.size()) {
+                std::int64_t& v = (args[i] == "--mtime-older") ? opt.filter.mtime_older_than : opt.filter.atime_older_than;
+                if (!securewipe::parse_duration(args[i + 1], v)) {
+                    std::cerr << "Error: bad duration: " << args[i + 1] << "\n";
+                    return 2;
+                }
+                ++i;
+            } else if (cmd == "wipe-dir" && args[i] == "--index" && i + 1 < args.size()) {
+                opt.index.path = args[++i];
+            } else if (cmd == "wipe-dir" && args[i] == "--full-scan-every" && i + 1 < args.size()) {
+                opt.index.full_scan_every = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (args[i] == "--protect" && i + 1 < args.size()) {
+                opt.protect.push_back(args[++i]);
+            } else if (args[i] == "--output" && i + 1 < args.size()) {
+                securewipe::OutputFormat f;
+                if (!parse_output(args[++i], f)) {
+                    std::cerr << "Error: unknown output format: " << args[i] << "\n";
+                    return 2;
+                }
+                securewipe::OutputSink::set_format(f);
+            } else if (cmd == "wipe-dir" && args[i] == "--one-file-system") {
+                opt.one_file_system = true;
+            } else if (cmd == "wipe-dir" && args[i] == "--calibrate") {
+                opt.calibrate = true;
+            } else if (cmd == "wipe-dir" && args[i] == "--skip-open-files") {
+                opt.skip_open_files = true;
+            } else if (cmd == "wipe-dir" && args[i] == "--if-contains" && i + 1 < args.size()) {
+                opt.if_contains.push_back(args[++i]);
+            } else if (cmd == "wipe-dir" && args[i] == "--if-contains-from" && i + 1 < args.size()) {
+                std::string err;
+                if (!securewipe::ContentMatcher::load_patterns_file(args[++i], opt.if_contains, err)) {
+                    std::cerr << "Error: " << err << "\n";
+                    return 2;
+                }
+            } else if (cmd != "watch" && args[i] == "--journal" && i + 1 < args.size()) {
+                opt.journal.path = args[++i];
+            } else if (cmd != "watch" && args[i] == "--resume") {
+                opt.journal.resume = true;
+            } else if (cmd != "watch" && args[i] == "--ledger" && i + 1 < args.size()) {
+                opt.ledger.path = args[++i];
+            } else if (cmd != "watch" && args[i] == "--ledger-commit" && i + 1 < args.size()) {
+                opt.ledger.commit_ms = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (cmd != "watch" && args[i] == "--journal-sync" && i + 1 < args.size()) {
+                opt.journal.sync_ms = static_cast<unsigned>(std::stoul(args[++i]));
+            } else if (dir_cmd && args[i] == "--owner" && i + 1 < args.size()) {
+                if (!parse_owner(args[i + 1], opt.filter.owner_uid)) {
+                    std::cerr << "Error: unknown user: " << args[i + 1] << "\n";
+                    return 2;
+                }
+                ++i;
+            } else if (cmd == "watch" && args[i] == "--ttl" && i + 1 < args.size()) {
+                if (!securewipe::parse_duration(args[i + 1], watch.ttl)) {
+                    std::cerr << "Error: bad duration: " << args[i + 1] << "\n";
+                    return 2;
+                }
+                ++i;
             } else if (args[i] == "--dry-run") {
                 dry_run = true;
             } else if (args[i] == "--yes") {
@@ -62,24 +563,113 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        if (cmd == "wipe") {
-            auto res = securewipe::wipe_file(path, opt);
-            if (!res.ok) {
-                std::cerr << "Wipe failed: " << res.message << "\n";
+        if (cmd == "watch") {
+            if (!dry_run && !yes) {
+                std::cerr << "Watch failed: Safety stop: watch requires --dry-run (preview) or --yes (execute).\n";
                 return 1;
             }
-            std::cout << res.message << "\n";
-            return 0;
+            if (!daemon_socket.empty()) {
+                std::cerr << "Error: watch does not support --daemon\n";
+                return 2;
+            }
+            watch.threads = jobs;
+            watch.dry_run = dry_run;
+            return securewipe::run_watch(path, opt, watch);
+        }
+
+        if ((!opt.filter.empty() || !opt.index.path.empty() || opt.one_file_system || opt.skip_open_files ||
+             !opt.if_contains.empty() || !opt.protect.empty()) &&
+            (!daemon_socket.empty() || !shard.lease_dir.empty())) {
+            std::cerr << "Error: filters, --index, --one-file-system, --skip-open-files, --if-contains and --protect "
+                         "cannot be combined with --daemon or --lease-dir\n";
+            return 2;
+        }
+        if (opt.journal.resume && opt.journal.path.empty()) {
+            std::cerr << "Error: --resume requires --journal FILE\n";
+            return 2;
+        }
+        if (!opt.ledger.path.empty() && !daemon_socket.empty()) {
+            std::cerr << "Error: --ledger cannot be combined with --daemon\n";
+            return 2;
+        }
+        if (!opt.journal.path.empty() && (!daemon_socket.empty() || !shard.lease_dir.empty() || !list_source.empty())) {
+            std::cerr << "Error: --journal cannot be combined with --daemon, --lease-dir or a path list\n";
+            return 2;
+        }
+
+        if (cmd == "wipe" && !list_source.empty()) {
+            securewipe::PathListReader reader;
+            std::string err;
+            if (!reader.open(list_source, list_delim, err)) {
+                std::cerr << "Error: " << err << "\n";
+                return 2;
+            }
+            securewipe::SessionOptions so;
+            so.threads = jobs;
+            securewipe::WipeSession session(so);
+            auto res = session.wipe_stream([&](std::string& p) { return reader.next(p); }, opt, 0, dry_run);
+            if (reader.error()) {
+                std::cerr << "Error: failed reading " << list_source << "\n";
+                return 1;
+            }
+            return print_result(res, "Wipe failed: ");
+        }
+        if (!has_path) {
+            std::cerr << "Error: missing <path>\n\n";
+            print_help();
+            return 2;
+        }
+
+        if (!daemon_socket.empty()) {
+            if (cmd == "wipe-dir" && !dry_run && !yes) {
+                std::cerr << "Wipe-dir failed: Safety stop: wipe-dir requires --dry-run (preview) or --yes (execute).\n";
+                return 1;
+            }
+            // The daemon has its own working directory.
+            std::error_code ec;
+            const std::string abs = std::filesystem::absolute(path, ec).string();
+            auto res = securewipe::daemon_request(daemon_socket, ec ? path : abs, opt, cmd == "wipe-dir", dry_run,
+                                                  yes, priority);
+            return print_result(res, cmd == "wipe" ? "Wipe failed: " : "Wipe-dir failed: ");
+        }
+
+        if (cmd == "wipe") {
+            if (dry_run) {
+                securewipe::SessionOptions so;
+                so.threads = 1;
+                securewipe::WipeSession session(so);
+                bool taken = false;
+                const auto one = [&](std::string& p) {
+                    if (taken) return false;
+                    taken = true;
+                    p = path;
+                    return true;
+                };
+                return print_result(session.wipe_stream(one, opt, 0, true), "Wipe failed: ");
+            }
+            return print_result(securewipe::wipe_file(path, opt), "Wipe failed: ");
         }
 
         // wipe-dir
-        auto res = securewipe::wipe_directory(path, opt, dry_run, yes);
-        if (!res.ok) {
-            std::cerr << "Wipe-dir failed: " << res.message << "\n";
-            return 1;
+        securewipe::WipeResult res;
+        if (!shard.lease_dir.empty() && !dry_run) {
+            if (!yes) {
+                std::cerr << "Wipe-dir failed: Safety stop: wipe-dir requires --dry-run (preview) or --yes (execute).\n";
+                return 1;
+            }
+            securewipe::SessionOptions so;
+            so.threads = jobs;
+            securewipe::WipeSession session(so);
+            res = securewipe::wipe_directory_sharded(session, path, opt, shard);
+        } else if (jobs > 0) {
+            securewipe::SessionOptions so;
+            so.threads = jobs;
+            securewipe::WipeSession session(so);
+            res = session.wipe_directory(path, opt, dry_run, yes);
+        } else {
+            res = securewipe::wipe_directory(path, opt, dry_run, yes);
         }
-        std::cout << res.message << "\n";
-        return 0;
+        return print_result(res, "Wipe-dir failed: ");
     }
 
     std::cerr << "Unknown command: " << cmd << "\n\n";
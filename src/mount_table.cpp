@@ -0,0 +1,142 @@
+#include "mount_table.h"
+#include <fstream>
+#include <initializer_list>
+#include <sstream>
+
+#if defined(__linux__)
+#include <sys/sysmacros.h>
+#endif
+
+namespace securewipe {
+
+namespace {
+
+bool is_octal(char c) {
+    return c >= '0' && c <= '7';
+}
+
+// mountinfo escapes space, tab, newline and backslash as \ooo.
+std::string unescape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '\\' && i + 3 < s.size() && is_octal(s[i + 1]) && is_octal(s[i + 2]) && is_octal(s[i + 3])) {
+            out += static_cast<char>(((s[i + 1] - '0') << 6) | ((s[i + 2] - '0') << 3) | (s[i + 3] - '0'));
+            i += 3;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+bool has_option(const std::string& opts, const char* opt) {
+    std::istringstream in(opts);
+    std::string o;
+    while (std::getline(in, o, ',')) {
+        if (o == opt) return true;
+    }
+    return false;
+}
+
+bool is_one_of(const std::string& type, std::initializer_list<const char*> types) {
+    for (const char* t : types) {
+        if (type == t) return true;
+    }
+    return false;
+}
+
+void classify(MountEntry& m) {
+    const std::string& t = m.fs_type;
+    m.network = is_one_of(t, {"nfs", "nfs4", "cifs", "smb3", "smbfs", "ceph", "glusterfs", "9p", "afs",
+                              "ncpfs", "lustre", "gpfs", "beegfs", "fuse.sshfs", "fuse.glusterfs",
+                              "fuse.s3fs", "fuse.rclone"});
+    m.pseudo = is_one_of(t, {"proc", "sysfs", "devtmpfs", "devpts", "cgroup", "cgroup2", "securityfs",
+                             "debugfs", "tracefs", "bpf", "configfs", "efivarfs", "pstore", "mqueue",
+                             "hugetlbfs", "binfmt_misc", "fusectl", "autofs", "rpc_pipefs", "nsfs"});
+    m.copy_on_write = is_one_of(t, {"btrfs", "zfs", "bcachefs"});
+}
+
+} // namespace
+
+const MountTable& MountTable::system() {
+    static const MountTable table = [] {
+        MountTable t;
+#if defined(__linux__)
+        t.load("/proc/self/mountinfo");
+#endif
+        return t;
+    }();
+    return table;
+}
+
+bool MountTable::load(const std::string& mountinfo) {
+    std::ifstream in(mountinfo);
+    if (!in) return false;
+
+    entries_.clear();
+    by_point_.clear();
+    by_dev_.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        // id parent major:minor root mount_point options [optional...] - type source super_options
+        std::istringstream fields(line);
+        std::string id, parent, devno, root, point, opts, f;
+        if (!(fields >> id >> parent >> devno >> root >> point >> opts)) continue;
+        while (fields >> f && f != "-") {}
+        MountEntry m;
+        if (f != "-" || !(fields >> m.fs_type)) continue;
+        fields >> m.source;
+
+        const std::size_t colon = devno.find(':');
+        if (colon == std::string::npos) continue;
+        const unsigned long major = std::stoul(devno.substr(0, colon));
+        const unsigned long minor = std::stoul(devno.substr(colon + 1));
+#if defined(__linux__)
+        m.dev = static_cast<std::uint64_t>(makedev(major, minor));
+#else
+        m.dev = (static_cast<std::uint64_t>(major) << 32) | minor;
+#endif
+        m.root = unescape(root);
+        m.mount_point = unescape(point);
+        m.source = unescape(m.source);
+        m.read_only = has_option(opts, "ro");
+        classify(m);
+
+        // Later lines are mounted on top of earlier ones at the same point.
+        by_point_[m.mount_point] = entries_.size();
+        by_dev_.emplace(m.dev, entries_.size());
+        entries_.push_back(std::move(m));
+    }
+    return true;
+}
+
+const MountEntry* MountTable::at_path(const std::string& abs) const {
+    auto it = by_point_.find(abs);
+    return it == by_point_.end() ? nullptr : &entries_[it->second];
+}
+
+const MountEntry* MountTable::containing(const std::string& abs) const {
+    std::string p = abs;
+    for (;;) {
+        if (const MountEntry* m = at_path(p.empty() ? "/" : p)) return m;
+        const std::size_t slash = p.find_last_of('/');
+        if (p.empty() || slash == std::string::npos) return nullptr;
+        p.resize(slash);
+    }
+}
+
+const MountEntry* MountTable::by_dev(std::uint64_t dev) const {
+    auto it = by_dev_.find(dev);
+    return it == by_dev_.end() ? nullptr : &entries_[it->second];
+}
+
+bool MountTable::has_mounts_below(const std::string& abs) const {
+    const std::string prefix = (abs == "/") ? abs : abs + "/";
+    for (const auto& kv : by_point_) {
+        if (kv.first.size() > prefix.size() && kv.first.compare(0, prefix.size(), prefix) == 0) return true;
+    }
+    return false;
+}
+
+} // namespace securewipe
@@ -0,0 +1,50 @@
+#pragma once
+// Mount table, parsed once from /proc/self/mountinfo (Linux; empty elsewhere).
+//
+// Tells the directory walk where mount points are (a bind mount of the same
+// filesystem has no st_dev change to notice) and gives the per-filesystem
+// strategy the type of the filesystem a file lives on.
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace securewipe {
+
+struct MountEntry {
+    std::uint64_t dev = 0;          // st_dev of files on this mount
+    std::string mount_point;        // absolute
+    std::string root;               // subtree mounted here; not "/" for bind mounts
+    std::string fs_type;
+    std::string source;
+    bool read_only = false;
+    bool network = false;           // nfs, cifs, ...: every byte crosses the network
+    bool pseudo = false;            // proc, sysfs, ...: nothing on it is a user file
+    bool copy_on_write = false;     // btrfs, zfs, ...: overwrites land in new blocks
+};
+
+class MountTable {
+public:
+    // The table of this process, loaded on first use.
+    static const MountTable& system();
+
+    // Parse a mountinfo file. Returns false if it cannot be read.
+    bool load(const std::string& mountinfo);
+
+    bool empty() const { return entries_.empty(); }
+    const std::vector<MountEntry>& entries() const { return entries_; }
+    // The mount whose mount point is exactly `abs`, if any.
+    const MountEntry* at_path(const std::string& abs) const;
+    // The mount holding `abs` (longest mount point prefix).
+    const MountEntry* containing(const std::string& abs) const;
+    const MountEntry* by_dev(std::uint64_t dev) const;
+    // Whether any mount point lies strictly below `abs`.
+    bool has_mounts_below(const std::string& abs) const;
+
+private:
+    std::vector<MountEntry> entries_;                           // mountinfo order
+    std::unordered_map<std::string, std::size_t> by_point_;     // topmost mount at each point
+    std::unordered_map<std::uint64_t, std::size_t> by_dev_;     // first mount of each device
+};
+
+} // namespace securewipe
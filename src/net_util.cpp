@@ -0,0 +1,254 @@
+#include "net_util.h"
+#include <cerrno>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace securewipe {
+namespace net {
+
+bool LineBuffer::next_line(std::string& out) {
+    const std::size_t nl = buf_.find('\n', pos_);
+    if (nl == std::string::npos) {
+        // Compact once everything before pos_ has been consumed.
+        if (pos_ > 0) {
+            buf_.erase(0, pos_);
+            pos_ = 0;
+        }
+        return false;
+    }
+    out.assign(buf_, pos_, nl - pos_);
+    pos_ = nl + 1;
+    if (pos_ == buf_.size()) {
+        buf_.clear();
+        pos_ = 0;
+    }
+    return true;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+static std::string errstr(const char* prefix) {
+    return std::string(prefix) + ": " + std::strerror(errno);
+}
+
+static bool make_addr(const std::string& path, sockaddr_un& addr, std::string& err) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        err = "Socket path too long: " + path;
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static int unix_socket(std::string& err) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        err = errstr("socket");
+        return -1;
+    }
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+int listen_unix(const std::string& path, std::string& err) {
+    sockaddr_un addr;
+    if (!make_addr(path, addr, err)) return -1;
+
+    // Replace a stale socket left by a previous run, but never a live one.
+    std::string probe_err;
+    int probe = connect_unix(path, probe_err);
+    if (probe >= 0) {
+        ::close(probe);
+        err = "Another daemon is already listening on " + path;
+        return -1;
+    }
+    struct stat st;
+    if (::lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            err = path + " exists and is not a socket";
+            return -1;
+        }
+        ::unlink(path.c_str());
+    }
+
+    int fd = unix_socket(err);
+    if (fd < 0) return -1;
+
+    // Owner-only: the daemon wipes whatever it is told to.
+    const mode_t old_mask = ::umask(0077);
+    const int rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::umask(old_mask);
+    if (rc != 0 || ::listen(fd, 64) != 0) {
+        err = errstr("bind/listen");
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connect_unix(const std::string& path, std::string& err) {
+    sockaddr_un addr;
+    if (!make_addr(path, addr, err)) return -1;
+    int fd = unix_socket(err);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        err = errstr("connect");
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool split_host_port(const std::string& addr, std::string& host, std::string& port, std::string& err) {
+    const std::size_t colon = addr.rfind(':');
+    if (colon == std::string::npos || colon + 1 == addr.size()) {
+        err = "Expected host:port, got " + addr;
+        return false;
+    }
+    host = addr.substr(0, colon);
+    port = addr.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+    if (host.empty()) host = "127.0.0.1";
+    return true;
+}
+
+static int tcp_socket(const std::string& addr, bool listening, std::string& err) {
+    std::string host, port;
+    if (!split_host_port(addr, host, port, err)) return -1;
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (listening) hints.ai_flags = AI_PASSIVE;
+    addrinfo* res = nullptr;
+    const int rc = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+    if (rc != 0) {
+        err = "Cannot resolve " + addr + ": " + ::gai_strerror(rc);
+        return -1;
+    }
+
+    int fd = -1;
+    err = "No usable address for " + addr;
+    for (addrinfo* ai = res; ai; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        const int one = 1;
+        bool ok;
+        if (listening) {
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            ok = ::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, 64) == 0;
+        } else {
+            ok = ::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+            if (ok) ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        if (ok) break;
+        err = errstr(listening ? "bind/listen" : "connect");
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(res);
+    return fd;
+}
+
+int listen_tcp(const std::string& addr, std::string& err) {
+    return tcp_socket(addr, true, err);
+}
+
+int connect_tcp(const std::string& addr, std::string& err) {
+    return tcp_socket(addr, false, err);
+}
+
+bool write_all(int fd, const char* data, std::size_t n) {
+    while (n > 0) {
+#if defined(MSG_NOSIGNAL)
+        const ssize_t w = ::send(fd, data, n, MSG_NOSIGNAL);
+#else
+        const ssize_t w = ::write(fd, data, n);
+#endif
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+void close_fd(int fd) {
+    if (fd >= 0) ::close(fd);
+}
+
+bool set_recv_timeout(int fd, unsigned ms) {
+    timeval tv;
+    tv.tv_sec = static_cast<time_t>(ms / 1000);
+    tv.tv_usec = static_cast<suseconds_t>((ms % 1000) * 1000);
+    return ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0;
+}
+
+bool LineReader::read_line(std::string& out) {
+    char tmp[4096];
+    while (!buf_.next_line(out)) {
+        const ssize_t n = ::read(fd_, tmp, sizeof(tmp));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf_.append(tmp, static_cast<std::size_t>(n));
+    }
+    return true;
+}
+
+#else
+
+int listen_unix(const std::string&, std::string& err) {
+    err = "Unix sockets are not supported on this platform";
+    return -1;
+}
+
+int connect_unix(const std::string&, std::string& err) {
+    err = "Unix sockets are not supported on this platform";
+    return -1;
+}
+
+int listen_tcp(const std::string&, std::string& err) {
+    err = "TCP sockets are not supported on this platform";
+    return -1;
+}
+
+int connect_tcp(const std::string&, std::string& err) {
+    err = "TCP sockets are not supported on this platform";
+    return -1;
+}
+
+bool write_all(int, const char*, std::size_t) {
+    return false;
+}
+
+void close_fd(int) {}
+
+bool set_recv_timeout(int, unsigned) {
+    return false;
+}
+
+bool LineReader::read_line(std::string&) {
+    return false;
+}
+
+#endif
+
+} // namespace net
+} // namespace securewipe
@@ -0,0 +1,52 @@
+#pragma once
+// Small POSIX socket helpers for the daemon and coordinator protocols.
+#include <cstddef>
+#include <string>
+
+namespace securewipe {
+namespace net {
+
+// All return -1 and set `err` on failure. Sockets are close-on-exec.
+int listen_unix(const std::string& path, std::string& err);
+int connect_unix(const std::string& path, std::string& err);
+
+// `addr` is "host:port"; an empty host listens on 127.0.0.1.
+int listen_tcp(const std::string& addr, std::string& err);
+int connect_tcp(const std::string& addr, std::string& err);
+
+bool write_all(int fd, const char* data, std::size_t n);
+inline bool send_line(int fd, std::string line) {
+    line += '\n';
+    return write_all(fd, line.data(), line.size());
+}
+
+void close_fd(int fd);
+
+// Blocking reads on `fd` fail after `ms` milliseconds without data (0 = never).
+bool set_recv_timeout(int fd, unsigned ms);
+
+// Splits a byte stream into '\n'-terminated lines.
+class LineBuffer {
+public:
+    void append(const char* data, std::size_t n) { buf_.append(data, n); }
+    bool next_line(std::string& out);
+    std::size_t pending() const { return buf_.size() - pos_; }
+
+private:
+    std::string buf_;
+    std::size_t pos_ = 0;
+};
+
+// Blocking line reader over a socket. Returns false on EOF or error.
+class LineReader {
+public:
+    explicit LineReader(int fd) : fd_(fd) {}
+    bool read_line(std::string& out);
+
+private:
+    int fd_;
+    LineBuffer buf_;
+};
+
+} // namespace net
+} // namespace securewipe
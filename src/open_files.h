@@ -0,0 +1,29 @@
+#pragma once
+// Files held open by running processes, from one scan of /proc (Linux).
+//
+// Every /proc/<pid>/fd entry that resolves to a regular file, and every
+// file mapped in /proc/<pid>/maps, is recorded by (dev, ino). PIDs are
+// spread over a few threads, so a scan of a busy host takes milliseconds.
+// Without root only the caller's own processes are visible.
+#include "tree_walk.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace securewipe {
+
+class OpenFileIndex {
+public:
+    // Scan once, skipping this process. Returns false where /proc is
+    // unavailable; the index is then empty.
+    bool scan(unsigned threads = 0);
+
+    bool contains(std::uint64_t dev, std::uint64_t ino) const { return files_.contains(dev, ino); }
+    std::size_t files() const { return files_.size(); }
+    std::size_t processes() const { return processes_; }
+
+private:
+    InodeMap files_;
+    std::size_t processes_ = 0;
+};
+
+} // namespace securewipe
@@ -0,0 +1,223 @@
+#include "output_sink.h"
+#include "line_json.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <thread>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace securewipe {
+
+namespace {
+
+constexpr std::size_t kChunk = 64 << 10;          // hand a thread's buffer over at this size
+constexpr std::size_t kMaxQueued = 8 << 20;       // producers wait beyond this (slow consumer)
+
+OutputFormat g_format = OutputFormat::Text;
+
+} // namespace
+
+// Owns the calling thread's buffers; passes what is left to the writer when
+// the thread exits.
+struct SinkHolder {
+    std::shared_ptr<OutputSink::Buffer> buf[2];
+
+    ~SinkHolder() {
+        for (auto& b : buf) {
+            if (!b) continue;
+            std::string rest;
+            {
+                std::lock_guard<std::mutex> lk(b->mu);
+                rest.swap(b->data);
+                b->orphaned = true;
+            }
+            if (!rest.empty()) b->sink->submit(std::move(rest));
+        }
+    }
+};
+
+OutputSink& OutputSink::out() {
+    // Leaked, like std::cout: records may be written until the very end.
+    static OutputSink* s = [] {
+        std::atexit(&OutputSink::flush_all);
+        return new OutputSink(1);
+    }();
+    return *s;
+}
+
+OutputSink& OutputSink::err() {
+    static OutputSink* s = [] {
+        out();  // registers the flush at exit
+        return new OutputSink(2);
+    }();
+    return *s;
+}
+
+void OutputSink::set_format(OutputFormat f) {
+    g_format = f;
+    out().format_ = f;
+    err().format_ = f == OutputFormat::Jsonl ? OutputFormat::Jsonl : OutputFormat::Text;
+}
+
+OutputFormat OutputSink::format() {
+    return g_format;
+}
+
+void OutputSink::flush_all() {
+    out().flush();
+    err().flush();
+}
+
+OutputSink::Buffer& OutputSink::local() {
+    thread_local SinkHolder holder;
+    std::shared_ptr<Buffer>& b = holder.buf[this == &err() ? 1 : 0];
+    if (!b) {
+        b = std::make_shared<Buffer>();
+        b->sink = this;
+        std::lock_guard<std::mutex> lk(mu_);
+        buffers_.push_back(b);
+    }
+    return *b;
+}
+
+void OutputSink::record(Event e, const std::string& path, const std::string& detail) {
+    const bool listing = e == WouldWipe || e == WouldUnlink || e == Wiped;
+    if (format_ == OutputFormat::Nul && !listing) {
+        // Keep stdout a clean NUL-separated list.
+        err().record(e, path, detail);
+        return;
+    }
+
+    Buffer& b = local();
+    std::unique_lock<std::mutex> lk(b.mu);
+    std::string& o = b.data;
+    switch (format_) {
+    case OutputFormat::Nul:
+        o += path;
+        o += '\0';
+        break;
+    case OutputFormat::Jsonl: {
+        static const char* const names[] = {"would_wipe", "would_unlink", "skip", "fail", "wiped"};
+        static const char* const keys[] = {"cleaner", "link_of", "reason", "error", "detail"};
+        o += "{\"event\":\"";
+        o += names[e];
+        o += "\",\"path\":";
+        json_quote(o, path);
+        if (!detail.empty()) {
+            o += ",\"";
+            o += keys[e];
+            o += "\":";
+            json_quote(o, detail);
+        }
+        o += "}\n";
+        break;
+    }
+    case OutputFormat::Text:
+        switch (e) {
+        case WouldWipe:
+            o += detail.empty() ? "[DRY-RUN] would wipe: " : "[DRY-RUN] " + detail + " would wipe: ";
+            o += path;
+            break;
+        case WouldUnlink:
+            o += "[DRY-RUN] would unlink (hard link of " + detail + "): ";
+            o += path;
+            break;
+        case Skip:
+            o += "[SKIP] " + detail + ": ";
+            o += path;
+            break;
+        case Fail:
+            o += "[FAIL] ";
+            o += path;
+            o += " : " + detail;
+            break;
+        case Wiped:
+            o += "[WIPED] ";
+            o += path;
+            break;
+        }
+        o += '\n';
+        break;
+    }
+    if (o.size() < kChunk) return;
+    std::string chunk;
+    chunk.swap(o);
+    lk.unlock();
+    submit(std::move(chunk));
+}
+
+void OutputSink::submit(std::string&& chunk) {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [&] { return queued_bytes_ < kMaxQueued; });
+    queued_bytes_ += chunk.size();
+    queue_.push_back(std::move(chunk));
+    if (!writer_started_) {
+        writer_started_ = true;
+        std::thread([this] { run(); }).detach();
+    }
+    cv_.notify_all();
+}
+
+void OutputSink::flush() {
+    std::vector<std::shared_ptr<Buffer>> bufs;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        bufs = buffers_;
+        // Buffers of exited threads were emptied by their holders.
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                      [](const std::shared_ptr<Buffer>& b) {
+                                          std::lock_guard<std::mutex> bl(b->mu);
+                                          return b->orphaned;
+                                      }),
+                       buffers_.end());
+    }
+    for (const auto& b : bufs) {
+        std::string chunk;
+        {
+            std::lock_guard<std::mutex> lk(b->mu);
+            chunk.swap(b->data);
+        }
+        if (!chunk.empty()) submit(std::move(chunk));
+    }
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [&] { return queue_.empty() && !writing_; });
+}
+
+void OutputSink::write_all(const std::string& chunk) {
+    const char* p = chunk.data();
+    std::size_t n = chunk.size();
+    while (n > 0) {
+#if defined(_WIN32)
+        const int w = ::_write(fd_, p, static_cast<unsigned>(n));
+#else
+        const ssize_t w = ::write(fd_, p, n);
+#endif
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return;     // closed pipe or full disk: drop, as iostreams would
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+}
+
+void OutputSink::run() {
+    std::unique_lock<std::mutex> lk(mu_);
+    for (;;) {
+        cv_.wait(lk, [&] { return !queue_.empty(); });
+        std::string chunk = std::move(queue_.front());
+        queue_.pop_front();
+        writing_ = true;
+        lk.unlock();
+        write_all(chunk);
+        lk.lock();
+        writing_ = false;
+        queued_bytes_ -= chunk.size();
+        cv_.notify_all();
+    }
+}
+
+} // namespace securewipe
@@ -0,0 +1,78 @@
+#pragma once
+// Per-path output of directory jobs and watch mode: dry-run listings,
+// skips, failures and (watch) wiped files.
+//
+// Records are formatted into a buffer owned by the calling thread and
+// handed, 64 KiB at a time, to a writer thread that issues large write(2)s,
+// so tens of millions of lines cost the traversal a memcpy each instead of
+// a synchronized iostream call. Order is kept per thread, not across
+// threads. flush() (also run when a directory job or a lone dry run
+// completes, and at exit) drains every thread's buffer.
+//
+// Formats: Text, the classic "[DRY-RUN] would wipe: <path>" lines; Nul,
+// bare NUL-terminated paths of the listing on stdout (other records go to
+// stderr as text) for `xargs -0`; Jsonl, one JSON object per record.
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+enum class OutputFormat { Text, Nul, Jsonl };
+
+class OutputSink {
+public:
+    // What a record reports; decides its text form and JSON detail key.
+    enum Event {
+        WouldWipe,      // detail: cleaner id, or empty
+        WouldUnlink,    // detail: the name that is overwritten instead
+        Skip,           // detail: reason
+        Fail,           // detail: error
+        Wiped           // watch mode; listed like WouldWipe
+    };
+
+    // stdout (listings, skips) and stderr (failures).
+    static OutputSink& out();
+    static OutputSink& err();
+    // Applies to both; set before any record is written.
+    static void set_format(OutputFormat f);
+    static OutputFormat format();
+    static void flush_all();
+
+    void record(Event e, const std::string& path, const std::string& detail = std::string());
+    void flush();
+
+    // One thread's pending bytes (internal, shared with the thread's holder).
+    struct Buffer {
+        std::mutex mu;
+        std::string data;
+        OutputSink* sink = nullptr;
+        bool orphaned = false;          // its thread has exited
+    };
+
+private:
+    explicit OutputSink(int fd) : fd_(fd) {}
+    Buffer& local();
+    void submit(std::string&& chunk);
+    void write_all(const std::string& chunk);
+    void run();
+
+    const int fd_;
+    OutputFormat format_ = OutputFormat::Text;
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::vector<std::shared_ptr<Buffer>> buffers_;
+    std::deque<std::string> queue_;
+    std::size_t queued_bytes_ = 0;
+    bool writing_ = false;
+    bool writer_started_ = false;
+
+    friend struct SinkHolder;
+};
+
+} // namespace securewipe
@@ -0,0 +1,92 @@
+#include "path_arena.h"
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+namespace {
+
+constexpr char kSep = static_cast<char>(fs::path::preferred_separator);
+
+} // namespace
+
+PathArena::PathArena(std::string root) : root_(std::move(root)) {
+    prefix_ = (fs::path(root_) / "").string();
+    dirs_.push_back(Node{0, UINT32_MAX, 0});
+}
+
+std::uint64_t PathArena::intern(const std::string& s) {
+    // Names are at most NAME_MAX bytes, far below a block.
+    const std::size_t block = std::size_t(1) << kBlockBits;
+    if (used_ + s.size() > block) {
+        blocks_.emplace_back(new char[block]);
+        used_ = 0;
+    }
+    const std::uint64_t off = (static_cast<std::uint64_t>(blocks_.size() - 1) << kBlockBits) + used_;
+    std::memcpy(blocks_.back().get() + used_, s.data(), s.size());
+    used_ += s.size();
+    return off;
+}
+
+std::uint32_t PathArena::add_dir(std::uint32_t parent, const std::string& name) {
+    dirs_.push_back(Node{intern(name), parent, static_cast<std::uint32_t>(name.size())});
+    return static_cast<std::uint32_t>(dirs_.size() - 1);
+}
+
+std::uint32_t PathArena::add_file(std::uint32_t dir, const std::string& name) {
+    files_.push_back(Node{intern(name), dir, static_cast<std::uint32_t>(name.size())});
+    return static_cast<std::uint32_t>(files_.size() - 1);
+}
+
+void PathArena::append_name(std::string& out, const Node& n) const {
+    const char* p = blocks_[n.name >> kBlockBits].get() + (n.name & ((std::uint64_t(1) << kBlockBits) - 1));
+    out.append(p, n.len);
+}
+
+void PathArena::append_rel(std::string& out, std::uint32_t d) const {
+    std::uint32_t chain[64];
+    std::vector<std::uint32_t> deep;    // only for trees deeper than the fixed chain
+    std::size_t n = 0;
+    for (; d != kRoot; d = dirs_[d].parent) {
+        if (n < 64) chain[n++] = d;
+        else deep.push_back(d);
+    }
+    for (auto it = deep.rbegin(); it != deep.rend(); ++it) {
+        append_name(out, dirs_[*it]);
+        out += kSep;
+    }
+    while (n > 0) {
+        append_name(out, dirs_[chain[--n]]);
+        out += kSep;
+    }
+}
+
+std::string PathArena::dir_relpath(std::uint32_t d) const {
+    std::string out;
+    append_rel(out, d);
+    if (!out.empty()) out.pop_back();
+    return out;
+}
+
+std::string PathArena::file_relpath(std::uint32_t f) const {
+    std::string out;
+    append_rel(out, files_[f].parent);
+    append_name(out, files_[f]);
+    return out;
+}
+
+std::string PathArena::dir_path(std::uint32_t d) const {
+    return d == kRoot ? root_ : prefix_ + dir_relpath(d);
+}
+
+std::string PathArena::file_path(std::uint32_t f) const {
+    return prefix_ + file_relpath(f);
+}
+
+std::size_t PathArena::memory() const {
+    return (dirs_.capacity() + files_.capacity()) * sizeof(Node) + (blocks_.size() << kBlockBits);
+}
+
+} // namespace securewipe
@@ -0,0 +1,63 @@
+#pragma once
+// Compact storage for the paths of a queued directory job.
+//
+// Every directory and file is a 16-byte node (parent directory, name slice)
+// in a parent-pointer tree; the names live in a bump-allocated arena of
+// 1 MiB blocks, so shared prefixes are stored once and there is no heap
+// allocation per entry. Full paths are rebuilt on demand, and paths relative
+// to the root can go straight to *at() calls on the job's root descriptor.
+//
+// Append-only; safe to read from many threads once filling is done.
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+class PathArena {
+public:
+    static constexpr std::uint32_t kRoot = 0;
+
+    // Directory node kRoot is `root` itself.
+    explicit PathArena(std::string root);
+
+    std::uint32_t add_dir(std::uint32_t parent, const std::string& name);
+    std::uint32_t add_file(std::uint32_t dir, const std::string& name);
+
+    std::size_t dir_count() const { return dirs_.size(); }
+    std::size_t file_count() const { return files_.size(); }
+
+    // As the walk spelled them: the root joined with the relative path.
+    std::string dir_path(std::uint32_t d) const;
+    std::string file_path(std::uint32_t f) const;
+    // Relative to the root.
+    std::string dir_relpath(std::uint32_t d) const;
+    std::string file_relpath(std::uint32_t f) const;
+
+    // Bytes held (nodes and name blocks).
+    std::size_t memory() const;
+
+private:
+    struct Node {
+        std::uint64_t name;     // offset in the arena
+        std::uint32_t parent;
+        std::uint32_t len;
+    };
+    static_assert(sizeof(Node) == 16, "PathArena::Node should stay 16 bytes");
+
+    std::uint64_t intern(const std::string& s);
+    void append_rel(std::string& out, std::uint32_t d) const;
+    void append_name(std::string& out, const Node& n) const;
+
+    static constexpr unsigned kBlockBits = 20;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::size_t used_ = std::size_t(1) << kBlockBits;     // of the last block
+    std::vector<Node> dirs_;
+    std::vector<Node> files_;
+    std::string root_;
+    std::string prefix_;        // root with a trailing separator
+};
+
+} // namespace securewipe
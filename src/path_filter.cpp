@@ -0,0 +1,355 @@
+#include "path_filter.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+
+namespace securewipe {
+
+// --- ComponentGlob ---------------------------------------------------------
+
+ComponentGlob::ComponentGlob(const std::string& pattern) {
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        const char c = pattern[i];
+        if (c == '\\' && i + 1 < pattern.size()) {
+            tokens_.push_back(Token{Op::Char, pattern[++i], 0});
+        } else if (c == '*') {
+            if (tokens_.empty() || tokens_.back().op != Op::Star) tokens_.push_back(Token{Op::Star, 0, 0});
+            literal_ = false;
+        } else if (c == '?') {
+            tokens_.push_back(Token{Op::Any, 0, 0});
+            literal_ = false;
+        } else if (c == '[') {
+            // Find the closing bracket; "[]" and "[!]" treat the first ']' as a member.
+            std::size_t j = i + 1;
+            if (j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^')) ++j;
+            if (j < pattern.size() && pattern[j] == ']') ++j;
+            while (j < pattern.size() && pattern[j] != ']') {
+                if (pattern[j] == '\\') ++j;
+                ++j;
+            }
+            if (j >= pattern.size()) {
+                tokens_.push_back(Token{Op::Char, c, 0});    // unterminated: literal '['
+                continue;
+            }
+            std::vector<std::uint8_t> table(256, 0);
+            std::size_t k = i + 1;
+            bool negate = false;
+            if (pattern[k] == '!' || pattern[k] == '^') {
+                negate = true;
+                ++k;
+            }
+            bool first = true;
+            while (k < j && (first || pattern[k] != ']')) {
+                first = false;
+                unsigned char lo = static_cast<unsigned char>(pattern[k]);
+                if (lo == '\\' && k + 1 < j) lo = static_cast<unsigned char>(pattern[++k]);
+                ++k;
+                unsigned char hi = lo;
+                if (k + 1 < j && pattern[k] == '-') {
+                    hi = static_cast<unsigned char>(pattern[k + 1]);
+                    k += 2;
+                }
+                for (unsigned v = lo; v <= hi; ++v) table[v] = 1;
+            }
+            if (negate) {
+                for (auto& v : table) v = !v;
+            }
+            classes_.push_back(std::move(table));
+            tokens_.push_back(Token{Op::Class, 0, static_cast<std::uint16_t>(classes_.size() - 1)});
+            literal_ = false;
+            i = j;
+        } else {
+            tokens_.push_back(Token{Op::Char, c, 0});
+        }
+    }
+    if (literal_) {
+        for (const auto& t : tokens_) text_.push_back(t.c);
+    }
+}
+
+bool ComponentGlob::match_class(std::uint16_t cls, unsigned char c) const {
+    return classes_[cls][c] != 0;
+}
+
+bool ComponentGlob::match(const std::string& name) const {
+    if (literal_) return name == text_;
+
+    // Iterative matcher: on mismatch, let the most recent '*' absorb one more character.
+    std::size_t t = 0, n = 0;
+    std::size_t star_t = std::string::npos, star_n = 0;
+    while (n < name.size()) {
+        if (t < tokens_.size()) {
+            const Token& tok = tokens_[t];
+            const unsigned char c = static_cast<unsigned char>(name[n]);
+            if (tok.op == Op::Star) {
+                star_t = t++;
+                star_n = n;
+                continue;
+            }
+            if ((tok.op == Op::Char && tok.c == name[n]) || tok.op == Op::Any ||
+                (tok.op == Op::Class && match_class(tok.cls, c))) {
+                ++t;
+                ++n;
+                continue;
+            }
+        }
+        if (star_t == std::string::npos) return false;
+        t = star_t + 1;
+        n = ++star_n;
+    }
+    while (t < tokens_.size() && tokens_[t].op == Op::Star) ++t;
+    return t == tokens_.size();
+}
+
+// --- PathFilter ------------------------------------------------------------
+
+bool PathFilter::add_pattern(const std::string& text, bool include, std::uint32_t tag, std::string& err) {
+    std::string s = text;
+    Pattern pat{{}, include, false, false, tag, 0};
+
+    if (!s.empty() && s[0] == '!') {
+        if (include) {
+            err = "Negated pattern not allowed in --include: " + text;
+            return false;
+        }
+        pat.negate = true;
+        s.erase(0, 1);
+    } else if (s.size() > 1 && s[0] == '\\' && (s[1] == '!' || s[1] == '#')) {
+        s.erase(0, 1);
+    }
+    while (!s.empty() && s.back() == '/') {
+        pat.dir_only = true;
+        s.pop_back();
+    }
+    bool anchored = false;
+    if (!s.empty() && s[0] == '/') {
+        anchored = true;
+        s.erase(0, 1);
+    } else if (s.find('/') != std::string::npos) {
+        anchored = true;
+    }
+    if (s.empty()) {
+        err = "Empty filter pattern: '" + text + "'";
+        return false;
+    }
+
+    // Unanchored patterns match at any depth.
+    if (!anchored) pat.segs.push_back(Segment{true, ComponentGlob("")});
+    std::size_t start = 0;
+    while (start <= s.size()) {
+        std::size_t slash = s.find('/', start);
+        if (slash == std::string::npos) slash = s.size();
+        const std::string comp = s.substr(start, slash - start);
+        start = slash + 1;
+        if (comp.empty()) continue;
+        if (comp == "**") {
+            if (pat.segs.empty() || !pat.segs.back().globstar) pat.segs.push_back(Segment{true, ComponentGlob("")});
+        } else {
+            pat.segs.push_back(Segment{false, ComponentGlob(comp)});
+        }
+    }
+
+    pat.first = static_cast<std::uint32_t>(owner_.size());
+    // One state per position, plus the accepting position.
+    for (std::size_t i = 0; i <= pat.segs.size(); ++i) owner_.push_back(static_cast<std::uint32_t>(patterns_.size()));
+    if (include) have_includes_ = true;
+    patterns_.push_back(std::move(pat));
+    return true;
+}
+
+bool PathFilter::compile(const FilterRules& rules, std::string& err) {
+    patterns_.clear();
+    owner_.clear();
+    have_includes_ = false;
+    rules_ = rules;
+    for (const auto& p : rules.include) {
+        if (!add_pattern(p, true, 0, err)) return false;
+    }
+    for (const auto& p : rules.exclude) {
+        if (!add_pattern(p, false, 0, err)) return false;
+    }
+    if (rules.min_size > rules.max_size) {
+        err = "--min-size is larger than --max-size";
+        return false;
+    }
+    return true;
+}
+
+bool PathFilter::add_include(const std::string& pattern, std::uint32_t tag, std::string& err) {
+    return add_pattern(pattern, true, tag, err);
+}
+
+bool PathFilter::load_rules_file(const std::string& path, std::vector<std::string>& out, std::string& err) {
+    std::ifstream in(path);
+    if (!in) {
+        err = "Cannot open rules file: " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        // Trailing spaces are ignored unless escaped.
+        while (!line.empty() && line.back() == ' ' && !(line.size() > 1 && line[line.size() - 2] == '\\')) {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') continue;
+        out.push_back(line);
+    }
+    return true;
+}
+
+void PathFilter::closure(std::vector<std::uint32_t>& states) const {
+    // A "**" may match zero components, so it also enables the following
+    // position. A trailing "**" (as in "foo/**") must match at least one:
+    // it selects what is inside the directory, not the directory itself.
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        const std::uint32_t s = states[i];
+        const Pattern& p = patterns_[owner_[s]];
+        const std::size_t pos = s - p.first;
+        if (pos + 1 < p.segs.size() && p.segs[pos].globstar) states.push_back(s + 1);
+    }
+    std::sort(states.begin(), states.end());
+    states.erase(std::unique(states.begin(), states.end()), states.end());
+}
+
+FilterState PathFilter::root_state() const {
+    FilterState st;
+    for (const auto& p : patterns_) st.active.push_back(p.first);
+    closure(st.active);
+    // Accepting states at the root would match the root itself; drop them.
+    st.active.erase(std::remove_if(st.active.begin(), st.active.end(),
+                                   [this](std::uint32_t s) {
+                                       const Pattern& p = patterns_[owner_[s]];
+                                       return s - p.first == p.segs.size();
+                                   }),
+                    st.active.end());
+    return st;
+}
+
+bool PathFilter::excluded(const std::vector<std::uint32_t>& matched) const {
+    // `matched` holds pattern indices in rule order.
+    for (auto it = matched.rbegin(); it != matched.rend(); ++it) {
+        const Pattern& p = patterns_[*it];
+        if (!p.include) return !p.negate;
+    }
+    return false;
+}
+
+void PathFilter::step(const FilterState& parent, const std::string& name, bool is_dir, FilterState& out) const {
+    out.active.clear();
+    out.included = parent.included;
+    out.excluded = false;
+    out.tag = parent.tag;
+    if (patterns_.empty()) return;
+
+    for (const std::uint32_t s : parent.active) {
+        const Pattern& p = patterns_[owner_[s]];
+        const Segment& seg = p.segs[s - p.first];
+        if (seg.globstar) {
+            out.active.push_back(s);
+            if (s - p.first + 1 == p.segs.size()) out.active.push_back(s + 1);
+        } else if (seg.glob.match(name)) {
+            out.active.push_back(s + 1);
+        }
+    }
+    closure(out.active);
+
+    std::vector<std::uint32_t> matched;
+    std::size_t keep = 0;
+    for (const std::uint32_t s : out.active) {
+        const std::uint32_t pi = owner_[s];
+        const Pattern& p = patterns_[pi];
+        if (s - p.first == p.segs.size()) {
+            if (!p.dir_only || is_dir) {
+                if (matched.empty() || matched.back() != pi) matched.push_back(pi);
+            }
+        } else {
+            out.active[keep++] = s;
+        }
+    }
+    out.active.resize(keep);
+
+    for (const std::uint32_t pi : matched) {
+        const Pattern& p = patterns_[pi];
+        if (!p.include) continue;
+        if (!out.included) out.tag = static_cast<std::int32_t>(p.tag);
+        out.included = true;
+    }
+    out.excluded = excluded(matched);
+}
+
+bool PathFilter::prune_dir(const FilterState& st) const {
+    if (st.excluded) return true;
+    if (!have_includes_ || st.included) return false;
+    for (const std::uint32_t s : st.active) {
+        if (patterns_[owner_[s]].include) return false;
+    }
+    return true;    // no include rule can match anything below
+}
+
+bool PathFilter::accept_file(const FilterState& st, const EntryInfo& info, std::int64_t now) const {
+    if (!name_selected(st)) return false;
+    if (info.size < rules_.min_size || info.size > rules_.max_size) return false;
+    if (rules_.mtime_older_than >= 0 && now - info.mtime < rules_.mtime_older_than) return false;
+    if (rules_.atime_older_than >= 0 && now - info.atime < rules_.atime_older_than) return false;
+    if (rules_.owner_uid >= 0 && info.uid != rules_.owner_uid) return false;
+    return true;
+}
+
+// --- Rule values -----------------------------------------------------------
+
+// "4096", "10K", "2G" -> bytes. Whole numbers only; values that do not fit
+// in 64 bits are rejected rather than wrapped.
+bool parse_size(const std::string& s, std::uint64_t& out) {
+    if (s.empty() || !std::isdigit(static_cast<unsigned char>(s[0]))) return false;
+    std::size_t pos = 0;
+    unsigned long long v = 0;
+    try {
+        v = std::stoull(s, &pos);
+    } catch (...) {
+        return false;
+    }
+    unsigned shift = 0;
+    if (pos < s.size()) {
+        switch (s[pos]) {
+            case 'k': case 'K': shift = 10; break;
+            case 'm': case 'M': shift = 20; break;
+            case 'g': case 'G': shift = 30; break;
+            case 't': case 'T': shift = 40; break;
+            default: return false;
+        }
+        if (pos + 1 != s.size()) return false;
+    }
+    if (shift && v > (std::numeric_limits<std::uint64_t>::max() >> shift)) return false;
+    out = static_cast<std::uint64_t>(v) << shift;
+    return true;
+}
+
+// "90", "30m", "12h", "7d" -> seconds.
+bool parse_duration(const std::string& s, std::int64_t& out) {
+    std::size_t pos = 0;
+    long long v = 0;
+    try {
+        v = std::stoll(s, &pos);
+    } catch (...) {
+        return false;
+    }
+    if (v < 0) return false;
+    long long mul = 1;
+    if (pos < s.size()) {
+        switch (s[pos]) {
+            case 's': mul = 1; break;
+            case 'm': mul = 60; break;
+            case 'h': mul = 3600; break;
+            case 'd': mul = 86400; break;
+            default: return false;
+        }
+        if (pos + 1 != s.size()) return false;
+    }
+    if (v > std::numeric_limits<std::int64_t>::max() / mul) return false;
+    out = v * mul;
+    return true;
+}
+
+} // namespace securewipe
@@ -0,0 +1,107 @@
+#pragma once
+// Compiled include/exclude rules for directory traversal.
+//
+// Patterns use gitignore syntax and are compiled into one component-level
+// automaton: every pattern becomes a sequence of per-component globs and "**"
+// steps, and a traversal carries the set of live (pattern, position) states
+// per directory. Each path component advances the parent's set once, so a
+// directory that is excluded, or below which no include can match any more,
+// is pruned before it is read.
+#include "secure_wipe.h"
+#include "tree_walk.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+// One glob for a single path component: * ? [a-z] [!x] and backslash escapes.
+class ComponentGlob {
+public:
+    explicit ComponentGlob(const std::string& pattern);
+    bool match(const std::string& name) const;
+    bool is_literal() const { return literal_; }
+
+private:
+    enum class Op : std::uint8_t { Char, Any, Star, Class };
+    struct Token {
+        Op op;
+        char c;
+        std::uint16_t cls;      // index into classes_ for Op::Class
+    };
+    bool match_class(std::uint16_t cls, unsigned char c) const;
+
+    std::vector<Token> tokens_;
+    std::vector<std::vector<std::uint8_t>> classes_;   // 256-entry membership tables
+    std::string text_;
+    bool literal_ = true;
+};
+
+// Per-directory position of the automaton.
+struct FilterState {
+    std::vector<std::uint32_t> active;  // live (pattern, segment) states, sorted
+    bool included = false;              // an include rule matched this entry or an ancestor directory
+    bool excluded = false;              // the last matching exclude rule applies to this entry
+    std::int32_t tag = -1;              // tag of the include rule that selected it (first match wins)
+};
+
+class PathFilter {
+public:
+    // Returns false with `err` set if a rule is malformed.
+    bool compile(const FilterRules& rules, std::string& err);
+
+    // Add one more include rule after compile(); matches report `tag`.
+    // Lets several rule sets share one traversal.
+    bool add_include(const std::string& pattern, std::uint32_t tag, std::string& err);
+
+    // Read a gitignore-style file and append its rules to `out`.
+    static bool load_rules_file(const std::string& path, std::vector<std::string>& out, std::string& err);
+
+    bool has_patterns() const { return !patterns_.empty(); }
+
+    FilterState root_state() const;
+
+    // Advance `parent` by one path component.
+    void step(const FilterState& parent, const std::string& name, bool is_dir, FilterState& out) const;
+
+    // After step(): should the traversal skip this directory entirely?
+    bool prune_dir(const FilterState& st) const;
+
+    // After step(): do the patterns alone select this file (ignoring size,
+    // age and owner)?
+    bool name_selected(const FilterState& st) const { return !st.excluded && (!have_includes_ || st.included); }
+
+    // After step(): should this regular file be wiped? `now` is seconds since the epoch.
+    bool accept_file(const FilterState& st, const EntryInfo& info, std::int64_t now) const;
+
+private:
+    struct Segment {
+        bool globstar;          // "**": zero or more components
+        ComponentGlob glob;
+    };
+    struct Pattern {
+        std::vector<Segment> segs;
+        bool include;           // from FilterRules::include
+        bool negate;            // "!pattern": re-include
+        bool dir_only;          // trailing "/"
+        std::uint32_t tag;      // reported in FilterState::tag for includes
+        std::uint32_t first;    // id of segment 0 in the flat state numbering
+    };
+
+    bool add_pattern(const std::string& text, bool include, std::uint32_t tag, std::string& err);
+    void closure(std::vector<std::uint32_t>& states) const;
+    // Last exclude rule that matches decides; returns true if excluded.
+    bool excluded(const std::vector<std::uint32_t>& matched) const;
+
+    std::vector<Pattern> patterns_;
+    std::vector<std::uint32_t> owner_;  // state id -> pattern index
+    bool have_includes_ = false;
+    FilterRules rules_;
+};
+
+// "4096", "10K", "2G" -> bytes; "90", "30m", "12h", "7d" -> seconds.
+// Return false on malformed input.
+bool parse_size(const std::string& s, std::uint64_t& out);
+bool parse_duration(const std::string& s, std::int64_t& out);
+
+} // namespace securewipe
@@ -0,0 +1,64 @@
+#include "path_list.h"
+#include <cerrno>
+#include <cstring>
+
+namespace securewipe {
+
+static const std::size_t kReadChunk = 1 << 20;
+
+PathListReader::~PathListReader() {
+    if (fp_ && owns_) std::fclose(fp_);
+}
+
+bool PathListReader::open(const std::string& source, char delim, std::string& err) {
+    delim_ = delim;
+    if (source == "-") {
+        fp_ = stdin;
+        owns_ = false;
+    } else {
+        fp_ = std::fopen(source.c_str(), "rb");
+        if (!fp_) {
+            err = "Failed to open " + source + ": " + std::strerror(errno);
+            return false;
+        }
+        owns_ = true;
+    }
+    buf_.resize(kReadChunk);
+    return true;
+}
+
+bool PathListReader::refill() {
+    if (eof_) return false;
+    len_ = std::fread(buf_.data(), 1, buf_.size(), fp_);
+    pos_ = 0;
+    if (len_ == 0) {
+        eof_ = true;
+        error_ = std::ferror(fp_) != 0;
+        return false;
+    }
+    return true;
+}
+
+bool PathListReader::next(std::string& out) {
+    if (!fp_) return false;
+    out.clear();
+    for (;;) {
+        if (pos_ == len_ && !refill()) {
+            // Last entry may lack a trailing delimiter.
+            return !out.empty();
+        }
+        const char* begin = buf_.data() + pos_;
+        const void* hit = std::memchr(begin, delim_, len_ - pos_);
+        if (!hit) {
+            out.append(begin, len_ - pos_);
+            pos_ = len_;
+            continue;
+        }
+        const std::size_t n = static_cast<const char*>(hit) - begin;
+        out.append(begin, n);
+        pos_ += n + 1;
+        if (!out.empty()) return true;
+    }
+}
+
+} // namespace securewipe
@@ -0,0 +1,37 @@
+#pragma once
+// Streaming reader for path manifests (newline- or NUL-delimited).
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+class PathListReader {
+public:
+    PathListReader() = default;
+    ~PathListReader();
+
+    PathListReader(const PathListReader&) = delete;
+    PathListReader& operator=(const PathListReader&) = delete;
+
+    // `source` is a file path or "-" for stdin. Returns false with `err` set on failure.
+    bool open(const std::string& source, char delim, std::string& err);
+
+    // Next non-empty entry; false at end of input or on a read error (see error()).
+    bool next(std::string& out);
+    bool error() const { return error_; }
+
+private:
+    bool refill();
+
+    std::FILE* fp_ = nullptr;
+    bool owns_ = false;
+    bool eof_ = false;
+    bool error_ = false;
+    char delim_ = '\n';
+    std::vector<char> buf_;
+    std::size_t pos_ = 0;
+    std::size_t len_ = 0;
+};
+
+} // namespace securewipe
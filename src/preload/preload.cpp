@@ -0,0 +1,416 @@
+// libsecurewipe_preload.so: turn plain unlink() of sensitive files into wipes.
+//
+//   export SECUREWIPE_PRELOAD_PREFIXES=/srv/app/tmp:/var/cache/app
+//   LD_PRELOAD=libsecurewipe_preload.so some-application
+//
+// unlink, unlinkat and remove of a regular, singly-linked, non-empty file
+// below one of the prefixes rename it into "<prefix>/.securewipe-spool" and
+// return at once; a background thread overwrites and deletes spooled files
+// with the library engine, so the caller's unlink latency stays that of a
+// rename. Everything else goes straight to libc. A file that cannot be
+// renamed into the spool (another filesystem mounted below the prefix, or a
+// spool not owned by this user or writable by others) is wiped synchronously
+// instead, once the unlink is known to be permitted;
+// an unlink that would fail anyway is left to libc with the data intact. A
+// spooled file this process still has open (the unlink-after-create temp
+// file idiom) is wiped once it is closed.
+//
+// At exit the queue is drained for up to SECUREWIPE_PRELOAD_EXIT_WAIT_MS
+// (default 5000). Files still spooled then, or left by a process that was
+// killed, are adopted by the next process that uses the same spool, or can
+// be wiped with `securewipe wipe-dir <prefix>/.securewipe-spool --yes`.
+//
+// Other settings: SECUREWIPE_PRELOAD_PASSES (default 1) and
+// SECUREWIPE_PRELOAD_PATTERN (zeros | random). Linux only.
+#include "secure_wipe.h"
+#include "protect.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/fs.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SW_PRELOAD_API extern "C" __attribute__((visibility("default")))
+
+namespace {
+
+using securewipe::WipeOptions;
+
+using UnlinkFn = int (*)(const char*);
+using UnlinkatFn = int (*)(int, const char*, int);
+
+constexpr const char* kSpoolName = ".securewipe-spool";
+
+// Set on the wipe thread (and around synchronous wipes): the engine's own
+// unlinks must reach libc.
+thread_local bool t_bypass = false;
+
+UnlinkFn real_unlink() {
+    static const auto fn = reinterpret_cast<UnlinkFn>(dlsym(RTLD_NEXT, "unlink"));
+    return fn;
+}
+
+UnlinkatFn real_unlinkat() {
+    static const auto fn = reinterpret_cast<UnlinkatFn>(dlsym(RTLD_NEXT, "unlinkat"));
+    return fn;
+}
+
+UnlinkFn real_remove() {
+    static const auto fn = reinterpret_cast<UnlinkFn>(dlsym(RTLD_NEXT, "remove"));
+    return fn;
+}
+
+// "." and ".." folded, duplicate slashes dropped; `p` is absolute.
+std::string normalize(const std::string& p) {
+    std::vector<std::string> parts;
+    std::size_t b = 0;
+    while (b < p.size()) {
+        std::size_t e = p.find('/', b);
+        if (e == std::string::npos) e = p.size();
+        const std::string c = p.substr(b, e - b);
+        if (c == "..") {
+            if (!parts.empty()) parts.pop_back();
+        } else if (!c.empty() && c != ".") {
+            parts.push_back(c);
+        }
+        b = e + 1;
+    }
+    std::string out;
+    for (const auto& c : parts) out += "/" + c;
+    return out.empty() ? "/" : out;
+}
+
+// Absolute form of `path` as unlinkat(dirfd, path) would resolve it.
+bool absolute_of(int dirfd, const char* path, std::string& out) {
+    if (path[0] == '/') {
+        out = normalize(path);
+        return true;
+    }
+    char base[PATH_MAX];
+    if (dirfd == AT_FDCWD) {
+        if (!getcwd(base, sizeof base)) return false;
+    } else {
+        char link[64];
+        std::snprintf(link, sizeof link, "/proc/self/fd/%d", dirfd);
+        const ssize_t n = readlink(link, base, sizeof base - 1);
+        if (n <= 0) return false;
+        base[n] = '\0';
+    }
+    out = normalize(std::string(base) + "/" + path);
+    return true;
+}
+
+bool below(const std::string& path, const std::string& dir) {
+    return path.size() > dir.size() && path.compare(0, dir.size(), dir) == 0 &&
+           (dir == "/" || path[dir.size()] == '/');
+}
+
+// Whether this process holds `path` open; it then still uses the data.
+bool open_here(const std::string& path) {
+    struct stat want;
+    if (stat(path.c_str(), &want) != 0) return false;
+    DIR* d = opendir("/proc/self/fd");
+    if (!d) return false;
+    bool found = false;
+    while (dirent* e = readdir(d)) {
+        struct stat st;
+        if (e->d_name[0] != '.' && fstatat(dirfd(d), e->d_name, &st, 0) == 0 && st.st_dev == want.st_dev &&
+            st.st_ino == want.st_ino) {
+            found = true;
+            break;
+        }
+    }
+    closedir(d);
+    return found;
+}
+
+// Whether unlinking `abs` (stat `st`) can succeed, checked before its data
+// is destroyed: a writable, searchable parent on a writable filesystem, no
+// immutable or append-only flag on either, and the sticky-bit ownership rule.
+bool unlink_allowed(const std::string& abs, const struct stat& st) {
+    const std::string parent = abs.substr(0, std::max<std::size_t>(abs.rfind('/'), 1));
+    if (faccessat(AT_FDCWD, parent.c_str(), W_OK | X_OK, AT_EACCESS) != 0) return false;
+    struct stat pst;
+    if (stat(parent.c_str(), &pst) != 0) return false;
+    if ((pst.st_mode & S_ISVTX) && geteuid() != 0 && geteuid() != st.st_uid && geteuid() != pst.st_uid) {
+        return false;
+    }
+    for (const std::string* p : {&parent, &abs}) {
+        const int fd = open(p->c_str(), O_RDONLY | O_NONBLOCK | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) continue;   // no flags to read; the wipe's own open decides
+        int flags = 0;
+        const bool got = ioctl(fd, FS_IOC_GETFLAGS, &flags) == 0;
+        close(fd);
+        if (got && (flags & (FS_IMMUTABLE_FL | FS_APPEND_FL))) return false;
+    }
+    return true;
+}
+
+bool process_alive(long pid) {
+    return pid > 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+class Shim {
+public:
+    static Shim& get() {
+        // Leaked on purpose: the drain at exit must not race its destruction.
+        static Shim* shim = new Shim();
+        return *shim;
+    }
+
+    bool enabled() const { return !prefixes_.empty(); }
+
+    // The spool for `abs`, or empty if it is not below a prefix (or is in a spool).
+    std::string spool_for(const std::string& abs) const {
+        for (const auto& p : prefixes_) {
+            if (!below(abs, p)) continue;
+            const std::string spool = (p == "/" ? "" : p) + "/" + kSpoolName;
+            if (abs == spool || below(abs, spool)) return std::string();
+            return spool;
+        }
+        return std::string();
+    }
+
+    // Divert the unlink of (dirfd, path). Returns false to let libc do it.
+    bool divert(int dirfd, const char* path, int& rc) {
+        struct stat st;
+        if (fstatat(dirfd, path, &st, AT_SYMLINK_NOFOLLOW) != 0) return false;
+        // Another name would keep the data reachable; an empty file has none.
+        if (!S_ISREG(st.st_mode) || st.st_nlink != 1 || st.st_size == 0) return false;
+        std::string abs;
+        if (!absolute_of(dirfd, path, abs)) return false;
+        const std::string spool = spool_for(abs);
+        if (spool.empty()) return false;
+
+        if (prepare_spool(spool)) {
+            const std::string base = abs.substr(abs.rfind('/') + 1);
+            std::string name = std::to_string(getpid()) + "-" + std::to_string(++seq_) + "-" + base;
+            if (name.size() > NAME_MAX) name.resize(NAME_MAX);
+            const std::string target = spool + "/" + name;
+            if (renameat(dirfd, path, AT_FDCWD, target.c_str()) == 0) {
+                enqueue(target);
+                rc = 0;
+                return true;
+            }
+            // Any other failure (EPERM, EROFS, EBUSY...) is the unlink's
+            // own: libc reports it and the data stays intact.
+            if (errno != EXDEV) return false;
+        }
+
+        // No spool on this filesystem: wipe now rather than not at all,
+        // unless the data is still in use here or the unlink would fail.
+        if (open_here(abs) || !unlink_allowed(abs, st)) return false;
+        t_bypass = true;
+        const securewipe::WipeResult r = securewipe::wipe_file(abs, opt_);
+        t_bypass = false;
+        if (!r.ok) {
+            report(abs, r.message);
+            return false;
+        }
+        rc = 0;
+        return true;
+    }
+
+    void before_fork() { mu_.lock(); }
+    void after_fork_parent() { mu_.unlock(); }
+    void after_fork_child() {
+        // The parent keeps wiping its own queue; the child starts empty.
+        queue_.clear();
+        deferred_.clear();
+        busy_ = false;
+        worker_started_ = false;
+        mu_.unlock();
+    }
+
+private:
+    Shim() {
+        if (const char* v = std::getenv("SECUREWIPE_PRELOAD_PREFIXES")) {
+            std::string all = v;
+            std::size_t b = 0;
+            while (b <= all.size()) {
+                std::size_t e = all.find(':', b);
+                if (e == std::string::npos) e = all.size();
+                if (e > b && all[b] == '/') prefixes_.push_back(normalize(all.substr(b, e - b)));
+                b = e + 1;
+            }
+        }
+        if (const char* v = std::getenv("SECUREWIPE_PRELOAD_PASSES")) opt_.passes = std::max(1, std::atoi(v));
+        if (const char* v = std::getenv("SECUREWIPE_PRELOAD_PATTERN")) {
+            if (std::strcmp(v, "random") == 0) opt_.pattern = securewipe::Pattern::Random;
+        }
+        if (const char* v = std::getenv("SECUREWIPE_PRELOAD_EXIT_WAIT_MS")) exit_wait_ms_ = std::atol(v);
+        if (prefixes_.empty()) return;
+
+        // Build the engine's protected-path set now, so that it is destroyed
+        // only after the drain registered below has run.
+        securewipe::ProtectedPaths::get(opt_.protect);
+        std::atexit([] { Shim::get().drain(); });
+        pthread_atfork([] { Shim::get().before_fork(); }, [] { Shim::get().after_fork_parent(); },
+                       [] { Shim::get().after_fork_child(); });
+    }
+
+    bool prepare_spool(const std::string& spool) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (spools_.count(spool)) return true;
+        }
+        if (mkdir(spool.c_str(), 0700) != 0 && errno != EEXIST) return false;
+        // A spool someone else owns or can write to would let them move the
+        // files out before they are wiped; use the synchronous path instead.
+        struct stat st;
+        if (lstat(spool.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+        if (st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) return false;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (!spools_.insert(spool).second) return true;
+        }
+        adopt_orphans(spool);
+        return true;
+    }
+
+    // Files spooled by processes that are gone: claim each by renaming it
+    // to our own name (only one claimant can win) and queue it.
+    void adopt_orphans(const std::string& spool) {
+        DIR* d = opendir(spool.c_str());
+        if (!d) return;
+        std::vector<std::string> names;
+        while (dirent* e = readdir(d)) {
+            char* end = nullptr;
+            const long pid = std::strtol(e->d_name, &end, 10);
+            if (end == e->d_name || *end != '-' || pid == getpid() || process_alive(pid)) continue;
+            names.push_back(e->d_name);
+        }
+        closedir(d);
+        for (const auto& n : names) {
+            const std::string from = spool + "/" + n;
+            std::string to = spool + "/" + std::to_string(getpid()) + "-" + std::to_string(++seq_) + "-" +
+                             n.substr(n.find('-') + 1);
+            if (to.size() - spool.size() - 1 > NAME_MAX) to.resize(spool.size() + 1 + NAME_MAX);
+            if (std::rename(from.c_str(), to.c_str()) == 0) enqueue(to);
+        }
+    }
+
+    void enqueue(const std::string& path) {
+        std::lock_guard<std::mutex> lk(mu_);
+        queue_.push_back(path);
+        if (!worker_started_) {
+            worker_started_ = true;
+            std::thread([this] { run(); }).detach();
+        }
+        cv_.notify_all();
+    }
+
+    void run() {
+        t_bypass = true;
+        std::unique_lock<std::mutex> lk(mu_);
+        const pid_t owner = getpid();
+        for (;;) {
+            // Files still open are looked at again every second.
+            if (!cv_.wait_for(lk, std::chrono::seconds(1), [&] { return !queue_.empty() || abandon_; })) {
+                queue_.insert(queue_.end(), deferred_.begin(), deferred_.end());
+                deferred_.clear();
+                continue;
+            }
+            if (abandon_ || getpid() != owner) break;
+            const std::string path = queue_.front();
+            queue_.pop_front();
+            busy_ = true;
+            lk.unlock();
+            const bool in_use = open_here(path);
+            if (!in_use) {
+                const securewipe::WipeResult r = securewipe::wipe_file(path, opt_);
+                if (!r.ok) report(path, r.message);
+            }
+            lk.lock();
+            if (in_use) deferred_.push_back(path);
+            busy_ = false;
+            cv_.notify_all();
+        }
+        busy_ = false;
+        cv_.notify_all();
+    }
+
+    // At exit: let the queue empty, within the configured wait. Deferred
+    // (still open) files stay spooled for adoption.
+    void drain() {
+        std::unique_lock<std::mutex> lk(mu_);
+        if (!worker_started_) return;
+        const auto idle = [&] { return queue_.empty() && !busy_; };
+        if (exit_wait_ms_ < 0) cv_.wait(lk, idle);
+        else cv_.wait_for(lk, std::chrono::milliseconds(exit_wait_ms_), idle);
+        // Stop after the file in progress; the rest stays spooled.
+        abandon_ = true;
+        cv_.notify_all();
+        cv_.wait(lk, [&] { return !busy_; });
+    }
+
+    static void report(const std::string& path, const std::string& why) {
+        std::fprintf(stderr, "[securewipe-preload] %s: %s\n", path.c_str(), why.c_str());
+    }
+
+    std::vector<std::string> prefixes_;
+    WipeOptions opt_;
+    long exit_wait_ms_ = 5000;          // < 0: wait for every file
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::string> queue_;
+    std::vector<std::string> deferred_; // spooled while still open here
+    std::set<std::string> spools_;      // created (and orphans adopted) by this process
+    bool worker_started_ = false;
+    bool busy_ = false;
+    bool abandon_ = false;
+    std::atomic<unsigned long> seq_{0};
+};
+
+bool intercepted(int dirfd, const char* path, int& rc) {
+    if (t_bypass || !path || !*path) return false;
+    Shim& shim = Shim::get();
+    if (!shim.enabled()) return false;
+    const int saved = errno;
+    const bool done = shim.divert(dirfd, path, rc);
+    errno = saved;
+    return done;
+}
+
+} // namespace
+
+SW_PRELOAD_API int unlink(const char* path) {
+    int rc = 0;
+    if (intercepted(AT_FDCWD, path, rc)) return rc;
+    return real_unlink()(path);
+}
+
+SW_PRELOAD_API int unlinkat(int dirfd, const char* path, int flags) {
+    int rc = 0;
+    if (!(flags & AT_REMOVEDIR) && intercepted(dirfd, path, rc)) return rc;
+    return real_unlinkat()(dirfd, path, flags);
+}
+
+// glibc's remove() unlinks through an internal call, so it is wrapped too.
+SW_PRELOAD_API int remove(const char* path) {
+    int rc = 0;
+    if (intercepted(AT_FDCWD, path, rc)) return rc;
+    return real_remove()(path);
+}
@@ -0,0 +1,246 @@
+#include "protect.h"
+#include "mount_table.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__APPLE__)
+#include <sys/param.h>
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
+#if defined(SYS_openat2)
+#include <linux/openat2.h>
+#endif
+#endif
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+namespace {
+
+constexpr std::uint32_t kNoNode = UINT32_MAX;
+
+const char kProtectedMsg[] = "Refusing to wipe a protected path";
+const char kDangerousMsg[] = "Refusing to wipe a dangerous directory. Choose a safer target.";
+
+// Components of a normalized absolute path ("/a/b" -> "a", "b").
+template <typename F>
+void for_each_component(const std::string& path, F f) {
+    std::size_t i = 0;
+    while (i < path.size()) {
+        std::size_t j = path.find('/', i);
+        if (j == std::string::npos) j = path.size();
+        if (j > i && !f(path.substr(i, j - i))) return;
+        i = j + 1;
+    }
+}
+
+ProtectedPaths* build(const std::vector<std::string>& extra) {
+    auto* p = new ProtectedPaths();
+
+    // Never a wipe-dir target; their contents may be.
+    for (const char* d : {"/", "/Applications", "/Library", "/System", "/Users", "/bin", "/boot", "/etc",
+                          "/home", "/lib", "/lib64", "/opt", "/root", "/sbin", "/srv", "/usr", "/var"}) {
+        p->add(d, ProtectedPaths::Exact);
+    }
+    // Operating system trees: nothing below them is wiped.
+    for (const char* d : {"/System", "/bin", "/boot", "/etc", "/lib", "/lib32", "/lib64", "/libx32", "/sbin",
+                          "/usr"}) {
+        p->add(d, ProtectedPaths::Subtree);
+    }
+    p->add("/usr/local", ProtectedPaths::Allow);
+
+    if (const char* home = std::getenv("HOME")) {
+        p->add(home, ProtectedPaths::Exact);
+        std::error_code ec;
+        const fs::path canon = fs::weakly_canonical(fs::path(home), ec);
+        if (!ec) p->add(canon.string(), ProtectedPaths::Exact);
+    }
+
+    // Pseudo filesystems (/proc, /sys, /dev, cgroups), except real
+    // filesystems mounted inside them such as /dev/shm.
+    const MountTable& mounts = MountTable::system();
+    for (const MountEntry& m : mounts.entries()) {
+        if (m.pseudo) {
+            p->add(m.mount_point, ProtectedPaths::Subtree);
+        } else if (m.mount_point != "/") {
+            const MountEntry* parent = mounts.containing(fs::path(m.mount_point).parent_path().string());
+            if (parent && parent->pseudo) p->add(m.mount_point, ProtectedPaths::Allow);
+        }
+    }
+
+    for (const auto& e : extra) {
+        p->add(e, ProtectedPaths::Subtree);
+        std::error_code ec;
+        const fs::path canon = fs::weakly_canonical(fs::path(e), ec);
+        if (!ec) p->add(canon.string(), ProtectedPaths::Subtree);
+    }
+    return p;
+}
+
+} // namespace
+
+std::shared_ptr<const ProtectedPaths> ProtectedPaths::get(const std::vector<std::string>& extra) {
+    static std::mutex mu;
+    static std::vector<std::string> key;
+    static std::shared_ptr<const ProtectedPaths> cached;
+    std::lock_guard<std::mutex> lk(mu);
+    if (!cached || key != extra) {
+        cached.reset(build(extra));
+        key = extra;
+    }
+    return cached;
+}
+
+std::string ProtectedPaths::normalize(const std::string& path) const {
+    fs::path p(path);
+    if (!p.is_absolute()) p = fs::path(cwd_) / p;
+    std::string s = p.lexically_normal().generic_string();
+    while (s.size() > 1 && s.back() == '/') s.pop_back();
+    return s;
+}
+
+std::uint32_t ProtectedPaths::child(std::uint32_t node, const std::string& name) const {
+    const auto& c = nodes_[node].children;
+    auto it = std::lower_bound(c.begin(), c.end(), name,
+                               [](const std::pair<std::string, std::uint32_t>& e, const std::string& n) {
+                                   return e.first < n;
+                               });
+    return (it != c.end() && it->first == name) ? it->second : kNoNode;
+}
+
+std::uint32_t ProtectedPaths::insert_child(std::uint32_t node, const std::string& name) {
+    const std::uint32_t found = child(node, name);
+    if (found != kNoNode) return found;
+    const auto id = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    auto& c = nodes_[node].children;
+    c.insert(std::lower_bound(c.begin(), c.end(), name,
+                              [](const std::pair<std::string, std::uint32_t>& e, const std::string& n) {
+                                  return e.first < n;
+                              }),
+             std::make_pair(name, id));
+    return id;
+}
+
+void ProtectedPaths::add(const std::string& path, Mode mode) {
+    if (cwd_.empty()) {
+        std::error_code ec;
+        cwd_ = fs::current_path(ec).generic_string();
+    }
+    std::uint32_t n = 0;
+    for_each_component(normalize(path), [&](const std::string& c) {
+        n = insert_child(n, c);
+        return true;
+    });
+    if (mode == Exact) nodes_[n].exact = true;
+    else nodes_[n].mode = mode;
+}
+
+const char* ProtectedPaths::check(const std::string& path, bool as_dir_target) const {
+    // The deepest Subtree or Allow entry on the way decides.
+    bool under = nodes_[0].mode == Subtree;
+    std::uint32_t n = 0;
+    for_each_component(path, [&](const std::string& c) {
+        n = child(n, c);
+        if (n == kNoNode) return false;
+        if (nodes_[n].mode == Subtree) under = true;
+        else if (nodes_[n].mode == Allow) under = false;
+        return true;
+    });
+    if (under) return kProtectedMsg;
+    if (as_dir_target && n != kNoNode && nodes_[n].exact) return kDangerousMsg;
+    return nullptr;
+}
+
+bool ProtectedPaths::has_below(const std::string& dir) const {
+    std::uint32_t n = 0;
+    for_each_component(dir, [&](const std::string& c) {
+        n = child(n, c);
+        return n != kNoNode;
+    });
+    return n != kNoNode && !nodes_[n].children.empty();
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+int open_no_symlinks(int dirfd, const std::string& path, int flags, bool beneath) {
+#if defined(__linux__) && defined(SYS_openat2)
+    enum : int { Unknown, Available, Missing };
+    static std::atomic<int> state{Unknown};
+    const auto call = [](int at, const char* p, int fl, std::uint64_t resolve) {
+        struct open_how how = {};
+        how.flags = static_cast<std::uint64_t>(fl | O_CLOEXEC);
+        how.resolve = resolve;
+        return ::syscall(SYS_openat2, at, p, &how, sizeof(how));
+    };
+    if (state.load(std::memory_order_relaxed) != Missing) {
+        const long fd = call(dirfd, path.c_str(), flags, RESOLVE_NO_SYMLINKS | (beneath ? RESOLVE_BENEATH : 0));
+        if (fd >= 0) {
+            state.store(Available, std::memory_order_relaxed);
+            return static_cast<int>(fd);
+        }
+        // Older kernels say ENOSYS; container seccomp filters often EPERM,
+        // but so does an immutable file. An open that cannot otherwise fail
+        // tells the two apart.
+        const int e = errno;
+        bool filtered = e == ENOSYS;
+        if (e == EPERM && state.load(std::memory_order_relaxed) == Unknown) {
+            const long probe = call(AT_FDCWD, "/", O_PATH | O_DIRECTORY, 0);
+            filtered = probe < 0;
+            if (probe >= 0) {
+                ::close(static_cast<int>(probe));
+                state.store(Available, std::memory_order_relaxed);
+            }
+        }
+        if (!filtered) {
+            errno = e;
+            return -1;
+        }
+        state.store(Missing, std::memory_order_relaxed);
+    }
+#else
+    (void)dirfd;
+    (void)path;
+    (void)flags;
+    (void)beneath;
+#endif
+    errno = ENOSYS;
+    return -1;
+}
+
+bool fd_path(int fd, std::string& out) {
+#if defined(__linux__)
+    char link[64];
+    char buf[PATH_MAX];
+    std::snprintf(link, sizeof link, "/proc/self/fd/%d", fd);
+    const ssize_t n = ::readlink(link, buf, sizeof buf - 1);
+    if (n <= 0 || buf[0] != '/') return false;
+    out.assign(buf, static_cast<std::size_t>(n));
+    return true;
+#elif defined(__APPLE__)
+    char buf[MAXPATHLEN];
+    if (::fcntl(fd, F_GETPATH, buf) != 0) return false;
+    out = buf;
+    return true;
+#else
+    (void)fd;
+    (void)out;
+    return false;
+#endif
+}
+
+#endif
+
+} // namespace securewipe
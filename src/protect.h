@@ -0,0 +1,71 @@
+#pragma once
+// Paths no wipe may touch, compiled once into a component trie.
+//
+// The built-in set refuses "/", the top-level system directories and the
+// home directory as wipe-dir targets, protects the operating system trees
+// (/usr except /usr/local, /etc, /boot, ...) and every pseudo-filesystem
+// mount entirely, and takes user entries (--protect) as protected subtrees.
+//
+// Checks are lexical and O(depth): the path is made absolute against the
+// working directory captured at compile time, "." and ".." are folded, and
+// the components are looked up in the trie. That is only sound for paths
+// without symlinks, so the engine opens targets with openat2() and
+// RESOLVE_NO_SYMLINKS; a path that has one anyway is canonicalized (the slow
+// path, also taken where openat2 is unavailable) and checked again.
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+class ProtectedPaths {
+public:
+    enum Mode : unsigned char {
+        None,
+        Exact,      // refused as a directory target; its contents are not protected
+        Subtree,    // the path and everything below it
+        Allow       // re-opens a subtree below a Subtree entry
+    };
+
+    // The built-in set plus `extra` subtrees. Compiled sets are cached, so
+    // callers may ask once per file.
+    static std::shared_ptr<const ProtectedPaths> get(const std::vector<std::string>& extra);
+
+    // `path` is made absolute and normalized; relative to the cwd of the compile.
+    void add(const std::string& path, Mode mode);
+
+    // Why `path` must not be wiped, or nullptr. `as_dir_target` also applies
+    // Exact entries. `path` must already be absolute and normalized.
+    const char* check(const std::string& path, bool as_dir_target) const;
+    // Whether any entry lies strictly below the absolute path `dir`.
+    bool has_below(const std::string& dir) const;
+
+    // Absolute, lexically normalized form of `path` (no syscalls).
+    std::string normalize(const std::string& path) const;
+
+private:
+    struct Node {
+        std::vector<std::pair<std::string, std::uint32_t>> children;   // sorted by name
+        bool exact = false;
+        Mode mode = None;               // Subtree, Allow or None
+    };
+    std::uint32_t child(std::uint32_t node, const std::string& name) const;
+    std::uint32_t insert_child(std::uint32_t node, const std::string& name);
+
+    std::vector<Node> nodes_{Node()};   // nodes_[0] is "/"
+    std::string cwd_;
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+// openat2() with RESOLVE_NO_SYMLINKS, plus RESOLVE_BENEATH when `beneath`.
+// Returns -1 with errno ENOSYS where the kernel or libc lacks it, or a seccomp
+// filter refuses it; any other error, EPERM included, is the open's own.
+int open_no_symlinks(int dirfd, const std::string& path, int flags, bool beneath);
+
+// The path the kernel has for the open file `fd` (/proc/self/fd on Linux,
+// F_GETPATH on macOS). False where it cannot tell.
+bool fd_path(int fd, std::string& out);
+#endif
+
+} // namespace securewipe
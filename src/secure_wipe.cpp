@@ -1,6 +1,13 @@
 #include "secure_wipe.h"
+#include "wipe_engine.h"
+#include "audit_ledger.h"
+#include "job_journal.h"
+#include "mount_table.h"
+#include "protect.h"
+#include <algorithm>
 #include <iostream>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
@@ -8,7 +15,10 @@
 #include <vector>
 
 #if defined(__unix__) || defined(__APPLE__)
-#include <unistd.h>  // fsync
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>  // pwrite, fdatasync
 #endif
 
 namespace fs = std::filesystem;
@@ -19,130 +29,500 @@ static std::string errstr(const char* prefix) {
     return std::string(prefix) + ": " + std::strerror(errno);
 }
 
-static bool flush_to_disk(std::ofstream& ofs) {
-    ofs.flush();
-    if (!ofs) return false;
+// Sequential writes of the overwrite passes. On POSIX the descriptor is used
+// directly so every pass can be synced to the device; a pass that stays in
+// the page cache may never reach the disk before the file is deleted.
+class PassWriter {
+public:
+    PassWriter() = default;
+    ~PassWriter() { close(); }
+    PassWriter(const PassWriter&) = delete;
+    PassWriter& operator=(const PassWriter&) = delete;
 
 #if defined(__unix__) || defined(__APPLE__)
-    // Best-effort: ensure data reaches disk.
-    // Note: This is not a cryptographic guarantee, and SSD/TRIM may limit effectiveness.
-    int fd = -1;
-    // Hack: get fd from ofstream is non-standard; we can't portably do it.
-    // We'll rely on flush() here. (On Windows we can use FlushFileBuffers.)
-    (void)fd;
+    void adopt(int fd) { fd_ = fd; }
+    int fd() const { return fd_; }
+#else
+    bool open(const std::string& path) {
+        ofs_.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        return static_cast<bool>(ofs_);
+    }
+#endif
+
+    // Start a pass at `offset`.
+    bool seek(std::uint64_t offset) {
+#if defined(__unix__) || defined(__APPLE__)
+        off_ = offset;
+        return true;
+#else
+        ofs_.seekp(static_cast<std::streamoff>(offset));
+        return static_cast<bool>(ofs_);
+#endif
+    }
+
+    bool write(const unsigned char* p, std::size_t n) {
+#if defined(__unix__) || defined(__APPLE__)
+        while (n > 0) {
+            const ssize_t w = ::pwrite(fd_, p, n, static_cast<off_t>(off_));
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+            off_ += static_cast<std::uint64_t>(w);
+        }
+        return true;
+#else
+        ofs_.write(reinterpret_cast<const char*>(p), static_cast<std::streamsize>(n));
+        return static_cast<bool>(ofs_);
+#endif
+    }
+
+    // Data written so far is on stable storage (best effort outside POSIX).
+    bool sync() {
+#if defined(__linux__)
+        return ::fdatasync(fd_) == 0;
+#elif defined(__unix__) || defined(__APPLE__)
+        return ::fsync(fd_) == 0;
+#else
+        ofs_.flush();
+        return static_cast<bool>(ofs_);
+#endif
+    }
+
+    void close() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#else
+        if (ofs_.is_open()) ofs_.close();
+#endif
+    }
+
+private:
+#if defined(__unix__) || defined(__APPLE__)
+    int fd_ = -1;
+    std::uint64_t off_ = 0;
+#else
+    std::ofstream ofs_;
+#endif
+};
+
+static void fill_random(std::mt19937_64& rng, unsigned char* out, std::size_t n) {
+    // One engine call yields 8 bytes.
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const std::uint64_t v = rng();
+        std::memcpy(out + i, &v, 8);
+    }
+    if (i < n) {
+        const std::uint64_t v = rng();
+        std::memcpy(out + i, &v, n - i);
+    }
+}
+
+namespace detail {
+
+WipeContext::WipeContext() : rng(std::random_device{}()) {}
+
+void fill_pattern(WipeContext& ctx, Pattern pattern, unsigned char* buf, std::size_t n) {
+    if (pattern == Pattern::Zeros) {
+        std::fill(buf, buf + n, 0x00);
+    } else {
+        fill_random(ctx.rng, buf, n);
+    }
+}
+
+FsStrategy FsStrategyCache::lookup(std::uint64_t dev, const std::string& path) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = map_.find(dev);
+    if (it != map_.end()) return it->second;
+
+    FsStrategy s;
+#if defined(__unix__) || defined(__APPLE__)
+    struct statvfs vfs;
+    if (::statvfs(path.c_str(), &vfs) == 0 && vfs.f_bsize > 0) {
+        s.io_block = static_cast<std::size_t>(vfs.f_bsize);
+    }
+#else
+    (void)path;
 #endif
+    if (const MountEntry* m = MountTable::system().by_dev(dev)) {
+        s.fs_type = m->fs_type;
+        s.network = m->network;
+        s.copy_on_write = m->copy_on_write;
+    }
+    map_.emplace(dev, s);
+    return s;
+}
+
+// Existence, type, size and device of a wipe target in as few syscalls as possible.
+struct TargetInfo {
+    bool exists = false;
+    bool regular = false;
+    bool symlink = false;
+    std::uintmax_t size = 0;
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;
+};
+
+static bool stat_target(const std::string& path, TargetInfo& ti, std::error_code& ec) {
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat st;
+    if (::lstat(path.c_str(), &st) != 0) {
+        if (errno == ENOENT || errno == ENOTDIR) return true;
+        ec.assign(errno, std::generic_category());
+        return false;
+    }
+    ti.exists = true;
+    ti.regular = S_ISREG(st.st_mode);
+    ti.symlink = S_ISLNK(st.st_mode);
+    ti.size = static_cast<std::uintmax_t>(st.st_size);
+    ti.dev = static_cast<std::uint64_t>(st.st_dev);
+    ti.ino = static_cast<std::uint64_t>(st.st_ino);
     return true;
+#else
+    ti.exists = fs::exists(path, ec);
+    if (!ti.exists) return true;
+    ti.regular = fs::is_regular_file(path, ec);
+    if (!ti.regular) return true;
+    ti.size = fs::file_size(path, ec);
+    return !ec;
+#endif
 }
 
-WipeResult wipe_file(const std::string& path, const WipeOptions& opt) {
+#if defined(__unix__) || defined(__APPLE__)
+
+// Open a wipe target for writing without following symlinks. Files of a
+// directory job are opened beneath the job's root descriptor; other targets
+// are checked against the protected paths first. On success `dirfd` and
+// `name` designate the file for the final unlink.
+static int open_target(const std::string& path, const WipeEnv& env, int& dirfd, std::string& name,
+                       std::string& err) {
+    const int flags = O_WRONLY | O_NOFOLLOW | O_CLOEXEC;
+    int fd = -1;
+    if (env.beneath_fd >= 0 && path.size() > env.beneath_prefix) {
+        dirfd = env.beneath_fd;
+        name = path.substr(env.beneath_prefix);
+        fd = open_no_symlinks(dirfd, name, flags, true);
+        if (fd < 0 && errno == ENOSYS) fd = ::openat(dirfd, name.c_str(), flags);
+        if (fd < 0) {
+            err = (errno == ELOOP || errno == EXDEV) ? "Path below the wipe root is now a symlink; not following it"
+                                                     : errstr("Failed to open file for overwrite");
+        }
+        return fd;
+    }
+
+    dirfd = AT_FDCWD;
+    name = path;
+    if (env.protect) {
+        // Lexical check: sound because the open below refuses symlinks.
+        name = env.protect->normalize(path);
+        if (const char* why = env.protect->check(name, false)) {
+            err = why;
+            return -1;
+        }
+        fd = open_no_symlinks(AT_FDCWD, name, flags, false);
+        if (fd >= 0) return fd;
+        if (errno != ELOOP && errno != ENOSYS) {
+            err = errstr("Failed to open file for overwrite");
+            return -1;
+        }
+        // Slow path: a symlink in the directory part, or no openat2.
+        char* real = ::realpath(path.c_str(), nullptr);
+        if (!real) {
+            err = errstr("Failed to resolve path");
+            return -1;
+        }
+        name = real;
+        std::free(real);
+        if (const char* why = env.protect->check(name, false)) {
+            err = why;
+            return -1;
+        }
+        fd = open_no_symlinks(AT_FDCWD, name, flags, false);
+    }
+    if (fd < 0) fd = ::open(name.c_str(), flags);
+    if (fd < 0) err = errstr("Failed to open file for overwrite");
+    return fd;
+}
+
+#endif
+
+const char* StopCheck::reason() const {
+    if (token.stop_requested() || external.stop_requested()) return "Cancelled";
+    if (deadline != std::chrono::steady_clock::time_point::max() &&
+        std::chrono::steady_clock::now() >= deadline) {
+        return "Deadline exceeded";
+    }
+    return nullptr;
+}
+
+// overwrite_file without the ledger; fills the extent fields of `rec`.
+static WipeResult overwrite(const std::string& path, const WipeOptions& opt, WipeContext& ctx, const WipeEnv& env,
+                            const WipeSpan& span, LedgerEntry* rec) {
     WipeResult r;
 
     std::error_code ec;
-    if (!fs::exists(path, ec)) {
+    TargetInfo ti;
+    const bool stat_ok = stat_target(path, ti, ec);
+    if (!ti.exists) {
         r.ok = false;
-        r.message = "Path does not exist";
+        r.message = stat_ok ? "Path does not exist" : "Failed to stat path: " + ec.message();
         return r;
     }
-    if (!fs::is_regular_file(path, ec)) {
+    if (ti.symlink) {
+        r.ok = false;
+        r.message = "Path is a symlink; refusing to follow it";
+        return r;
+    }
+    if (!ti.regular) {
         r.ok = false;
         r.message = "Path is not a regular file (directories not supported in MVP)";
         return r;
     }
-
-    const auto file_size = fs::file_size(path, ec);
-    if (ec) {
+    if (!stat_ok) {
         r.ok = false;
         r.message = "Failed to get file size: " + ec.message();
         return r;
     }
+    const auto file_size = ti.size;
+    if (span.offset > file_size) {
+        r.ok = false;
+        r.message = "Range starts past the end of the file (" + std::to_string(file_size) + " bytes)";
+        return r;
+    }
+    // Overwritten: [begin, end). Never past the end; the file is not extended.
+    const std::uint64_t begin = span.offset;
+    const std::uint64_t end = begin + std::min<std::uint64_t>(span.length, file_size - begin);
+    if (rec) {
+        rec->size = file_size;
+        rec->offset = begin;
+        rec->length = end - begin;
+    }
 
     if (opt.passes <= 0) {
         r.ok = false;
         r.message = "passes must be >= 1";
         return r;
     }
+    if (opt.block_size == 0) {
+        r.ok = false;
+        r.message = "block_size must be >= 1";
+        return r;
+    }
 
-    std::vector<unsigned char> buf(opt.block_size);
+    PassWriter out;
+#if defined(__unix__) || defined(__APPLE__)
+    int dirfd = AT_FDCWD;
+    std::string name;
+    const int fd = open_target(path, env, dirfd, name, r.message);
+    if (fd < 0) {
+        r.ok = false;
+        return r;
+    }
+    out.adopt(fd);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || static_cast<std::uint64_t>(st.st_ino) != ti.ino) {
+        r.ok = false;
+        r.message = "File changed while being opened; not wiped";
+        return r;
+    }
+#else
+    std::string target = path;
+    if (env.protect) {
+        target = env.protect->normalize(path);
+        if (const char* why = env.protect->check(target, false)) {
+            r.ok = false;
+            r.message = why;
+            return r;
+        }
+    }
+    if (!out.open(target)) {
+        r.ok = false;
+        r.message = errstr("Failed to open file for overwrite");
+        return r;
+    }
+#endif
 
-    std::mt19937_64 rng(std::random_device{}());
-    std::uniform_int_distribution<int> dist(0, 255);
+    // Round the block up to the filesystem's preferred I/O size.
+    std::size_t block = opt.block_size;
+    if (env.cache) {
+        const FsStrategy s = env.cache->lookup(ti.dev, path);
+        // Remote filesystems pay a round trip per write; use fewer, larger ones.
+        if (s.network) block = std::max<std::size_t>(block, 4 << 20);
+        if (s.io_block > 0 && block % s.io_block != 0) {
+            block += s.io_block - block % s.io_block;
+        }
+    }
+    if (ctx.buf.size() < block) ctx.buf.resize(block);
+    unsigned char* buf = ctx.buf.data();
+
+    // With a journal, large files continue from their last checkpoint.
+    JournalKey key;
+    int first_pass = 1;
+    std::uint64_t resume_at = 0;
+    bool journaled = false;
+    if (env.journal) {
+        key.path = journal_path_hash(path);
+        key.ino = ti.ino;
+        key.size = file_size;
+        env.journal->resume_point(key, first_pass, resume_at);
+        journaled = first_pass > 1 || resume_at > 0;
+    }
+    const std::uint64_t checkpoint = env.journal ? env.journal->checkpoint_bytes() : UINT64_MAX;
 
-    for (int pass = 1; pass <= opt.passes; ++pass) {
-        std::ofstream ofs(path, std::ios::binary | std::ios::in | std::ios::out);
-        if (!ofs) {
+    for (int pass = first_pass; pass <= opt.passes; ++pass) {
+        const std::uint64_t start =
+            (pass == first_pass) ? std::min<std::uint64_t>(std::max<std::uint64_t>(resume_at, begin), end) : begin;
+        if (!out.seek(start)) {
             r.ok = false;
-            r.message = errstr("Failed to open file for overwrite");
+            r.message = errstr("Seek failed during overwrite");
             return r;
         }
 
-        std::uintmax_t remaining = file_size;
-        while (remaining > 0) {
-            std::size_t chunk = static_cast<std::size_t>(
-                std::min<std::uintmax_t>(remaining, buf.size()));
-
-            if (opt.pattern == Pattern::Zeros) {
-                std::fill(buf.begin(), buf.begin() + chunk, 0x00);
-            } else {
-                for (std::size_t i = 0; i < chunk; ++i) {
-                    buf[i] = static_cast<unsigned char>(dist(rng));
+        std::uint64_t pos = start;
+        std::uint64_t next_checkpoint = env.journal ? start + checkpoint : UINT64_MAX;
+        while (pos < end) {
+            if (env.stop) {
+                if (const char* why = env.stop->reason()) {
+                    r.ok = false;
+                    r.message = std::string(why) + " during overwrite (file left partially overwritten)";
+                    return r;
                 }
             }
+            // Keep writes block-aligned when a range starts mid-block.
+            std::size_t chunk = static_cast<std::size_t>(
+                std::min<std::uint64_t>(end - pos, block - pos % block));
+
+            fill_pattern(ctx, opt.pattern, buf, chunk);
 
-            ofs.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(chunk));
-            if (!ofs) {
+            if (!out.write(buf, chunk)) {
                 r.ok = false;
                 r.message = errstr("Write failed during overwrite");
                 return r;
             }
-            remaining -= chunk;
+            pos += chunk;
+            if (env.bytes) *env.bytes += chunk;
+
+            // Checkpoint only what is already durable.
+            if (pos >= next_checkpoint && pos < end) {
+                if (!out.sync()) {
+                    r.ok = false;
+                    r.message = errstr("Sync failed during overwrite");
+                    return r;
+                }
+                env.journal->progress(key, pass, pos);
+                journaled = true;
+                next_checkpoint = pos + checkpoint;
+            }
         }
 
-        if (!flush_to_disk(ofs)) {
+        if (!out.sync()) {
             r.ok = false;
-            r.message = "Flush failed";
+            r.message = errstr("Sync failed");
             return r;
         }
+        if (journaled) env.journal->progress(key, pass + 1, 0);
+    }
+
+    out.close();
+    if (span.keep_file) {
+        if (journaled) env.journal->done(key);
+        r.ok = true;
+        r.message = "Overwrote " + std::to_string(end - begin) + " bytes at offset " + std::to_string(begin);
+        return r;
     }
 
     // Remove the file after overwrite
-    if (!fs::remove(path, ec) || ec) {
+#if defined(__unix__) || defined(__APPLE__)
+    if (::unlinkat(dirfd, name.c_str(), 0) != 0) {
+        r.ok = false;
+        r.message = errstr("Failed to delete file");
+        return r;
+    }
+#else
+    if (!fs::remove(target, ec) || ec) {
         r.ok = false;
         r.message = "Failed to delete file: " + (ec ? ec.message() : std::string("unknown error"));
         return r;
     }
+#endif
+    if (journaled) env.journal->done(key);
 
     r.ok = true;
     r.message = "Wiped and deleted successfully";
     return r;
 }
 
-static bool is_dangerous_dir(const fs::path& p) {
-    std::error_code ec;
-    fs::path canon = fs::weakly_canonical(p, ec);
-    if (ec) canon = fs::absolute(p, ec);
-    if (ec) return true;
-
-    // Refuse root
-    if (canon == fs::path("/")) return true;
+WipeResult overwrite_file(const std::string& path, const WipeOptions& opt, WipeContext& ctx,
+                          const WipeEnv& env, const WipeSpan& span) {
+    if (!env.ledger) return overwrite(path, opt, ctx, env, span, nullptr);
+    LedgerEntry e;
+    e.action = span.keep_file ? "range" : "wipe";
+    e.passes = opt.passes;
+    e.pattern = opt.pattern;
+    e.started_ms = unix_ms();
+    WipeResult r = overwrite(path, opt, ctx, env, span, &e);
+    e.finished_ms = unix_ms();
+    e.ok = r.ok;
+    if (!r.ok) e.error = r.message;
+    env.ledger->record(path, std::move(e));
+    return r;
+}
 
-    // Common macOS system dirs (hard refuse)
-    const fs::path sys1("/System");
-    const fs::path sys2("/Library");
-    const fs::path sys3("/Applications");
-    if (canon == sys1 || canon == sys2 || canon == sys3) return true;
+} // namespace detail
 
-    // Refuse wiping the user's home directory root (best-effort)
-    const char* home = std::getenv("HOME");
-    if (home) {
-        std::error_code ec2;
-        fs::path homep = fs::weakly_canonical(fs::path(home), ec2);
-        if (!ec2 && canon == homep) return true;
+// One standalone file: protected paths, plus the journal and the ledger if
+// configured.
+static WipeResult wipe_standalone(const std::string& path, const WipeOptions& opt, const detail::WipeSpan& span) {
+    detail::WipeContext ctx;
+    const auto protect = ProtectedPaths::get(opt.protect);
+    detail::WipeEnv env;
+    env.protect = protect.get();
+    WipeResult r;
+    std::shared_ptr<AuditLedger> ledger;
+    if (!opt.ledger.path.empty()) {
+        ledger = AuditLedger::open(opt.ledger, r.message);
+        if (!ledger) return r;
+        env.ledger = ledger.get();
+    }
+    JobJournal journal;
+    if (!opt.journal.path.empty()) {
+        if (!journal.open(opt.journal, journal_fingerprint(path, opt, span.offset, span.length), r.message)) return r;
+        env.journal = &journal;
+    }
+    r = detail::overwrite_file(path, opt, ctx, env, span);
+    if (env.journal) {
+        journal.close(r.ok);
+        if (r.ok && journal.resumed() > 0) r.message += " (resumed from journal)";
+    }
+    std::string err;
+    if (ledger && !ledger->commit(err)) {
+        r.ok = false;
+        r.message += "; " + err;
     }
+    return r;
+}
 
-    return false;
+WipeResult wipe_file(const std::string& path, const WipeOptions& opt) {
+    return wipe_standalone(path, opt, detail::WipeSpan());
 }
 
-WipeResult wipe_directory(const std::string& dir, const WipeOptions& opt, bool dry_run, bool yes) {
+WipeResult wipe_range(const std::string& path, std::uint64_t offset, std::uint64_t length, const WipeOptions& opt,
+                      bool keep_file) {
+    detail::WipeSpan span;
+    span.offset = offset;
+    span.length = length;
+    span.keep_file = keep_file;
+    return wipe_standalone(path, opt, span);
+}
+
+namespace detail {
+
+WipeResult check_directory_target(const std::string& dir, bool dry_run, bool yes,
+                                  const std::vector<std::string>& protect) {
     WipeResult r;
     std::error_code ec;
 
@@ -158,11 +538,21 @@ WipeResult wipe_directory(const std::string& dir, const WipeOptions& opt, bool d
         return r;
     }
 
-    if (is_dangerous_dir(d)) {
+    // One canonicalization per job; everything below the root is checked
+    // lexically by the walk and opened without following symlinks.
+    const auto paths = ProtectedPaths::get(protect);
+    fs::path canon = fs::weakly_canonical(d, ec);
+    if (ec) canon = fs::absolute(d, ec);
+    if (ec) {
         r.ok = false;
         r.message = "Refusing to wipe a dangerous directory. Choose a safer target.";
         return r;
     }
+    if (const char* why = paths->check(paths->normalize(canon.string()), true)) {
+        r.ok = false;
+        r.message = why;
+        return r;
+    }
 
     // Safety model:
     // - default is dry-run (list files)
@@ -173,65 +563,16 @@ WipeResult wipe_directory(const std::string& dir, const WipeOptions& opt, bool d
         return r;
     }
 
-    std::uint64_t total_files = 0;
-    std::uint64_t wiped_files = 0;
-    std::uint64_t failed_files = 0;
-
-    // First pass: enumerate files (skip symlinks)
-    for (auto it = fs::recursive_directory_iterator(d, fs::directory_options::skip_permission_denied, ec);
-         it != fs::recursive_directory_iterator(); it.increment(ec)) {
-        if (ec) continue;
-
-        const fs::path p = it->path();
-
-        // Avoid following symlinks to prevent escaping the directory
-        std::error_code ec2;
-        if (fs::is_symlink(p, ec2)) {
-            continue;
-        }
-
-        if (fs::is_regular_file(p, ec2) && !ec2) {
-            ++total_files;
-            if (dry_run) {
-                std::cout << "[DRY-RUN] would wipe: " << p.string() << "\n";
-            }
-        }
-    }
-
-    if (dry_run) {
-        r.ok = true;
-        r.message = "Dry-run complete. Files to wipe: " + std::to_string(total_files) +
-                    ". Re-run with --yes to execute.";
-        return r;
-    }
-
-    // Execute: wipe files
-    for (auto it = fs::recursive_directory_iterator(d, fs::directory_options::skip_permission_denied, ec);
-         it != fs::recursive_directory_iterator(); it.increment(ec)) {
-        if (ec) continue;
-
-        const fs::path p = it->path();
-
-        std::error_code ec2;
-        if (fs::is_symlink(p, ec2)) {
-            continue;
-        }
-
-        if (fs::is_regular_file(p, ec2) && !ec2) {
-            auto res = wipe_file(p.string(), opt);
-            if (res.ok) ++wiped_files;
-            else {
-                ++failed_files;
-                std::cerr << "[FAIL] " << p.string() << " : " << res.message << "\n";
-            }
-        }
-    }
+    r.ok = true;
+    return r;
+}
 
-    // Optional cleanup: attempt to remove empty directories (bottom-up)
+void remove_empty_dirs(const std::string& dir) {
     // We do best-effort; failures are OK.
     // Note: recursive_directory_iterator is top-down, so we can collect dirs and remove reversed.
+    std::error_code ec;
     std::vector<fs::path> dirs;
-    for (auto it = fs::recursive_directory_iterator(d, fs::directory_options::skip_permission_denied, ec);
+    for (auto it = fs::recursive_directory_iterator(fs::path(dir), fs::directory_options::skip_permission_denied, ec);
          it != fs::recursive_directory_iterator(); it.increment(ec)) {
         if (ec) continue;
         std::error_code ec3;
@@ -241,12 +582,15 @@ WipeResult wipe_directory(const std::string& dir, const WipeOptions& opt, bool d
         std::error_code ec4;
         fs::remove(*it, ec4); // removes only if empty
     }
+}
 
-    r.ok = (failed_files == 0);
-    r.message = "wipe-dir complete. total=" + std::to_string(total_files) +
-                ", wiped=" + std::to_string(wiped_files) +
-                ", failed=" + std::to_string(failed_files);
-    return r;
+} // namespace detail
+
+WipeResult wipe_directory(const std::string& dir, const WipeOptions& opt, bool dry_run, bool yes) {
+    SessionOptions so;
+    so.threads = 1;
+    WipeSession session(so);
+    return session.wipe_directory(dir, opt, dry_run, yes);
 }
 
-} // namespace securewipe
\ No newline at end of file
+} // namespace securewipe
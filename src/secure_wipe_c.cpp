@@ -0,0 +1,161 @@
+#include "secure_wipe_c.h"
+#include "secure_wipe.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace securewipe;
+namespace fs = std::filesystem;
+
+struct sw_session {
+    struct Done {
+        sw_job_id job;
+        bool ok;
+        std::string message;
+    };
+
+    // Declared before `session` so completions arriving while the session
+    // drains in its destructor still find this state alive.
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<Done> done;
+    std::unordered_map<sw_job_id, StopSource> pending;
+    sw_job_id next_id = 1;
+
+    WipeSession session;
+
+    explicit sw_session(const SessionOptions& so) : session(so) {}
+};
+
+static WipeOptions to_options(const sw_options& o) {
+    WipeOptions opt;
+    opt.passes = o.passes;
+    opt.pattern = (o.pattern == SW_PATTERN_RANDOM) ? Pattern::Random : Pattern::Zeros;
+    opt.block_size = static_cast<std::size_t>(o.block_size);
+    return opt;
+}
+
+extern "C" {
+
+uint32_t sw_abi_version(void) {
+    return SW_ABI_VERSION;
+}
+
+void sw_options_init(sw_options* opt) {
+    if (!opt) return;
+    const WipeOptions d;
+    opt->passes = d.passes;
+    opt->pattern = SW_PATTERN_ZEROS;
+    opt->block_size = d.block_size;
+    opt->flags = 0;
+    opt->timeout_ms = 0;
+}
+
+sw_session* sw_session_create(uint32_t threads) {
+    SessionOptions so;
+    so.threads = threads;
+    try {
+        return new sw_session(so);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void sw_session_destroy(sw_session* s) {
+    delete s;
+}
+
+sw_job_id sw_submit(sw_session* s, const char* path, const sw_options* opt) {
+    if (!s || !path) return 0;
+    sw_options o;
+    sw_options_init(&o);
+    if (opt) o = *opt;
+
+    sw_job_id id = 0;
+    try {
+        SubmitOptions so;
+        so.dry_run = (o.flags & SW_SUBMIT_DRY_RUN) != 0;
+        so.recursive = (o.flags & SW_SUBMIT_DIRECTORY) != 0;
+        std::error_code ec;
+        if (!so.recursive && fs::is_directory(fs::symlink_status(path, ec))) return 0;
+        if (o.timeout_ms > 0) {
+            so.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(o.timeout_ms);
+        }
+
+        StopSource stop;
+        so.stop_token = stop.get_token();
+
+        {
+            std::lock_guard<std::mutex> lk(s->mu);
+            id = s->next_id++;
+            s->pending.emplace(id, stop);
+        }
+        so.on_complete = [s, id](const WipeResult& r) {
+            {
+                std::lock_guard<std::mutex> lk(s->mu);
+                s->pending.erase(id);
+                s->done.push_back(sw_session::Done{id, r.ok, r.message});
+            }
+            s->cv.notify_all();
+        };
+        s->session.submit(path, to_options(o), so);
+        return id;
+    } catch (...) {
+        // Not queued, so no completion will remove it.
+        if (id != 0) {
+            std::lock_guard<std::mutex> lk(s->mu);
+            s->pending.erase(id);
+        }
+        return 0;
+    }
+}
+
+int sw_cancel(sw_session* s, sw_job_id job) {
+    if (!s) return 0;
+    std::lock_guard<std::mutex> lk(s->mu);
+    auto it = s->pending.find(job);
+    if (it == s->pending.end()) return 0;
+    it->second.request_stop();
+    return 1;
+}
+
+int sw_poll(sw_session* s, sw_completion* out, int max, int timeout_ms) {
+    if (!s || !out || max <= 0) return 0;
+    std::unique_lock<std::mutex> lk(s->mu);
+    if (s->done.empty() && timeout_ms != 0) {
+        auto ready = [s] { return !s->done.empty(); };
+        if (timeout_ms < 0) s->cv.wait(lk, ready);
+        else s->cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), ready);
+    }
+
+    int n = 0;
+    while (n < max && !s->done.empty()) {
+        const sw_session::Done& d = s->done.front();
+        sw_completion& c = out[n++];
+        c.job = d.job;
+        c.ok = d.ok ? 1 : 0;
+        const std::size_t len = std::min(d.message.size(), sizeof(c.message) - 1);
+        std::memcpy(c.message, d.message.data(), len);
+        c.message[len] = '\0';
+        s->done.pop_front();
+    }
+    return n;
+}
+
+void sw_get_stats(sw_session* s, sw_stats* out) {
+    if (!s || !out) return;
+    const WipeStats st = s->session.stats();
+    out->files_wiped = st.files_wiped;
+    out->files_failed = st.files_failed;
+    out->bytes_overwritten = st.bytes_overwritten;
+    std::lock_guard<std::mutex> lk(s->mu);
+    out->jobs_pending = s->pending.size() + s->done.size();
+}
+
+} // extern "C"
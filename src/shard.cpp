@@ -0,0 +1,417 @@
+#include "shard.h"
+#include "output_sink.h"
+#include "wipe_engine.h"
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace securewipe {
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Unit = ShardUnit;
+
+std::uint64_t fnv1a(const std::string& s) {
+    std::uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+class LeaseDir {
+public:
+    LeaseDir(const std::string& dir, const std::string& worker, unsigned ttl)
+        : dir_(dir), worker_(worker), ttl_(ttl) {
+        safe_worker_ = worker;
+        std::replace(safe_worker_.begin(), safe_worker_.end(), '/', '_');
+        clock_probe_ = dir_ + "/.clock-" + safe_worker_;
+    }
+    ~LeaseDir() { ::unlink(clock_probe_.c_str()); }
+
+    std::string lease_path(const Unit& u, int gen) const { return base(u) + "." + std::to_string(gen); }
+
+    bool is_done(const Unit& u) const {
+        struct stat st;
+        return ::stat((base(u) + ".done").c_str(), &st) == 0;
+    }
+
+    static constexpr int kHeld = -1;
+    static constexpr int kError = -2;
+
+    // Returns the generation claimed, kHeld if the unit is held by someone
+    // else, or kError (see error()) if the lease directory is unusable.
+    int claim(const Unit& u) {
+        int gen = 0;
+        struct stat st;
+        while (::stat(lease_path(u, gen).c_str(), &st) == 0) ++gen;
+        if (gen > 0 && !expired(st_mtime_of(lease_path(u, gen - 1)))) return kHeld;
+        if (!create_exclusive(lease_path(u, gen), u)) {
+            if (errno == EEXIST) return kHeld;
+            error_ = "Cannot create lease " + lease_path(u, gen) + ": " + std::strerror(errno);
+            return kError;
+        }
+        if (is_done(u)) {           // finished while we were probing
+            ::unlink(lease_path(u, gen).c_str());
+            return kHeld;
+        }
+        return gen;
+    }
+
+    const std::string& error() const { return error_; }
+
+    void heartbeat(const Unit& u, int gen) const { ::utimensat(AT_FDCWD, lease_path(u, gen).c_str(), nullptr, 0); }
+
+    bool superseded(const Unit& u, int gen) const {
+        struct stat st;
+        return ::stat(lease_path(u, gen + 1).c_str(), &st) == 0;
+    }
+
+    // Publishes the unit's counters. The first record wins: a holder that
+    // lost its lease but finished anyway cannot replace the new holder's
+    // record (link() fails with EEXIST where rename() would overwrite), so
+    // the merged report counts each unit once.
+    bool write_done(const Unit& u, const WipeStats& s) const {
+        const std::string tmp = base(u) + ".done.tmp." + safe_worker_;
+        {
+            std::ofstream ofs(tmp, std::ios::trunc);
+            ofs << s.files_wiped << ' ' << s.files_failed << ' ' << s.files_skipped << ' '
+                << s.bytes_overwritten << ' ' << worker_ << '\t' << u.rel << '\n';
+            if (!ofs) {
+                ::unlink(tmp.c_str());
+                return false;
+            }
+        }
+        const bool published = ::link(tmp.c_str(), (base(u) + ".done").c_str()) == 0;
+        ::unlink(tmp.c_str());
+        return published;
+    }
+
+    void release(const Unit& u, int gen) const {
+        for (int g = 0; g <= gen; ++g) ::unlink(lease_path(u, g).c_str());
+    }
+
+    // Sum of every .done record in the lease directory.
+    WipeStats merge(std::uint64_t& units) const {
+        WipeStats total;
+        units = 0;
+        std::error_code ec;
+        for (auto it = fs::directory_iterator(dir_, ec); it != fs::directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (it->path().extension() != ".done") continue;
+            std::ifstream ifs(it->path());
+            WipeStats s;
+            if (ifs >> s.files_wiped >> s.files_failed >> s.files_skipped >> s.bytes_overwritten) {
+                total.files_wiped += s.files_wiped;
+                total.files_failed += s.files_failed;
+                total.files_skipped += s.files_skipped;
+                total.bytes_overwritten += s.bytes_overwritten;
+                ++units;
+            }
+        }
+        return total;
+    }
+
+private:
+    std::string base(const Unit& u) const {
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(fnv1a(u.rel)));
+        return dir_ + "/" + hex;
+    }
+
+    bool create_exclusive(const std::string& path, const Unit& u) const {
+        const int fd = ::open(path.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        const std::string body = worker_ + "\t" + u.rel + "\n";
+        (void)!::write(fd, body.data(), body.size());
+        ::close(fd);
+        return true;
+    }
+
+    static time_t st_mtime_of(const std::string& path) {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0 ? st.st_mtime : 0;
+    }
+
+    // Expiry is judged against the shared filesystem's clock, not ours, so
+    // hosts with skewed clocks agree on it.
+    bool expired(time_t mtime) const {
+        const int fd = ::open(clock_probe_.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            ::futimens(fd, nullptr);
+            ::close(fd);
+        }
+        const time_t now = st_mtime_of(clock_probe_);
+        return now != 0 && now - mtime > static_cast<time_t>(ttl_);
+    }
+
+    std::string dir_;
+    std::string worker_;
+    std::string safe_worker_;
+    std::string clock_probe_;
+    unsigned ttl_;
+    std::string error_;
+};
+
+// Touches the lease being worked on; cancels the unit if it was taken over.
+class Heartbeat {
+public:
+    Heartbeat(LeaseDir& leases, unsigned ttl) : leases_(leases), period_(std::max(1u, ttl / 3)) {
+        thread_ = std::thread([this] { run(); });
+    }
+    ~Heartbeat() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            quit_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void hold(const Unit* u, int gen, const StopSource& stop) {
+        std::lock_guard<std::mutex> lk(mu_);
+        unit_ = u;
+        gen_ = gen;
+        stop_ = stop;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lk(mu_);
+        while (!quit_) {
+            cv_.wait_for(lk, std::chrono::seconds(period_));
+            if (quit_ || !unit_) continue;
+            if (leases_.superseded(*unit_, gen_)) {
+                std::cerr << "[SHARD] lease lost: " << unit_->rel << "\n";
+                stop_.request_stop();
+            } else {
+                leases_.heartbeat(*unit_, gen_);
+            }
+        }
+    }
+
+    LeaseDir& leases_;
+    unsigned period_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool quit_ = false;
+    const Unit* unit_ = nullptr;
+    int gen_ = 0;
+    StopSource stop_;
+    std::thread thread_;
+};
+
+void add_stats(WipeStats& into, const WipeStats& s) {
+    into.files_wiped += s.files_wiped;
+    into.files_failed += s.files_failed;
+    into.files_skipped += s.files_skipped;
+    into.bytes_overwritten += s.bytes_overwritten;
+}
+
+WipeStats run_unit(WipeSession& session, const fs::path& root, const Unit& u, const WipeOptions& opt,
+                   const StopToken& tok) {
+    const fs::path p = (root / u.rel).lexically_normal();
+    SubmitOptions so;
+    so.stop_token = tok;
+    std::error_code ec;
+    if (!fs::is_directory(fs::symlink_status(p, ec))) return WipeStats();
+
+    if (u.recursive) {
+        SubmitOptions rso = so;
+        rso.recursive = true;
+        return session.submit(p.string(), opt, rso).get().stats;
+    }
+
+    std::vector<std::string> files;
+    for (auto it = fs::directory_iterator(p, fs::directory_options::skip_permission_denied, ec);
+         it != fs::directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        std::error_code ec2;
+        if (it->is_symlink(ec2) || !it->is_regular_file(ec2)) continue;
+        files.push_back(it->path().string());
+    }
+    std::vector<WipeTicket> tickets;
+    tickets.reserve(files.size());
+    for (const auto& f : files) tickets.push_back(session.submit(f, opt, so));
+
+    WipeStats s;
+    for (std::size_t i = 0; i < tickets.size(); ++i) {
+        const WipeResult r = tickets[i].get();
+        add_stats(s, r.stats);
+        if (!r.ok && r.stats.files_failed) OutputSink::err().record(OutputSink::Fail, files[i], r.message);
+    }
+    return s;
+}
+
+bool is_within(const fs::path& inner, const fs::path& outer) {
+    auto i = inner.begin();
+    for (auto o = outer.begin(); o != outer.end(); ++o, ++i) {
+        if (o->empty()) continue;   // trailing separator
+        if (i == inner.end() || *i != *o) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<ShardUnit> split_tree(const std::string& root_dir, unsigned depth) {
+    const fs::path root(root_dir);
+    std::vector<ShardUnit> units;
+    std::vector<fs::path> level{fs::path(".")};
+    for (unsigned d = 0; d < depth && !level.empty(); ++d) {
+        std::vector<fs::path> next;
+        for (const auto& rel : level) {
+            units.push_back(ShardUnit{rel.generic_string(), false});
+            std::error_code ec;
+            for (auto it = fs::directory_iterator(root / rel, fs::directory_options::skip_permission_denied, ec);
+                 it != fs::directory_iterator(); it.increment(ec)) {
+                if (ec) break;
+                std::error_code ec2;
+                if (it->is_symlink(ec2) || !it->is_directory(ec2)) continue;
+                next.push_back((rel / it->path().filename()).lexically_normal());
+            }
+        }
+        level.swap(next);
+    }
+    for (const auto& rel : level) units.push_back(ShardUnit{rel.generic_string(), true});
+    std::sort(units.begin(), units.end(), [](const ShardUnit& a, const ShardUnit& b) { return a.rel < b.rel; });
+    return units;
+}
+
+WipeResult wipe_directory_sharded(WipeSession& session, const std::string& dir, const WipeOptions& opt,
+                                  const ShardOptions& sh) {
+    WipeResult r = detail::check_directory_target(dir, false, true);
+    if (!r.ok) return r;
+
+    std::error_code ec;
+    const fs::path root = fs::absolute(dir, ec).lexically_normal();
+    const fs::path lease_dir = fs::absolute(sh.lease_dir, ec).lexically_normal();
+    if (sh.lease_dir.empty() || ec) {
+        r.ok = false;
+        r.message = "Sharded mode requires a lease directory";
+        return r;
+    }
+    if (is_within(lease_dir, root)) {
+        r.ok = false;
+        r.message = "Lease directory must be outside the tree being wiped";
+        return r;
+    }
+    fs::create_directories(lease_dir, ec);
+    if (ec || ::access(lease_dir.c_str(), W_OK | X_OK) != 0) {
+        r.ok = false;
+        r.message = "Cannot use lease directory " + lease_dir.string() + ": " +
+                    (ec ? ec.message() : std::string(std::strerror(errno)));
+        return r;
+    }
+
+    std::string worker = sh.worker_id;
+    if (worker.empty()) {
+        char host[256] = {0};
+        ::gethostname(host, sizeof(host) - 1);
+        worker = std::string(host) + ":" + std::to_string(::getpid());
+    }
+
+    const std::vector<Unit> units = split_tree(root.string(), std::max(1u, sh.depth));
+    LeaseDir leases(lease_dir.string(), worker, sh.lease_ttl);
+    Heartbeat hb(leases, sh.lease_ttl);
+
+    // Start at a worker-specific offset so participants spread out instead of
+    // all racing for the first unit.
+    const std::size_t start = units.empty() ? 0 : fnv1a(worker) % units.size();
+    std::vector<bool> done(units.size(), false);
+    std::uint64_t mine = 0;
+    WipeStats local;
+
+    for (;;) {
+        bool all_done = true;
+        for (std::size_t k = 0; k < units.size(); ++k) {
+            const std::size_t i = (start + k) % units.size();
+            if (done[i]) continue;
+            if (leases.is_done(units[i])) {
+                done[i] = true;
+                continue;
+            }
+            const int gen = leases.claim(units[i]);
+            if (gen == LeaseDir::kError) {
+                r.ok = false;
+                r.message = leases.error();
+                return r;
+            }
+            if (gen < 0) {
+                all_done = false;
+                continue;
+            }
+
+            StopSource stop;
+            hb.hold(&units[i], gen, stop);
+            const WipeStats s = run_unit(session, root, units[i], opt, stop.get_token());
+            hb.hold(nullptr, 0, StopSource());
+
+            // Taken over (noticed by the heartbeat, or since its last beat):
+            // the new holder finishes and reports it.
+            if (stop.stop_requested() || leases.superseded(units[i], gen)) {
+                all_done = false;
+                continue;
+            }
+            if (leases.write_done(units[i], s)) {
+                add_stats(local, s);
+                ++mine;
+            }
+            leases.release(units[i], gen);
+            done[i] = true;
+        }
+        if (all_done) break;
+        // Remaining units are leased by live participants; wait for them or their expiry.
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    detail::remove_empty_dirs(root.string());
+
+    std::uint64_t merged_units = 0;
+    const WipeStats total = leases.merge(merged_units);
+    r.ok = (total.files_failed == 0 && total.files_skipped == 0);
+    r.stats = total;
+    r.message = "sharded wipe-dir complete. units=" + std::to_string(merged_units) +
+                " (this worker: " + std::to_string(mine) + ", wiped=" + std::to_string(local.files_wiped) +
+                "), wiped=" + std::to_string(total.files_wiped) +
+                ", failed=" + std::to_string(total.files_failed) +
+                ", bytes=" + std::to_string(total.bytes_overwritten);
+    return r;
+}
+
+#else
+
+std::vector<ShardUnit> split_tree(const std::string&, unsigned) {
+    return std::vector<ShardUnit>();
+}
+
+WipeResult wipe_directory_sharded(WipeSession&, const std::string&, const WipeOptions&, const ShardOptions&) {
+    WipeResult r;
+    r.message = "Sharded mode is not supported on this platform";
+    return r;
+}
+
+#endif
+
+} // namespace securewipe
@@ -0,0 +1,40 @@
+#pragma once
+// Coordinator-free cooperative wipe of one tree by several processes or hosts.
+//
+// The tree is split into units (directories at a fixed depth, plus the loose
+// files of the levels above it). Participants claim a unit by creating its
+// lease file with O_CREAT|O_EXCL in a shared lease directory, heartbeat the
+// lease by touching it, and mark the unit finished by linking in a .done file
+// holding its counters (the first one wins). A lease not touched for lease_ttl
+// seconds may be taken over by creating the next generation of it; the
+// previous holder notices on its next heartbeat, or before it publishes, and
+// abandons the unit. Every participant finishes by merging all .done files
+// into one report.
+#include "secure_wipe.h"
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+struct ShardOptions {
+    std::string lease_dir;      // shared, outside the tree being wiped
+    std::string worker_id;      // default: hostname:pid
+    unsigned lease_ttl = 60;    // seconds without heartbeat before takeover
+    unsigned depth = 1;         // directory depth at which the tree is split
+};
+
+// One unit of work: a directory relative to the split root ("." is the root).
+struct ShardUnit {
+    std::string rel;
+    bool recursive;         // false: only the regular files directly inside
+};
+
+// Split `root` at `depth`: every directory above that depth contributes its
+// loose files as a unit, every directory at that depth is a recursive unit.
+// The result depends only on the tree, so all participants agree on it.
+std::vector<ShardUnit> split_tree(const std::string& root, unsigned depth);
+
+WipeResult wipe_directory_sharded(WipeSession& session, const std::string& dir, const WipeOptions& opt,
+                                  const ShardOptions& sh);
+
+} // namespace securewipe
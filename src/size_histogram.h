@@ -0,0 +1,58 @@
+#pragma once
+// Log2 file-size histogram: bucket 0 holds empty files, bucket b >= 1 holds
+// sizes in [2^(b-1), 2^b).
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+struct SizeHistogram {
+    static const int kBuckets = 64;
+    std::uint64_t counts[kBuckets] = {};
+
+    static int bucket(std::uint64_t size) {
+        int b = 0;
+        while (size != 0 && b < kBuckets - 1) {
+            size >>= 1;
+            ++b;
+        }
+        return b;
+    }
+
+    void add(std::uint64_t size) { ++counts[bucket(size)]; }
+
+    void merge(const SizeHistogram& o) {
+        for (int i = 0; i < kBuckets; ++i) counts[i] += o.counts[i];
+    }
+
+    // Compact wire form: trailing empty buckets dropped.
+    std::vector<std::uint64_t> to_vector() const {
+        int n = kBuckets;
+        while (n > 0 && counts[n - 1] == 0) --n;
+        return std::vector<std::uint64_t>(counts, counts + n);
+    }
+
+    void merge_vector(const std::vector<std::uint64_t>& v) {
+        for (std::size_t i = 0; i < v.size() && i < static_cast<std::size_t>(kBuckets); ++i) counts[i] += v[i];
+    }
+
+    // One "  [lo, hi)  count" line per non-empty bucket.
+    std::string format(const char* indent = "  ") const {
+        static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB"};
+        auto human = [](int log2) {
+            return std::to_string(1ull << (log2 % 10)) + " " + units[log2 / 10];
+        };
+        std::string out;
+        for (int b = 0; b < kBuckets; ++b) {
+            if (counts[b] == 0) continue;
+            out += indent;
+            if (b == 0) out += "[0]";
+            else out += "[" + human(b - 1) + ", " + human(b) + ")";
+            out += "  " + std::to_string(counts[b]) + "\n";
+        }
+        return out;
+    }
+};
+
+} // namespace securewipe
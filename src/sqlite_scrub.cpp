@@ -0,0 +1,516 @@
+#include "sqlite_scrub.h"
+#include "wipe_engine.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace securewipe {
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace {
+
+// Lock bytes of SQLite's unix VFS (os_unix.c): PENDING_BYTE, then
+// RESERVED_BYTE, then the 510-byte SHARED range.
+constexpr off_t kPendingByte = 0x40000000;
+constexpr off_t kLockRange = 512;
+
+constexpr std::size_t kHeaderSize = 100;
+const char kMagic[] = "SQLite format 3";
+
+std::string errstr(const char* prefix) {
+    return std::string(prefix) + ": " + std::strerror(errno);
+}
+
+std::uint16_t get_u16(const std::uint8_t* p) {
+    return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+std::uint32_t get_u32(const std::uint8_t* p) {
+    return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+           (static_cast<std::uint32_t>(p[2]) << 8) | p[3];
+}
+
+void put_u32(std::uint8_t* p, std::uint32_t v) {
+    p[0] = static_cast<std::uint8_t>(v >> 24);
+    p[1] = static_cast<std::uint8_t>(v >> 16);
+    p[2] = static_cast<std::uint8_t>(v >> 8);
+    p[3] = static_cast<std::uint8_t>(v);
+}
+
+// SQLite varint: up to 9 bytes, 7 bits per byte, the 9th byte contributes 8.
+// Returns the bytes consumed, or 0 if it runs past `end`.
+std::size_t get_varint(const std::uint8_t* p, const std::uint8_t* end, std::uint64_t& v) {
+    v = 0;
+    for (std::size_t i = 0; i < 9; ++i) {
+        if (p + i >= end) return 0;
+        if (i == 8) {
+            v = (v << 8) | p[i];
+            return 9;
+        }
+        v = (v << 7) | (p[i] & 0x7f);
+        if (!(p[i] & 0x80)) return i + 1;
+    }
+    return 0;
+}
+
+// Size of a record value with the given serial type.
+std::uint64_t serial_size(std::uint64_t t) {
+    static const std::uint8_t fixed[] = {0, 1, 2, 3, 4, 6, 8, 8, 0, 0, 0, 0};
+    return t < 12 ? fixed[t] : (t - 12) / 2;
+}
+
+bool read_at(int fd, std::uint8_t* buf, std::size_t n, std::uint64_t off) {
+    while (n > 0) {
+        const ssize_t got = ::pread(fd, buf, n, static_cast<off_t>(off));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        buf += got;
+        n -= static_cast<std::size_t>(got);
+        off += static_cast<std::uint64_t>(got);
+    }
+    return true;
+}
+
+bool write_at(int fd, const std::uint8_t* buf, std::size_t n, std::uint64_t off) {
+    while (n > 0) {
+        const ssize_t put = ::pwrite(fd, buf, n, static_cast<off_t>(off));
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return false;
+        buf += put;
+        n -= static_cast<std::size_t>(put);
+        off += static_cast<std::uint64_t>(put);
+    }
+    return true;
+}
+
+struct Region {
+    std::uint64_t off;
+    std::uint64_t len;
+};
+
+// Collects the free byte ranges of one database file. Nothing is written
+// until the whole file has been parsed, so a corrupt database is left alone.
+class Scanner {
+public:
+    Scanner(int fd, std::uint32_t page_size, std::uint32_t npages)
+        : fd_(fd), page_size_(page_size), usable_(page_size), npages_(npages), owner_(npages + 1, 0) {}
+
+    bool scan_freelist(std::uint32_t trunk, std::uint32_t expected);
+    bool scan_tree(std::uint32_t root, std::vector<std::uint32_t>* roots);
+
+    const std::string& error() const { return err_; }
+    std::vector<Region>& regions() { return regions_; }
+
+    std::uint64_t free_pages = 0;
+    std::uint64_t btree_pages = 0;
+    std::uint64_t overflow_pages = 0;
+
+private:
+    enum : std::uint8_t { Unseen, Freelist, Btree, Overflow };
+
+    std::uint64_t page_off(std::uint32_t pgno) const { return static_cast<std::uint64_t>(pgno - 1) * page_size_; }
+    bool fail(const std::string& why) {
+        err_ = why + " (corrupt database?)";
+        return false;
+    }
+    bool claim(std::uint32_t pgno, std::uint8_t kind) {
+        if (pgno == 0 || pgno > npages_) return fail("page " + std::to_string(pgno) + " out of range");
+        if (owner_[pgno] != Unseen) return fail("page " + std::to_string(pgno) + " referenced twice");
+        owner_[pgno] = kind;
+        return true;
+    }
+    bool read_page(std::uint32_t pgno) {
+        page_.resize(page_size_);
+        if (!read_at(fd_, page_.data(), page_size_, page_off(pgno))) {
+            err_ = errstr(("Failed to read page " + std::to_string(pgno)).c_str());
+            return false;
+        }
+        return true;
+    }
+    void add(std::uint64_t off, std::uint64_t len) {
+        if (len > 0) regions_.push_back(Region{off, len});
+    }
+    std::uint64_t local_size(bool table_leaf, std::uint64_t payload) const;
+    bool follow_overflow(std::uint32_t pgno, std::uint64_t remaining, std::vector<std::uint8_t>* payload);
+
+    int fd_;
+    std::uint32_t page_size_;
+    std::uint32_t usable_;
+    std::uint32_t npages_;
+    std::vector<std::uint8_t> owner_;   // per page: Unseen / Freelist / Btree / Overflow
+    std::vector<std::uint8_t> page_;
+    std::vector<Region> regions_;
+    std::string err_;
+};
+
+bool Scanner::scan_freelist(std::uint32_t trunk, std::uint32_t expected) {
+    const std::uint32_t max_leaves = usable_ / 4 - 2;
+    while (trunk != 0) {
+        if (!claim(trunk, Freelist) || !read_page(trunk)) return false;
+        const std::uint32_t next = get_u32(page_.data());
+        const std::uint32_t leaves = get_u32(page_.data() + 4);
+        if (leaves > max_leaves) return fail("freelist trunk page " + std::to_string(trunk) + " has too many leaves");
+        for (std::uint32_t i = 0; i < leaves; ++i) {
+            const std::uint32_t leaf = get_u32(page_.data() + 8 + 4 * i);
+            if (!claim(leaf, Freelist)) return false;
+            add(page_off(leaf), page_size_);
+            ++free_pages;
+        }
+        add(page_off(trunk) + 8 + 4 * leaves, page_size_ - 8 - 4 * leaves);
+        ++free_pages;
+        trunk = next;
+    }
+    if (free_pages != expected) {
+        return fail("freelist holds " + std::to_string(free_pages) + " pages, header says " +
+                    std::to_string(expected));
+    }
+    return true;
+}
+
+std::uint64_t Scanner::local_size(bool table_leaf, std::uint64_t payload) const {
+    // Spill thresholds from the file format specification.
+    const std::uint64_t u = usable_;
+    const std::uint64_t x = table_leaf ? u - 35 : ((u - 12) * 64 / 255) - 23;
+    const std::uint64_t m = ((u - 12) * 32 / 255) - 23;
+    if (payload <= x) return payload;
+    const std::uint64_t k = m + ((payload - m) % (u - 4));
+    return k <= x ? k : m;
+}
+
+bool Scanner::follow_overflow(std::uint32_t pgno, std::uint64_t remaining, std::vector<std::uint8_t>* payload) {
+    std::vector<std::uint8_t> buf(page_size_);
+    while (remaining > 0) {
+        if (!claim(pgno, Overflow)) return false;
+        if (!read_at(fd_, buf.data(), page_size_, page_off(pgno))) {
+            err_ = errstr("Failed to read overflow page");
+            return false;
+        }
+        ++overflow_pages;
+        const std::uint64_t chunk = std::min<std::uint64_t>(remaining, usable_ - 4);
+        if (payload) payload->insert(payload->end(), buf.begin() + 4, buf.begin() + 4 + chunk);
+        remaining -= chunk;
+        if (remaining == 0) {
+            add(page_off(pgno) + 4 + chunk, usable_ - 4 - chunk);
+        } else {
+            pgno = get_u32(buf.data());
+        }
+    }
+    return true;
+}
+
+// rootpage (column 4) of one sqlite_schema record.
+void schema_rootpage(const std::vector<std::uint8_t>& rec, std::vector<std::uint32_t>& roots) {
+    const std::uint8_t* b = rec.data();
+    const std::uint8_t* e = b + rec.size();
+    std::uint64_t hdr = 0;
+    std::size_t n = get_varint(b, e, hdr);
+    if (n == 0 || hdr > rec.size()) return;
+    const std::uint8_t* hp = b + n;
+    const std::uint8_t* hend = b + hdr;
+    std::uint64_t types[4];
+    for (auto& t : types) {
+        if (hp >= hend || (n = get_varint(hp, hend, t)) == 0) return;
+        hp += n;
+    }
+    const std::uint64_t off = hdr + serial_size(types[0]) + serial_size(types[1]) + serial_size(types[2]);
+    const std::uint64_t t = types[3];
+    if (t < 1 || t > 6 || off + serial_size(t) > rec.size()) return;
+    std::int64_t v = static_cast<std::int8_t>(b[off]);     // sign-extend the first byte
+    for (std::uint64_t i = 1; i < serial_size(t); ++i) v = (v << 8) | b[off + i];
+    if (v > 0 && v <= static_cast<std::int64_t>(UINT32_MAX)) roots.push_back(static_cast<std::uint32_t>(v));
+}
+
+bool Scanner::scan_tree(std::uint32_t root, std::vector<std::uint32_t>* roots) {
+    std::vector<std::uint32_t> stack{root};
+    while (!stack.empty()) {
+        const std::uint32_t pgno = stack.back();
+        stack.pop_back();
+        if (!claim(pgno, Btree) || !read_page(pgno)) return false;
+        ++btree_pages;
+
+        const std::uint8_t* p = page_.data();
+        const std::size_t hdr = pgno == 1 ? kHeaderSize : 0;
+        const std::uint8_t type = p[hdr];
+        if (type != 0x02 && type != 0x05 && type != 0x0a && type != 0x0d) {
+            return fail("page " + std::to_string(pgno) + " is not a b-tree page");
+        }
+        const bool interior = type == 0x02 || type == 0x05;
+        const std::size_t hdr_len = interior ? 12 : 8;
+        const std::uint32_t ncells = get_u16(p + hdr + 3);
+        std::uint32_t content = get_u16(p + hdr + 5);
+        if (content == 0) content = 65536;
+        const std::size_t ptr_end = hdr + hdr_len + 2 * static_cast<std::size_t>(ncells);
+        if (ptr_end > content || content > usable_) return fail("bad cell layout on page " + std::to_string(pgno));
+
+        // Unallocated space between the cell pointers and the cell content.
+        add(page_off(pgno) + ptr_end, content - ptr_end);
+
+        // Freeblocks: a chain of (next, size) headers in ascending order.
+        std::uint32_t fb = get_u16(p + hdr + 1);
+        while (fb != 0) {
+            if (fb < content || fb + 4 > usable_) return fail("bad freeblock on page " + std::to_string(pgno));
+            const std::uint32_t size = get_u16(p + fb + 2);
+            const std::uint32_t next = get_u16(p + fb);
+            if (size < 4 || fb + size > usable_ || (next != 0 && next < fb + size)) {
+                return fail("bad freeblock on page " + std::to_string(pgno));
+            }
+            add(page_off(pgno) + fb + 4, size - 4);
+            fb = next;
+        }
+
+        const std::uint8_t* end = p + usable_;
+        for (std::uint32_t i = 0; i < ncells; ++i) {
+            const std::uint32_t cell = get_u16(p + hdr + hdr_len + 2 * i);
+            if (cell < content || cell >= usable_) return fail("bad cell pointer on page " + std::to_string(pgno));
+            const std::uint8_t* c = p + cell;
+            if (interior) {
+                if (c + 4 > end) return fail("truncated cell on page " + std::to_string(pgno));
+                stack.push_back(get_u32(c));
+                if (type == 0x05) continue;     // table interior: child + rowid, no payload
+                c += 4;
+            }
+            std::uint64_t payload = 0, rowid = 0;
+            std::size_t n = get_varint(c, end, payload);
+            if (n == 0) return fail("truncated cell on page " + std::to_string(pgno));
+            c += n;
+            if (type == 0x0d) {
+                if ((n = get_varint(c, end, rowid)) == 0) return fail("truncated cell on page " + std::to_string(pgno));
+                c += n;
+            }
+            const std::uint64_t local = local_size(type == 0x0d, payload);
+            if (local > static_cast<std::uint64_t>(end - c)) return fail("truncated cell on page " + std::to_string(pgno));
+
+            const bool want = roots && type == 0x0d;
+            std::vector<std::uint8_t> rec;
+            if (want) rec.assign(c, c + local);
+            if (payload > local) {
+                if (local + 4 > static_cast<std::uint64_t>(end - c)) {
+                    return fail("truncated cell on page " + std::to_string(pgno));
+                }
+                const std::uint32_t first = get_u32(c + local);
+                if (!follow_overflow(first, payload - local, want ? &rec : nullptr)) return false;
+            }
+            if (want) schema_rootpage(rec, *roots);
+        }
+        if (interior) stack.push_back(get_u32(p + hdr + 8));
+    }
+    return true;
+}
+
+} // namespace
+
+WipeResult sqlite_scrub(const std::string& db, const WipeOptions& opt, const SqliteScrubOptions& so) {
+    WipeResult r;
+    if (opt.passes <= 0) {
+        r.message = "passes must be >= 1";
+        return r;
+    }
+
+    const int fd = ::open(db.c_str(), (so.dry_run ? O_RDONLY : O_RDWR) | O_CLOEXEC);
+    if (fd < 0) {
+        r.message = errstr("Failed to open database");
+        return r;
+    }
+    struct FdGuard {
+        int fd;
+        ~FdGuard() { ::close(fd); }   // also releases the lock
+    } guard{fd};
+
+    // Exclusive lock as a SQLite writer would take it; a dry run only needs
+    // the shared range, like a reader.
+    struct flock fl;
+    std::memset(&fl, 0, sizeof(fl));
+    fl.l_type = so.dry_run ? F_RDLCK : F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = so.dry_run ? kPendingByte + 2 : kPendingByte;
+    fl.l_len = so.dry_run ? kLockRange - 2 : kLockRange;
+    if (::fcntl(fd, F_SETLK, &fl) != 0) {
+        r.message = "Database is in use by another connection";
+        return r;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        r.message = errstr("Failed to stat database");
+        return r;
+    }
+    std::uint8_t hdr[kHeaderSize];
+    if (st.st_size < static_cast<off_t>(kHeaderSize) || !read_at(fd, hdr, kHeaderSize, 0) ||
+        std::memcmp(hdr, kMagic, sizeof(kMagic)) != 0) {
+        r.message = "Not an SQLite 3 database";
+        return r;
+    }
+
+    std::uint32_t page_size = get_u16(hdr + 16);
+    if (page_size == 1) page_size = 65536;
+    if (page_size < 512 || page_size > 65536 || (page_size & (page_size - 1)) != 0) {
+        r.message = "Invalid page size in database header";
+        return r;
+    }
+    if (hdr[20] != 0) {
+        r.message = "Databases with reserved bytes per page (encryption or checksums) are not supported";
+        return r;
+    }
+    const std::uint64_t file_pages = static_cast<std::uint64_t>(st.st_size) / page_size;
+    const bool count_valid = get_u32(hdr + 24) == get_u32(hdr + 92) && get_u32(hdr + 28) != 0;
+    const std::uint32_t npages = static_cast<std::uint32_t>(
+        count_valid ? std::min<std::uint64_t>(get_u32(hdr + 28), file_pages) : file_pages);
+
+    // Sidecars: a non-empty WAL holds newer pages, a hot journal must be rolled back first.
+    struct stat jst;
+    const std::string wal = db + "-wal";
+    if (::stat(wal.c_str(), &jst) == 0 && jst.st_size > 0) {
+        r.message = "WAL file is not empty; checkpoint first (PRAGMA wal_checkpoint(TRUNCATE))";
+        return r;
+    }
+    const std::string journal = db + "-journal";
+    std::uint64_t journal_size = 0;
+    if (::stat(journal.c_str(), &jst) == 0 && jst.st_size > 0) {
+        const int jfd = ::open(journal.c_str(), O_RDONLY | O_CLOEXEC);
+        std::uint8_t first = 0;
+        const bool ok = jfd >= 0 && read_at(jfd, &first, 1, 0);
+        if (jfd >= 0) ::close(jfd);
+        if (!ok) {
+            r.message = errstr("Failed to read rollback journal");
+            return r;
+        }
+        if (first != 0) {
+            r.message = "Hot rollback journal present; open the database with sqlite3 once to roll it back";
+            return r;
+        }
+        journal_size = static_cast<std::uint64_t>(jst.st_size);    // persisted, holds stale pages
+    }
+
+    Scanner scan(fd, page_size, npages);
+    if (!scan.scan_freelist(get_u32(hdr + 32), get_u32(hdr + 36))) {
+        r.message = scan.error();
+        return r;
+    }
+    if (!so.freelist_only) {
+        std::vector<std::uint32_t> roots;
+        if (!scan.scan_tree(1, &roots)) {
+            r.message = scan.error();
+            return r;
+        }
+        std::sort(roots.begin(), roots.end());
+        roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+        for (const std::uint32_t root : roots) {
+            if (!scan.scan_tree(root, nullptr)) {
+                r.message = scan.error();
+                return r;
+            }
+        }
+    }
+
+    // Coalesce adjacent ranges so runs of free pages become large writes.
+    std::vector<Region>& regions = scan.regions();
+    std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) { return a.off < b.off; });
+    std::vector<Region> merged;
+    std::uint64_t free_bytes = 0;
+    for (const Region& g : regions) {
+        free_bytes += g.len;
+        if (!merged.empty() && merged.back().off + merged.back().len == g.off) merged.back().len += g.len;
+        else merged.push_back(g);
+    }
+
+    const std::string summary = "pages=" + std::to_string(npages) +
+                                ", free pages=" + std::to_string(scan.free_pages) +
+                                ", b-tree pages=" + std::to_string(scan.btree_pages) +
+                                ", overflow pages=" + std::to_string(scan.overflow_pages) +
+                                ", free bytes=" + std::to_string(free_bytes) +
+                                " in " + std::to_string(merged.size()) + " ranges" +
+                                (journal_size ? ", journal bytes=" + std::to_string(journal_size) : "");
+    if (so.dry_run) {
+        r.ok = true;
+        r.message = "Dry-run complete. " + summary + ". Re-run with --yes to execute.";
+        return r;
+    }
+
+    detail::WipeContext ctx;
+    const std::size_t block = opt.block_size > 0 ? opt.block_size : (1u << 20);
+    ctx.buf.resize(block);
+    std::uint64_t written = 0;
+    for (int pass = 1; pass <= opt.passes; ++pass) {
+        for (const Region& g : merged) {
+            std::uint64_t off = g.off, left = g.len;
+            while (left > 0) {
+                const std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(left, block));
+                detail::fill_pattern(ctx, opt.pattern, ctx.buf.data(), chunk);
+                if (!write_at(fd, ctx.buf.data(), chunk, off)) {
+                    r.message = errstr("Write failed during scrub (database free space partially overwritten)");
+                    return r;
+                }
+                off += chunk;
+                left -= chunk;
+                written += chunk;
+            }
+        }
+        if (::fsync(fd) != 0) {
+            r.message = errstr("fsync failed");
+            return r;
+        }
+    }
+
+    // Bump the file change counter so other connections drop cached copies of
+    // the scrubbed pages instead of writing their stale bytes back.
+    std::uint8_t counter[4];
+    put_u32(counter, get_u32(hdr + 24) + 1);
+    if (!write_at(fd, counter, 4, 24) || (count_valid && !write_at(fd, counter, 4, 92)) || ::fsync(fd) != 0) {
+        r.message = errstr("Failed to update the change counter");
+        return r;
+    }
+
+    // A persisted journal is inactive while its header is zero; keep the header
+    // sector zeroed and overwrite the stale page images after it.
+    if (journal_size > 0) {
+        const int jfd = ::open(journal.c_str(), O_WRONLY | O_CLOEXEC);
+        if (jfd < 0) {
+            r.message = errstr("Failed to open rollback journal");
+            return r;
+        }
+        bool ok = true;
+        for (int pass = 1; ok && pass <= opt.passes; ++pass) {
+            std::uint64_t off = 0;
+            while (ok && off < journal_size) {
+                const std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(journal_size - off, block));
+                detail::fill_pattern(ctx, opt.pattern, ctx.buf.data(), chunk);
+                if (off == 0) std::memset(ctx.buf.data(), 0, std::min<std::size_t>(chunk, 512));
+                ok = write_at(jfd, ctx.buf.data(), chunk, off);
+                off += chunk;
+                written += chunk;
+            }
+            ok = ok && ::fsync(jfd) == 0;
+        }
+        ::close(jfd);
+        if (!ok) {
+            r.message = errstr("Failed to overwrite rollback journal");
+            return r;
+        }
+    }
+
+    r.ok = true;
+    r.stats.bytes_overwritten = written;
+    r.message = "sqlite-scrub complete. " + summary + ", passes=" + std::to_string(opt.passes);
+    return r;
+}
+
+#else
+
+WipeResult sqlite_scrub(const std::string&, const WipeOptions&, const SqliteScrubOptions&) {
+    WipeResult r;
+    r.message = "sqlite-scrub is not supported on this platform";
+    return r;
+}
+
+#endif
+
+} // namespace securewipe
@@ -0,0 +1,31 @@
+#pragma once
+// In-place scrub of the free space inside an SQLite database file.
+//
+// VACUUM rewrites the whole database; this instead parses the file format
+// directly and overwrites only bytes that hold no live data:
+//   - freelist leaf pages, and the unused tail of freelist trunk pages
+//   - on every b-tree page: the gap between the cell pointer array and the
+//     cell content area, and the bodies of freeblocks
+//   - the unused tail of the last page of each overflow chain
+// Live records, page headers and pointers are never written, so the result
+// is still a valid database. Writes are proportional to free space; finding
+// the b-tree gaps reads every b-tree page once (freelist_only skips that).
+//
+// The database must be idle: an exclusive lock is taken the way SQLite's
+// unix VFS does, and the scrub refuses to run with a hot rollback journal or
+// a non-empty WAL (checkpoint first). A persisted, non-hot -journal holds
+// stale page images and is overwritten as well. Databases with reserved
+// bytes per page (encryption or checksum extensions) are refused.
+#include "secure_wipe.h"
+#include <string>
+
+namespace securewipe {
+
+struct SqliteScrubOptions {
+    bool freelist_only = false;     // skip the b-tree walk
+    bool dry_run = false;           // report what would be overwritten
+};
+
+WipeResult sqlite_scrub(const std::string& db, const WipeOptions& opt, const SqliteScrubOptions& so);
+
+} // namespace securewipe
@@ -0,0 +1,377 @@
+#include "tree_walk.h"
+#include "dir_index.h"
+#include "path_filter.h"
+#include "protect.h"
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/sysmacros.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+
+bool stat_entry_at(int dirfd, const std::string& name, EntryInfo& info) {
+    struct statx stx;
+    const unsigned mask = STATX_TYPE | STATX_SIZE | STATX_BLOCKS | STATX_INO | STATX_NLINK | STATX_UID |
+                          STATX_MTIME | STATX_ATIME | STATX_CTIME;
+    const int flags = AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC | (name.empty() ? AT_EMPTY_PATH : 0);
+    if (::statx(dirfd, name.c_str(), flags, mask, &stx) != 0) {
+        info.kind = EntryInfo::Missing;
+        return false;
+    }
+    const unsigned fmt = stx.stx_mode & S_IFMT;
+    info.kind = fmt == S_IFREG ? EntryInfo::Regular
+              : fmt == S_IFDIR ? EntryInfo::Directory
+              : fmt == S_IFLNK ? EntryInfo::Symlink
+                               : EntryInfo::Other;
+    info.size = stx.stx_size;
+    info.allocated = stx.stx_blocks * 512;
+    info.dev = static_cast<std::uint64_t>(makedev(stx.stx_dev_major, stx.stx_dev_minor));   // same as st_dev
+    info.ino = stx.stx_ino;
+    info.nlink = stx.stx_nlink;
+    info.mtime = stx.stx_mtime.tv_sec;
+    info.atime = stx.stx_atime.tv_sec;
+    info.ctime = stx.stx_ctime.tv_sec;
+    info.mtime_nsec = stx.stx_mtime.tv_nsec;
+    info.ctime_nsec = stx.stx_ctime.tv_nsec;
+    info.uid = stx.stx_uid;
+    return true;
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+bool stat_entry_at(int dirfd, const std::string& name, EntryInfo& info) {
+    struct stat st;
+    const int rc = name.empty() ? ::fstat(dirfd, &st) : ::fstatat(dirfd, name.c_str(), &st, AT_SYMLINK_NOFOLLOW);
+    if (rc != 0) {
+        info.kind = EntryInfo::Missing;
+        return false;
+    }
+    info.kind = S_ISREG(st.st_mode) ? EntryInfo::Regular
+              : S_ISDIR(st.st_mode) ? EntryInfo::Directory
+              : S_ISLNK(st.st_mode) ? EntryInfo::Symlink
+                                    : EntryInfo::Other;
+    info.size = static_cast<std::uint64_t>(st.st_size);
+    info.allocated = static_cast<std::uint64_t>(st.st_blocks) * 512;
+    info.dev = static_cast<std::uint64_t>(st.st_dev);
+    info.ino = static_cast<std::uint64_t>(st.st_ino);
+    info.nlink = static_cast<std::uint64_t>(st.st_nlink);
+    info.mtime = st.st_mtime;
+    info.atime = st.st_atime;
+    info.ctime = st.st_ctime;
+#if defined(__APPLE__)
+    info.mtime_nsec = static_cast<std::uint32_t>(st.st_mtimespec.tv_nsec);
+    info.ctime_nsec = static_cast<std::uint32_t>(st.st_ctimespec.tv_nsec);
+#else
+    info.mtime_nsec = static_cast<std::uint32_t>(st.st_mtim.tv_nsec);
+    info.ctime_nsec = static_cast<std::uint32_t>(st.st_ctim.tv_nsec);
+#endif
+    info.uid = st.st_uid;
+    return true;
+}
+
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+
+bool stat_entry(const std::string& path, EntryInfo& info) {
+    return stat_entry_at(AT_FDCWD, path, info);
+}
+
+// A directory below `root_fd` by its relative path, without following a
+// symlink in any component or leaving the root. Empty `rel` is the root.
+static int open_dir_beneath(int root_fd, const std::string& rel) {
+    const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    if (rel.empty()) return ::openat(root_fd, ".", flags);
+    int fd = open_no_symlinks(root_fd, rel, flags, true);
+    if (fd >= 0 || errno != ENOSYS) return fd;
+    // Without openat2: one component at a time, each with O_NOFOLLOW.
+    fd = ::openat(root_fd, ".", flags);
+    std::size_t b = 0;
+    while (fd >= 0 && b < rel.size()) {
+        std::size_t e = rel.find('/', b);
+        if (e == std::string::npos) e = rel.size();
+        const std::string c = rel.substr(b, e - b);
+        b = e + 1;
+        if (c.empty() || c == ".") continue;
+        if (c == "..") {
+            ::close(fd);
+            errno = EXDEV;
+            return -1;
+        }
+        const int next = ::openat(fd, c.c_str(), flags | O_NOFOLLOW);
+        ::close(fd);
+        fd = next;
+    }
+    return fd;
+}
+
+#else
+
+bool stat_entry(const std::string& path, EntryInfo& info) {
+    std::error_code ec;
+    const fs::file_status st = fs::symlink_status(path, ec);
+    if (ec || !fs::exists(st)) {
+        info.kind = EntryInfo::Missing;
+        return false;
+    }
+    info.kind = fs::is_regular_file(st) ? EntryInfo::Regular
+              : fs::is_directory(st)    ? EntryInfo::Directory
+              : fs::is_symlink(st)      ? EntryInfo::Symlink
+                                        : EntryInfo::Other;
+    if (info.kind == EntryInfo::Regular) {
+        info.size = fs::file_size(path, ec);
+        info.allocated = info.size;
+    }
+    // file_time_type has an unspecified epoch in C++17; translate via "now" on both clocks.
+    const auto ft = fs::last_write_time(path, ec);
+    if (!ec) {
+        const auto age = fs::file_time_type::clock::now() - ft;
+        info.mtime = static_cast<std::int64_t>(std::time(nullptr)) -
+                     std::chrono::duration_cast<std::chrono::seconds>(age).count();
+        info.atime = info.mtime;
+        info.ctime = info.mtime;
+    }
+    return true;
+}
+
+#endif
+
+bool walk_tree(const std::string& root, const PathFilter* filter, const WalkCallbacks& cb, WalkIndex* index,
+               int root_fd) {
+    struct Frame {
+        std::string path;
+        std::string rel;        // below root_fd ("" for the root)
+        FilterState state;
+        EntryInfo info;
+        std::uint32_t prev;     // record in index->prev, or DirIndex::npos
+        std::uint32_t node;     // node in index->next, or DirIndex::npos
+        std::uint32_t id;       // on_dir number
+    };
+    const DirIndex* prev = index ? index->prev : nullptr;
+    DirIndexBuilder* next = index ? index->next : nullptr;
+    if (prev && prev->empty()) prev = nullptr;
+#if !defined(__unix__) && !defined(__APPLE__)
+    root_fd = -1;
+#endif
+
+    EntryInfo root_info;
+#if defined(__unix__) || defined(__APPLE__)
+    if (root_fd >= 0) stat_entry_at(root_fd, std::string(), root_info);
+    else
+#endif
+        stat_entry(root, root_info);
+
+    if (cb.on_dir) cb.on_dir(root, root_info, kNoDir);
+    std::uint32_t dir_count = 1;
+
+    std::vector<Frame> stack;
+    stack.push_back(Frame{root, std::string(), filter ? filter->root_state() : FilterState(), root_info,
+                          prev ? prev->root() : DirIndex::npos,
+                          next ? next->add(DirIndex::npos, std::string(), root_info) : DirIndex::npos, 0});
+    const std::int64_t now = static_cast<std::int64_t>(std::time(nullptr));
+
+    // Queue a subdirectory unless the filter prunes it.
+    auto descend = [&](const Frame& parent, const std::string& name, std::string full, const EntryInfo& info,
+                       FilterState st) {
+        if (filter && filter->prune_dir(st)) return;
+        if (cb.enter_dir && !cb.enter_dir(full, info)) return;
+        if (cb.on_dir) cb.on_dir(full, info, parent.id);
+        const std::uint32_t id = dir_count++;
+        const std::uint32_t prev_rec = prev ? prev->find_child(parent.prev, name) : DirIndex::npos;
+        const std::uint32_t node = next ? next->add(parent.node, name, info) : DirIndex::npos;
+        std::string rel = root_fd >= 0 ? (parent.rel.empty() ? name : parent.rel + "/" + name) : std::string();
+        stack.push_back(Frame{std::move(full), std::move(rel), std::move(st), info, prev_rec, node, id});
+    };
+
+    while (!stack.empty()) {
+        Frame frame = std::move(stack.back());
+        stack.pop_back();
+
+        // With a root fd every directory is opened beneath it, and its
+        // entries are examined relative to that, never by path.
+        int dfd = -1;
+#if defined(__unix__) || defined(__APPLE__)
+        if (root_fd >= 0) {
+            dfd = open_dir_beneath(root_fd, frame.rel);
+            if (dfd < 0) {
+                if (next) next->set_pending(frame.node, UINT32_MAX);
+                continue;
+            }
+        }
+        auto stat_child = [&](const std::string& name, const std::string& full, EntryInfo& info) {
+            return dfd >= 0 ? stat_entry_at(dfd, name, info) : stat_entry(full, info);
+        };
+#else
+        auto stat_child = [&](const std::string&, const std::string& full, EntryInfo& info) {
+            return stat_entry(full, info);
+        };
+#endif
+
+        // Unchanged since the last run and no candidates then: nothing can
+        // have been added here, so only the recorded subdirectories are visited.
+        if (frame.prev != DirIndex::npos && prev->at(frame.prev).pending == 0 && prev->unchanged(frame.prev, frame.info)) {
+            ++index->dirs_reused;
+            const DirRecord& rec = prev->at(frame.prev);
+            bool stopped = false;
+            for (std::uint32_t c = rec.first_child; c < rec.first_child + rec.child_count; ++c) {
+                if (cb.should_stop && cb.should_stop()) {
+                    stopped = true;
+                    break;
+                }
+                const std::string name = prev->name(c);
+                std::string full = (fs::path(frame.path) / name).string();
+                EntryInfo info;
+                if (!stat_child(name, full, info) || info.kind != EntryInfo::Directory) continue;
+                FilterState st;
+                if (filter) filter->step(frame.state, name, true, st);
+                descend(frame, name, std::move(full), info, std::move(st));
+            }
+#if defined(__unix__) || defined(__APPLE__)
+            if (dfd >= 0) ::close(dfd);
+#endif
+            if (stopped) return false;
+            continue;
+        }
+
+        std::uint32_t pending = 0;
+        bool complete = true;
+        bool stopped = false;
+        // One entry of the listing; false abandons the walk.
+        auto visit = [&](const std::string& name) {
+            if (cb.should_stop && cb.should_stop()) return false;
+            std::string full = (fs::path(frame.path) / name).string();
+            EntryInfo info;
+            if (!stat_child(name, full, info)) return true;
+
+            // Avoid following symlinks to prevent escaping the directory
+            if (info.kind != EntryInfo::Regular && info.kind != EntryInfo::Directory) return true;
+            const bool is_dir = info.kind == EntryInfo::Directory;
+
+            FilterState st;
+            if (filter) {
+                filter->step(frame.state, name, is_dir, st);
+            }
+
+            if (is_dir) {
+                descend(frame, name, std::move(full), info, std::move(st));
+            } else {
+                // Files the patterns select may be wiped now or later (age,
+                // size, a failed attempt), so their directory is re-read.
+                if (filter && !filter->name_selected(st)) return true;
+                ++pending;
+                if (filter && !filter->accept_file(st, info, now)) return true;
+                if (cb.on_file) cb.on_file(full, info, st.tag, frame.id);
+            }
+            return true;
+        };
+
+#if defined(__unix__) || defined(__APPLE__)
+        if (dfd >= 0) {
+            DIR* d = ::fdopendir(dfd);
+            if (!d) {
+                ::close(dfd);
+                complete = false;
+            } else {
+                for (;;) {
+                    errno = 0;
+                    const dirent* e = ::readdir(d);
+                    if (!e) {
+                        complete = errno == 0;
+                        break;
+                    }
+                    const char* n = e->d_name;
+                    if (n[0] == '.' && (n[1] == '\0' || (n[1] == '.' && n[2] == '\0'))) continue;
+                    if (!visit(n)) {
+                        stopped = true;
+                        break;
+                    }
+                }
+                ::closedir(d);
+            }
+        } else
+#endif
+        {
+            std::error_code ec;
+            for (auto it = fs::directory_iterator(fs::path(frame.path), fs::directory_options::skip_permission_denied,
+                                                  ec);
+                 it != fs::directory_iterator(); it.increment(ec)) {
+                if (ec) break;
+                if (!visit(it->path().filename().string())) {
+                    stopped = true;
+                    break;
+                }
+            }
+            if (ec) complete = false;
+        }
+        if (stopped) return false;
+        if (!complete) pending = UINT32_MAX;     // incomplete listing: never trust it
+        if (next) next->set_pending(frame.node, pending);
+    }
+    return true;
+}
+
+static std::size_t inode_hash(std::uint64_t dev, std::uint64_t ino) {
+    // splitmix64 finalizer over both halves of the key
+    std::uint64_t h = ino ^ (dev * 0x9e3779b97f4a7c15ULL);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return static_cast<std::size_t>(h);
+}
+
+std::uint64_t InodeMap::insert(std::uint64_t dev, std::uint64_t ino, std::uint64_t value) {
+    if ((size_ + 1) * 2 > slots_.size()) grow();    // load factor <= 1/2
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = inode_hash(dev, ino) & mask;; i = (i + 1) & mask) {
+        Slot& s = slots_[i];
+        if (s.value == kEmpty) {
+            s.dev = dev;
+            s.ino = ino;
+            s.value = value;
+            ++size_;
+            return value;
+        }
+        if (s.dev == dev && s.ino == ino) return s.value;
+    }
+}
+
+bool InodeMap::contains(std::uint64_t dev, std::uint64_t ino) const {
+    if (size_ == 0) return false;
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = inode_hash(dev, ino) & mask;; i = (i + 1) & mask) {
+        const Slot& s = slots_[i];
+        if (s.value == kEmpty) return false;
+        if (s.dev == dev && s.ino == ino) return true;
+    }
+}
+
+void InodeMap::grow() {
+    std::vector<Slot> old(slots_.empty() ? 64 : slots_.size() * 2);
+    old.swap(slots_);
+    const std::size_t mask = slots_.size() - 1;
+    for (const Slot& s : old) {
+        if (s.value == kEmpty) continue;
+        std::size_t i = inode_hash(s.dev, s.ino) & mask;
+        while (slots_[i].value != kEmpty) i = (i + 1) & mask;
+        slots_[i] = s;
+    }
+}
+
+} // namespace securewipe
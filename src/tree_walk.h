@@ -0,0 +1,97 @@
+#pragma once
+// Directory traversal shared by the directory-wiping modes.
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+class DirIndex;
+class DirIndexBuilder;
+class PathFilter;
+
+// Everything the traversal and the filters need, from one statx/lstat.
+struct EntryInfo {
+    enum Kind { Missing, Regular, Directory, Symlink, Other };
+    Kind kind = Missing;
+    std::uint64_t size = 0;
+    std::uint64_t allocated = 0;    // bytes allocated on disk
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;
+    std::uint64_t nlink = 1;
+    std::int64_t mtime = 0;         // seconds since the Unix epoch
+    std::int64_t atime = 0;
+    std::int64_t ctime = 0;
+    std::uint32_t mtime_nsec = 0;   // sub-second parts, where the platform has them
+    std::uint32_t ctime_nsec = 0;
+    std::int64_t uid = -1;
+};
+
+// Does not follow symlinks. Returns false if the entry cannot be examined.
+bool stat_entry(const std::string& path, EntryInfo& info);
+#if defined(__unix__) || defined(__APPLE__)
+// `name` relative to the directory `dirfd`; an empty name is `dirfd` itself.
+bool stat_entry_at(int dirfd, const std::string& name, EntryInfo& info);
+#endif
+
+// Traversed directories are numbered in on_dir order, the root 0; callbacks
+// get the number of the parent (kNoDir for the root) or containing directory,
+// so callers can keep paths as a tree instead of strings.
+constexpr std::uint32_t kNoDir = UINT32_MAX;
+
+struct WalkCallbacks {
+    // Asked before descending into a subdirectory; false prunes it unread.
+    std::function<bool(const std::string& dir, const EntryInfo& info)> enter_dir;
+    // Every directory that is traversed (the root first), in pre-order.
+    std::function<void(const std::string& dir, const EntryInfo& info, std::uint32_t parent)> on_dir;
+    // Every selected regular file, with the tag of the include rule that
+    // selected it (-1 without includes).
+    std::function<void(const std::string& path, const EntryInfo& info, std::int32_t tag, std::uint32_t dir)>
+        on_file;
+    // Polled per entry; returning true abandons the walk.
+    std::function<bool()> should_stop;
+};
+
+// Incremental mode (see dir_index.h).
+struct WalkIndex {
+    const DirIndex* prev = nullptr;     // previous run; directories it vouches for are not re-read
+    DirIndexBuilder* next = nullptr;    // receives every traversed directory
+    std::uint64_t dirs_reused = 0;      // out: directories taken from `prev` without readdir
+};
+
+// Depth-first walk below `root`. Symlinks are never followed or reported.
+// With a filter, excluded directories are pruned without being opened.
+// With `root_fd` (an open directory that `root` names), every directory is
+// opened beneath it without following symlinks, and entries are examined
+// relative to their directory, so re-pointing a path during the walk cannot
+// move it elsewhere; callbacks still get paths starting with `root`.
+// Returns false if the walk was stopped.
+bool walk_tree(const std::string& root, const PathFilter* filter, const WalkCallbacks& cb,
+               WalkIndex* index = nullptr, int root_fd = -1);
+
+// Inodes with several links, keyed by (dev, ino), so that each is
+// overwritten once however many of its names a walk meets. Open addressing
+// with linear probing over one flat array; only files with nlink > 1 go in,
+// so it stays small even on trees with millions of files.
+class InodeMap {
+public:
+    // The value stored for (dev, ino), inserting `value` if it is new.
+    std::uint64_t insert(std::uint64_t dev, std::uint64_t ino, std::uint64_t value);
+    bool contains(std::uint64_t dev, std::uint64_t ino) const;
+    std::size_t size() const { return size_; }
+
+private:
+    static constexpr std::uint64_t kEmpty = UINT64_MAX;
+    struct Slot {
+        std::uint64_t dev;
+        std::uint64_t ino;
+        std::uint64_t value = kEmpty;
+    };
+    void grow();
+
+    std::vector<Slot> slots_;
+    std::size_t size_ = 0;
+};
+
+} // namespace securewipe
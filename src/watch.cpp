@@ -0,0 +1,374 @@
+#include "watch.h"
+#include "output_sink.h"
+#include "path_filter.h"
+#include "tree_walk.h"
+#include "wipe_engine.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+#if defined(__linux__)
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+int g_wake_fd = -1;
+
+void on_signal(int) {
+    g_stop = 1;
+    if (g_wake_fd >= 0) {
+        const char b = 's';
+        (void)!::write(g_wake_fd, &b, 1);
+    }
+}
+
+std::int64_t now_sec() {
+    return static_cast<std::int64_t>(std::time(nullptr));
+}
+
+// Hashed timer wheel with one-second slots. Entries due more than one turn
+// ahead stay in their slot until their second comes round; stale entries
+// (the file was rescheduled) are recognised by generation and dropped.
+class TimerWheel {
+public:
+    explicit TimerWheel(std::int64_t now, std::size_t slots = 4096) : slots_(slots), now_(now) {}
+
+    void add(const std::string& path, std::uint64_t gen, std::int64_t due) {
+        if (due <= now_) due = now_ + 1;
+        slots_[static_cast<std::size_t>(due) % slots_.size()].push_back(Entry{path, gen, due});
+    }
+
+    // Advance to `now`, calling fire(path, gen) for every entry that is due.
+    template <class F>
+    void advance(std::int64_t now, F&& fire) {
+        const std::int64_t turns = std::min<std::int64_t>(now - now_, static_cast<std::int64_t>(slots_.size()));
+        for (std::int64_t i = 1; i <= turns; ++i) {
+            std::vector<Entry>& slot = slots_[static_cast<std::size_t>(now_ + i) % slots_.size()];
+            std::size_t keep = 0;
+            for (std::size_t j = 0; j < slot.size(); ++j) {
+                if (slot[j].due <= now) fire(slot[j].path, slot[j].gen);
+                else slot[keep++] = std::move(slot[j]);
+            }
+            slot.resize(keep);
+        }
+        if (now > now_) now_ = now;
+    }
+
+private:
+    struct Entry {
+        std::string path;
+        std::uint64_t gen;
+        std::int64_t due;
+    };
+    std::vector<std::vector<Entry>> slots_;
+    std::int64_t now_;      // last second processed
+};
+
+class Watcher {
+public:
+    Watcher(int ifd, const std::string& root, const WipeOptions& opt, const WatchOptions& wo, WipeSession& session)
+        : ifd_(ifd), root_(root), opt_(opt), wo_(wo), session_(session), wheel_(now_sec()) {}
+
+    bool init(std::string& err) {
+        // Patterns decide what is watched and scheduled; size, age and owner
+        // are checked when a file comes due.
+        FilterRules names;
+        names.include = opt_.filter.include;
+        names.exclude = opt_.filter.exclude;
+        FilterRules preds = opt_.filter;
+        preds.include.clear();
+        preds.exclude.clear();
+        if (!names_.compile(names, err) || !preds_.compile(preds, err)) return false;
+        filtered_ = names_.has_patterns();
+        return add_tree(root_, names_.root_state());
+    }
+
+    std::size_t watched() const { return dirs_.size(); }
+    std::size_t pending() const { return pending_.size(); }
+    std::size_t in_flight() const { return in_flight_.load(); }
+    std::uint64_t wiped() const { return wiped_.load(); }
+    std::uint64_t failed() const { return failed_.load(); }
+
+    // Drain the inotify queue.
+    void read_events() {
+        alignas(inotify_event) char buf[64 * 1024];
+        for (;;) {
+            const ssize_t n = ::read(ifd_, buf, sizeof(buf));
+            if (n <= 0) break;
+            for (ssize_t off = 0; off < n;) {
+                const inotify_event* ev = reinterpret_cast<const inotify_event*>(buf + off);
+                off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+                handle(*ev);
+            }
+        }
+        if (rescan_) {
+            // Events were lost: rebuild watches and re-derive due times from mtimes.
+            rescan_ = false;
+            std::cerr << "[WATCH] event queue overflow; rescanning " << root_ << "\n";
+            add_tree(root_, names_.root_state());
+        }
+    }
+
+    void tick() {
+        wheel_.advance(now_sec(), [this](const std::string& path, std::uint64_t gen) { fire(path, gen); });
+    }
+
+private:
+    struct Dir {
+        std::string path;
+        FilterState state;
+    };
+    struct Pending {
+        std::uint64_t gen;
+        std::int64_t due;
+    };
+
+    void schedule(const std::string& path, std::int64_t due) {
+        Pending& p = pending_[path];
+        p.gen = ++next_gen_;
+        p.due = due;
+        wheel_.add(path, p.gen, due);
+    }
+
+    // Watch `dir` and everything below it; schedule the files already there
+    // by their mtime (they may have been written before the watch existed).
+    bool add_tree(const std::string& dir, const FilterState& st) {
+        const std::uint32_t mask = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE |
+                                   IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+        bool ok = true;
+        WalkCallbacks cb;
+        cb.on_dir = [&](const std::string& d, const EntryInfo&, std::uint32_t) {
+            FilterState ds = st;
+            if (d != dir) {
+                auto parent = wd_of_.find(fs::path(d).parent_path().string());
+                if (parent == wd_of_.end()) return;
+                names_.step(dirs_[parent->second].state, fs::path(d).filename().string(), true, ds);
+            }
+            const int wd = ::inotify_add_watch(ifd_, d.c_str(), mask);
+            if (wd < 0) {
+                if (errno == ENOSPC) {
+                    std::cerr << "[WATCH] inotify watch limit reached at " << d
+                              << " (raise fs.inotify.max_user_watches)\n";
+                    ok = false;
+                }
+                return;
+            }
+            dirs_[wd] = Dir{d, ds};
+            wd_of_[d] = wd;
+        };
+        cb.on_file = [&](const std::string& f, const EntryInfo& info, std::int32_t, std::uint32_t) {
+            schedule(f, info.mtime + wo_.ttl);
+        };
+        walk_tree(dir, filtered_ ? &names_ : nullptr, cb);
+        return ok;
+    }
+
+    // A directory moved out of the tree: forget its watches and files.
+    void drop_tree(const std::string& dir) {
+        const std::string prefix = dir + "/";
+        for (auto it = wd_of_.begin(); it != wd_of_.end();) {
+            if (it->first == dir || it->first.compare(0, prefix.size(), prefix) == 0) {
+                ::inotify_rm_watch(ifd_, it->second);
+                dirs_.erase(it->second);
+                it = wd_of_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) it = pending_.erase(it);
+            else ++it;
+        }
+    }
+
+    void handle(const inotify_event& ev) {
+        if (ev.mask & IN_Q_OVERFLOW) {
+            rescan_ = true;
+            return;
+        }
+        auto it = dirs_.find(ev.wd);
+        if (it == dirs_.end()) return;
+        if (ev.mask & IN_IGNORED) {
+            wd_of_.erase(it->second.path);
+            dirs_.erase(it);
+            return;
+        }
+        if (ev.len == 0) return;
+
+        const std::string name(ev.name);
+        const std::string full = it->second.path + "/" + name;
+        const bool is_dir = (ev.mask & IN_ISDIR) != 0;
+        FilterState st;
+        if (filtered_) names_.step(it->second.state, name, is_dir, st);
+
+        if (is_dir) {
+            if (ev.mask & (IN_CREATE | IN_MOVED_TO)) {
+                if (!filtered_ || !names_.prune_dir(st)) add_tree(full, st);
+            } else if (ev.mask & IN_MOVED_FROM) {
+                drop_tree(full);
+            }
+            return;
+        }
+        if (ev.mask & (IN_DELETE | IN_MOVED_FROM)) {
+            pending_.erase(full);
+            return;
+        }
+        if (filtered_ && !names_.name_selected(st)) return;
+        // A file just created is still being written; with ttl 0 wait for its close.
+        if ((ev.mask & IN_CREATE) && wo_.ttl == 0) return;
+        schedule(full, now_sec() + wo_.ttl);
+    }
+
+    void fire(const std::string& path, std::uint64_t gen) {
+        auto it = pending_.find(path);
+        if (it == pending_.end() || it->second.gen != gen) return;     // rescheduled or gone
+        pending_.erase(it);
+
+        EntryInfo info;
+        if (!stat_entry(path, info) || info.kind != EntryInfo::Regular) return;
+        const std::int64_t now = now_sec();
+        if (info.mtime + wo_.ttl > now) {
+            schedule(path, info.mtime + wo_.ttl);     // written since (event missed or coalesced)
+            return;
+        }
+        if (!preds_.accept_file(FilterState(), info, now)) return;
+
+        if (wo_.dry_run) {
+            OutputSink::out().record(OutputSink::WouldWipe, path);
+            OutputSink::flush_all();
+            return;
+        }
+        ++in_flight_;
+        SubmitOptions so;
+        so.on_complete = [this, path](const WipeResult& r) {
+            if (r.ok) {
+                ++wiped_;
+                OutputSink::out().record(OutputSink::Wiped, path);
+            } else {
+                ++failed_;
+                OutputSink::err().record(OutputSink::Fail, path, r.message);
+            }
+            // A watch runs for days at a few files a second: no batching.
+            OutputSink::flush_all();
+            --in_flight_;
+        };
+        session_.submit(path, opt_, so);
+    }
+
+    int ifd_;
+    std::string root_;
+    WipeOptions opt_;
+    WatchOptions wo_;
+    WipeSession& session_;
+    PathFilter names_;
+    PathFilter preds_;
+    bool filtered_ = false;
+    bool rescan_ = false;
+
+    std::unordered_map<int, Dir> dirs_;             // watch descriptor -> directory
+    std::unordered_map<std::string, int> wd_of_;
+    std::unordered_map<std::string, Pending> pending_;
+    TimerWheel wheel_;
+    std::uint64_t next_gen_ = 0;
+
+    std::atomic<std::size_t> in_flight_{0};
+    std::atomic<std::uint64_t> wiped_{0};
+    std::atomic<std::uint64_t> failed_{0};
+};
+
+} // namespace
+
+int run_watch(const std::string& dir, const WipeOptions& opt, const WatchOptions& wo) {
+    WipeResult r = detail::check_directory_target(dir, wo.dry_run, true, opt.protect);
+    if (!r.ok) {
+        std::cerr << "Watch failed: " << r.message << "\n";
+        return 1;
+    }
+    if (wo.ttl < 0) {
+        std::cerr << "Watch failed: ttl must be >= 0\n";
+        return 2;
+    }
+
+    const int ifd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    int wake[2];
+    if (ifd < 0 || ::pipe2(wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+        std::cerr << "Error: inotify: " << std::strerror(errno) << "\n";
+        if (ifd >= 0) ::close(ifd);
+        return 1;
+    }
+
+    g_stop = 0;
+    g_wake_fd = wake[1];
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    int rc = 0;
+    {
+        SessionOptions so;
+        so.threads = wo.threads;
+        WipeSession session(so);
+        Watcher w(ifd, fs::path(dir).lexically_normal().string(), opt, wo, session);
+        std::string err;
+        if (!w.init(err)) {
+            std::cerr << "Watch failed: " << (err.empty() ? "could not watch the whole tree" : err) << "\n";
+            rc = 1;
+        } else {
+            // Status lines keep stdout clean for --output nul / jsonl.
+            std::ostream& status = OutputSink::format() == OutputFormat::Text ? std::cout : std::cerr;
+            status << "[WATCH] " << dir << ": " << w.watched() << " directories, " << w.pending()
+                   << " files pending, ttl=" << wo.ttl << "s" << (wo.dry_run ? " (dry-run)" : "") << std::endl;
+
+            while (!g_stop) {
+                pollfd fds[2] = {{ifd, POLLIN, 0}, {wake[0], POLLIN, 0}};
+                if (::poll(fds, 2, 1000) < 0 && errno != EINTR) {
+                    std::cerr << "Error: poll: " << std::strerror(errno) << "\n";
+                    rc = 1;
+                    break;
+                }
+                if (fds[0].revents & POLLIN) w.read_events();
+                w.tick();
+            }
+            // Let wipes already handed to the session finish.
+            while (w.in_flight() > 0) ::usleep(10000);
+            OutputSink::flush_all();
+            status << "watch stopped. wiped=" << w.wiped() << ", failed=" << w.failed()
+                   << ", still pending=" << w.pending() << std::endl;
+        }
+    }
+
+    g_wake_fd = -1;
+    ::close(wake[0]);
+    ::close(wake[1]);
+    ::close(ifd);
+    return rc;
+}
+
+#else
+
+int run_watch(const std::string&, const WipeOptions&, const WatchOptions&) {
+    std::cerr << "Watch failed: watch is not supported on this platform (needs inotify)\n";
+    return 1;
+}
+
+#endif
+
+} // namespace securewipe
@@ -0,0 +1,28 @@
+#pragma once
+// `securewipe watch`: wipe files a fixed time after they were last written.
+//
+// The tree is watched with recursive inotify (directories created later are
+// added as they appear). Every selected file sits in a one-second timer wheel
+// keyed by its last close-after-write; when its TTL expires it is re-checked
+// with lstat (regular file, not rewritten since) and handed to a WipeSession.
+// Work is proportional to the changes, not to the size of the tree; the tree
+// is walked only at startup and after an event-queue overflow.
+//
+// Uses the wipe-dir safety checks (dangerous directories, no symlinks) and
+// the wipe-dir filter rules.
+#include "secure_wipe.h"
+#include <cstdint>
+#include <string>
+
+namespace securewipe {
+
+struct WatchOptions {
+    std::int64_t ttl = 600;     // seconds after the last write (0 = on close)
+    unsigned threads = 0;       // session workers (0 = hardware concurrency)
+    bool dry_run = false;       // log instead of wiping
+};
+
+// Watch until SIGINT/SIGTERM. Returns a process exit code.
+int run_watch(const std::string& dir, const WipeOptions& opt, const WatchOptions& wo);
+
+} // namespace securewipe
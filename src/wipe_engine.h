@@ -0,0 +1,92 @@
+#pragma once
+// Internal engine shared by the free functions and WipeSession. Not installed.
+#include "secure_wipe.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace securewipe {
+
+class AuditLedger;
+class JobJournal;
+class ProtectedPaths;
+
+namespace detail {
+
+// Per-thread scratch state reused across files: the overwrite buffer and a
+// PRNG that is seeded once instead of once per file.
+struct WipeContext {
+    std::vector<unsigned char> buf;
+    std::mt19937_64 rng;
+    WipeContext();
+};
+
+// Fill `n` bytes of `buf` with one pass worth of `pattern`.
+void fill_pattern(WipeContext& ctx, Pattern pattern, unsigned char* buf, std::size_t n);
+
+// How to drive I/O on one filesystem. Looked up by device id.
+struct FsStrategy {
+    std::size_t io_block = 0;   // preferred I/O size (0 = unknown)
+    std::string fs_type;        // from the mount table; empty if unknown
+    bool network = false;
+    bool copy_on_write = false; // overwrites do not reach the blocks of earlier versions
+};
+
+class FsStrategyCache {
+public:
+    FsStrategy lookup(std::uint64_t dev, const std::string& path);
+
+private:
+    std::mutex mu_;
+    std::unordered_map<std::uint64_t, FsStrategy> map_;
+};
+
+// Cancellation and deadline of the job a file belongs to. Polled between blocks.
+struct StopCheck {
+    StopToken token;
+    StopToken external;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    // Why the job must stop, or nullptr to keep going.
+    const char* reason() const;
+};
+
+// Optional session services for one overwrite; every member may be null.
+struct WipeEnv {
+    FsStrategyCache* cache = nullptr;
+    std::uint64_t* bytes = nullptr;     // incremented by the bytes written
+    const StopCheck* stop = nullptr;
+    JobJournal* journal = nullptr;      // resume point and checkpoints of large files
+    AuditLedger* ledger = nullptr;      // gets a record of each file
+    const ProtectedPaths* protect = nullptr;    // checked for targets not below beneath_fd
+    int beneath_fd = -1;                // directory job root; its files are opened beneath it
+    std::size_t beneath_prefix = 0;     // length of the root prefix of those paths
+};
+
+// Bytes of a file to overwrite; by default all of it, then the file is deleted.
+struct WipeSpan {
+    std::uint64_t offset = 0;
+    std::uint64_t length = UINT64_MAX;  // clamped to the end of the file
+    bool keep_file = false;
+};
+
+// Overwrite `span` of `path` opt.passes times, then delete the file unless
+// span.keep_file. The file is never extended.
+WipeResult overwrite_file(const std::string& path, const WipeOptions& opt, WipeContext& ctx,
+                          const WipeEnv& env = WipeEnv(), const WipeSpan& span = WipeSpan());
+
+// wipe-dir preconditions: target exists, is not dangerous or protected (the
+// built-in set plus `protect`), and --dry-run/--yes was given.
+WipeResult check_directory_target(const std::string& dir, bool dry_run, bool yes,
+                                  const std::vector<std::string>& protect = {});
+
+// Best-effort bottom-up removal of empty directories below `dir`.
+void remove_empty_dirs(const std::string& dir);
+
+} // namespace detail
+} // namespace securewipe
@@ -0,0 +1,246 @@
+#include "wipe_plan.h"
+#include "secure_wipe.h"
+#include "mount_table.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/sysmacros.h>
+#endif
+
+namespace securewipe {
+
+namespace {
+
+std::string human_bytes(double b) {
+    static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB"};
+    int u = 0;
+    while (b >= 1024 && u < 6) {
+        b /= 1024;
+        ++u;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof buf, u == 0 ? "%.0f %s" : "%.1f %s", b, units[u]);
+    return buf;
+}
+
+// "~1h 2m 3s", or "<1s".
+std::string estimate(double s) {
+    if (s < 1) return "<1s";
+    const auto t = static_cast<std::uint64_t>(s + 0.5);
+    std::string out;
+    if (t >= 86400) out += std::to_string(t / 86400) + "d ";
+    if (t >= 3600) out += std::to_string(t / 3600 % 24) + "h ";
+    if (t >= 60) out += std::to_string(t / 60 % 60) + "m ";
+    return "~" + out + std::to_string(t % 60) + "s";
+}
+
+std::string dev_name(std::uint64_t dev) {
+#if defined(__linux__)
+    return std::to_string(major(static_cast<dev_t>(dev))) + ":" + std::to_string(minor(static_cast<dev_t>(dev)));
+#else
+    return std::to_string(dev);
+#endif
+}
+
+// "1" / "0" from the block queue of the device (or of its parent disk, for a
+// partition); -1 if unknown.
+int rotational(std::uint64_t dev) {
+#if defined(__linux__)
+    const std::string base = "/sys/dev/block/" + dev_name(dev);
+    for (const char* q : {"/queue/rotational", "/../queue/rotational"}) {
+        std::ifstream in(base + q);
+        int v = -1;
+        if (in >> v) return v;
+    }
+#else
+    (void)dev;
+#endif
+    return -1;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// The barrier the engine uses after each pass.
+bool sync_fd(int fd) {
+#if defined(__linux__)
+    return ::fdatasync(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+}
+#endif
+
+} // namespace
+
+WipePlan::Device& WipePlan::device(std::uint64_t dev) {
+    for (auto& d : devices_) {
+        if (d.dev == dev) return d;
+    }
+    devices_.emplace_back();
+    Device& d = devices_.back();
+    d.dev = dev;
+    if (const MountEntry* m = MountTable::system().by_dev(dev)) {
+        d.fs_type = m->fs_type;
+        d.mount_point = m->mount_point;
+    }
+    default_cost(d);
+    return d;
+}
+
+void WipePlan::default_cost(Device& d) {
+    const MountEntry* m = MountTable::system().by_dev(d.dev);
+    if (d.fs_type == "tmpfs" || d.fs_type == "ramfs") {
+        d.bytes_per_sec = 2e9;
+        d.sync_sec = 1e-5;
+        d.cost_source = "memory default";
+    } else if (m && m->network) {
+        d.bytes_per_sec = 100e6;
+        d.sync_sec = 2e-3;
+        d.cost_source = "network default";
+    } else if (rotational(d.dev) == 1) {
+        d.bytes_per_sec = 150e6;
+        d.sync_sec = 8e-3;
+        d.serial = true;
+        d.cost_source = "rotational default";
+    } else if (rotational(d.dev) == 0) {
+        d.bytes_per_sec = 500e6;
+        d.sync_sec = 5e-4;
+        d.cost_source = "ssd default";
+    } else {
+        d.bytes_per_sec = 300e6;
+        d.sync_sec = 2e-3;
+        d.cost_source = "default";
+    }
+}
+
+void WipePlan::add_dir(const std::string& dir, const EntryInfo& info) {
+    Device& d = device(info.dev);
+    if (d.probe_dir.empty()) d.probe_dir = dir;
+}
+
+void WipePlan::add_file(const EntryInfo& info) {
+    Device& d = device(info.dev);
+    ++d.files;
+    d.bytes += info.size;
+    d.allocated += info.allocated;
+    ++files_;
+    bytes_ += info.size;
+    allocated_ += info.allocated;
+    hist_.add(info.size);
+}
+
+void WipePlan::add_link(const EntryInfo& info) {
+    ++device(info.dev).links;
+    ++links_;
+    link_bytes_ += info.size;
+}
+
+void WipePlan::calibrate(std::size_t block_size) {
+    calibrated_ = true;
+#if defined(__unix__) || defined(__APPLE__)
+    using clock = std::chrono::steady_clock;
+    const std::size_t block = std::max<std::size_t>(block_size, 1 << 20);
+    std::unique_ptr<unsigned char[]> buf(new unsigned char[block]);
+    // Random data, so that compressing filesystems do not flatter the probe.
+    std::mt19937_64 rng(std::random_device{}());
+    for (std::size_t i = 0; i + 8 <= block; i += 8) {
+        const std::uint64_t v = rng();
+        std::memcpy(buf.get() + i, &v, 8);
+    }
+
+    for (auto& d : devices_) {
+        if (d.files == 0 || d.probe_dir.empty()) continue;
+        const std::string probe = d.probe_dir + "/.securewipe-probe-" + std::to_string(::getpid());
+        const int fd = ::open(probe.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            d.cost_source += " (probe failed: " + std::string(std::strerror(errno)) + ")";
+            continue;
+        }
+        // Bandwidth: up to 64 MiB written and synced, in wipe-sized blocks.
+        const std::uint64_t size = std::min<std::uint64_t>(std::max<std::uint64_t>(d.bytes, 4 << 20), 64 << 20);
+        bool ok = true;
+        const auto t0 = clock::now();
+        for (std::uint64_t off = 0; ok && off < size; off += block) {
+            const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(block, size - off));
+            ok = ::pwrite(fd, buf.get(), n, static_cast<off_t>(off)) == static_cast<ssize_t>(n);
+        }
+        ok = ok && sync_fd(fd);
+        const double stream = std::chrono::duration<double>(clock::now() - t0).count();
+        // Latency: small rewrites, each made durable.
+        const int rounds = 8;
+        const auto t1 = clock::now();
+        for (int i = 0; ok && i < rounds; ++i) {
+            ok = ::pwrite(fd, buf.get(), 4096, 0) == 4096 && sync_fd(fd);
+        }
+        const double sync = std::chrono::duration<double>(clock::now() - t1).count() / rounds;
+        ::close(fd);
+        ::unlink(probe.c_str());
+        if (!ok || stream <= 0) {
+            d.cost_source += " (probe failed)";
+            continue;
+        }
+        d.bytes_per_sec = static_cast<double>(size) / stream;
+        d.sync_sec = sync;
+        d.cost_source = "calibrated";
+    }
+#else
+    (void)block_size;
+#endif
+}
+
+std::string WipePlan::report(const WipeOptions& opt, unsigned jobs) const {
+    const int passes = std::max(opt.passes, 1);
+    jobs = std::max(jobs, 1u);
+    std::string out = "Plan:\n";
+    out += "  files: " + std::to_string(files_) + ", " + human_bytes(static_cast<double>(bytes_)) +
+           " logical, " + human_bytes(static_cast<double>(allocated_)) + " allocated\n";
+    if (links_ > 0) {
+        out += "  hard links: " + std::to_string(links_) + " further names, only unlinked (" +
+               human_bytes(static_cast<double>(link_bytes_) * passes) + " not rewritten)\n";
+    }
+    out += "  to write: " + human_bytes(static_cast<double>(bytes_) * passes) + " (" + std::to_string(passes) +
+           (passes == 1 ? " pass" : " passes") + ", each synced" +
+           (opt.journal.path.empty() ? "" : ", journal checkpoints") + ")\n";
+    if (files_ > 0) out += "  file sizes:\n" + hist_.format("    ");
+
+    double wall = 0;
+    std::string devs;
+    for (const auto& d : devices_) {
+        if (d.files == 0 && d.links == 0) continue;
+        const double written = static_cast<double>(d.bytes) * passes;
+        double syncs = static_cast<double>(d.files) * passes;
+        if (!opt.journal.path.empty() && opt.journal.checkpoint_bytes > 0) {
+            syncs += written / static_cast<double>(opt.journal.checkpoint_bytes);
+        }
+        const double overlap = d.serial ? 1.0 : static_cast<double>(std::min<std::uint64_t>(jobs, std::max<std::uint64_t>(d.files, 1)));
+        const double t = written / d.bytes_per_sec + syncs * d.sync_sec / overlap;
+        wall = std::max(wall, t);
+
+        char cost[96];
+        std::snprintf(cost, sizeof cost, "%.0f MB/s, sync %.2f ms", d.bytes_per_sec / 1e6, d.sync_sec * 1e3);
+        devs += "    " + dev_name(d.dev) + (d.fs_type.empty() ? "" : " " + d.fs_type) +
+                (d.mount_point.empty() ? "" : " on " + d.mount_point) + ": " + std::to_string(d.files) + " files, " +
+                human_bytes(static_cast<double>(d.bytes)) + " (allocated " +
+                human_bytes(static_cast<double>(d.allocated)) + ")";
+        if (d.links > 0) devs += ", " + std::to_string(d.links) + " links";
+        devs += "; " + std::string(cost) + " (" + d.cost_source + "): " + estimate(t) + "\n";
+    }
+    if (!devs.empty()) out += "  devices:\n" + devs;
+    out += "  estimated wall time: " + estimate(wall) + " with " + std::to_string(jobs) +
+           (jobs == 1 ? " job" : " jobs");
+    if (!calibrated_) out += " (defaults; --calibrate to measure)";
+    out += "\n";
+    return out;
+}
+
+} // namespace securewipe
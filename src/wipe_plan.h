@@ -0,0 +1,65 @@
+#pragma once
+// Capacity plan of a directory wipe, gathered during the dry-run walk.
+//
+// Totals, a size histogram and a per-device breakdown of what would be
+// overwritten, and an estimate of the wall time. Each device is costed as
+// streaming bandwidth plus one sync latency per file and pass (every pass is
+// made durable before the next); devices are assumed to work in parallel.
+// The two figures come from a timed probe file on the device with
+// calibrate = true, otherwise from defaults by device class (rotational
+// flag in sysfs, network filesystem, tmpfs).
+#include "size_histogram.h"
+#include "tree_walk.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace securewipe {
+
+struct WipeOptions;
+
+class WipePlan {
+public:
+    // A traversed directory; the first one on each device hosts its probe.
+    void add_dir(const std::string& dir, const EntryInfo& info);
+    // A file that would be overwritten.
+    void add_file(const EntryInfo& info);
+    // A further name of an inode already counted: only unlinked.
+    void add_link(const EntryInfo& info);
+
+    // Time a probe write + sync on each device (creates and removes a
+    // temporary file in the probe directory).
+    void calibrate(std::size_t block_size);
+
+    // Multi-line report, for `jobs` workers.
+    std::string report(const WipeOptions& opt, unsigned jobs) const;
+
+private:
+    struct Device {
+        std::uint64_t dev = 0;
+        std::string probe_dir;
+        std::string fs_type;
+        std::string mount_point;
+        std::uint64_t files = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t allocated = 0;
+        std::uint64_t links = 0;
+        double bytes_per_sec = 0;   // overwrite bandwidth
+        double sync_sec = 0;        // one durable small write
+        bool serial = false;        // one head: syncs do not overlap
+        std::string cost_source;
+    };
+    Device& device(std::uint64_t dev);
+    static void default_cost(Device& d);
+
+    std::vector<Device> devices_;   // first-seen order
+    SizeHistogram hist_;
+    std::uint64_t files_ = 0;
+    std::uint64_t bytes_ = 0;
+    std::uint64_t allocated_ = 0;
+    std::uint64_t links_ = 0;
+    std::uint64_t link_bytes_ = 0;
+    bool calibrated_ = false;
+};
+
+} // namespace securewipe
@@ -0,0 +1,830 @@
+#include "secure_wipe.h"
+#include "audit_ledger.h"
+#include "content_match.h"
+#include "dir_index.h"
+#include "job_journal.h"
+#include "mount_table.h"
+#include "open_files.h"
+#include "output_sink.h"
+#include "path_arena.h"
+#include "protect.h"
+#include "path_filter.h"
+#include "tree_walk.h"
+#include "wipe_plan.h"
+#include "wipe_engine.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace securewipe {
+
+// Last component of a path the walk built.
+static std::string leaf(const std::string& path) {
+    const std::size_t sep = path.find_last_of(static_cast<char>(fs::path::preferred_separator));
+    return sep == std::string::npos ? path : path.substr(sep + 1);
+}
+
+struct WipeSession::Impl {
+    using Task = std::function<void(detail::WipeContext&)>;
+
+    // One submitted file or directory. Directory jobs keep their files in a
+    // PathArena and queue at most one runner per worker; a runner wipes the
+    // next unclaimed file and re-queues itself, so a job of any size holds a
+    // few tasks and ~17 bytes per pending file. Whichever runner finishes the
+    // last file completes the job, so no worker ever blocks waiting for another.
+    struct Job {
+        std::string path;
+        WipeOptions opt;
+        SubmitOptions so;
+        detail::StopCheck stop;
+        std::promise<WipeResult> promise;
+
+        bool dry_run = false;
+        bool yes = true;
+        bool records = false;               // may have written per-path records
+        std::unique_ptr<PathArena> paths;   // selected files; directories traversed, pre-order
+        std::atomic<std::size_t> next{0};   // next file for a runner to claim
+        bool indexed = false;               // walked with a scan index
+        std::uint64_t dirs_reused = 0;      // directories the index spared a readdir
+        std::uint64_t mounts_skipped = 0;   // --one-file-system prunes
+        std::uint64_t protected_skipped = 0;
+        std::uint64_t open_skipped = 0;     // --skip-open-files
+        ContentMatcher matcher;             // --if-contains; files are scanned by the runners
+        std::atomic<std::uint64_t> unmatched{0};
+        int root_fd = -1;                   // files are opened beneath it
+        std::size_t root_prefix = 0;        // length of "<root>/" in walked paths
+        std::unique_ptr<JobJournal> journal;
+        std::shared_ptr<AuditLedger> ledger;
+        std::unique_ptr<WipePlan> plan;     // dry runs: capacity plan of the walk
+        // Further names of multiply-linked files. They are unlinked once the
+        // inode has been overwritten through its first name (file `primary`).
+        struct Link {
+            std::string path;
+            std::size_t primary;
+        };
+        std::vector<Link> links;
+        std::uint64_t link_bytes = 0;       // overwrite the deduplication saved
+        std::vector<unsigned char> outcome; // per file: kPending / kWiped / kFailed / kKept
+
+#if defined(__unix__) || defined(__APPLE__)
+        ~Job() {
+            if (root_fd >= 0) ::close(root_fd);
+        }
+#endif
+        std::atomic<std::size_t> remaining{0};
+        std::atomic<std::uint64_t> wiped{0};
+        std::atomic<std::uint64_t> failed{0};
+        std::atomic<std::uint64_t> skipped{0};
+        std::atomic<std::uint64_t> bytes{0};
+    };
+    using JobPtr = std::shared_ptr<Job>;
+    enum : unsigned char { kPending, kWiped, kFailed, kKept };
+
+    std::vector<std::thread> workers;
+    // Pending tasks by priority (highest first), FIFO within a priority.
+    std::map<int, std::deque<Task>, std::greater<int>> queues;
+    std::mutex mu;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    detail::FsStrategyCache fs_cache;
+
+    std::atomic<std::uint64_t> files_wiped{0};
+    std::atomic<std::uint64_t> files_failed{0};
+    std::atomic<std::uint64_t> files_skipped{0};
+    std::atomic<std::uint64_t> bytes_overwritten{0};
+
+    std::mutex out_mu;  // serializes [WARN] lines from workers
+
+    // Ledgers in use, kept open for the session so that streams of file jobs
+    // share their batches; closed (committed) after the workers stop.
+    std::mutex ledger_mu;
+    std::vector<std::shared_ptr<AuditLedger>> ledgers;
+
+    explicit Impl(unsigned n) {
+        if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+        workers.reserve(n);
+        for (unsigned i = 0; i < n; ++i) workers.emplace_back([this] { worker_loop(); });
+    }
+
+    ~Impl() {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    void post(Task t, int priority = 0) {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            queues[priority].push_back(std::move(t));
+        }
+        cv.notify_one();
+    }
+
+    void worker_loop() {
+        // Each worker owns its buffer and RNG for the lifetime of the session.
+        detail::WipeContext ctx;
+        for (;;) {
+            Task t;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                cv.wait(lk, [this] { return stopping || !queues.empty(); });
+                if (queues.empty()) return;
+                auto q = queues.begin();
+                t = std::move(q->second.front());
+                q->second.pop_front();
+                if (q->second.empty()) queues.erase(q);
+            }
+            t(ctx);
+        }
+    }
+
+    // `env` carries the job's stop check, journal and root; the rest is filled here.
+    WipeResult wipe_one(const std::string& path, const WipeOptions& opt, detail::WipeContext& ctx,
+                        detail::WipeEnv env) {
+        std::uint64_t bytes = 0;
+        env.cache = &fs_cache;
+        env.bytes = &bytes;
+        std::shared_ptr<const ProtectedPaths> protect;
+        if (env.beneath_fd < 0) {
+            protect = ProtectedPaths::get(opt.protect);
+            env.protect = protect.get();
+        }
+        WipeResult res = detail::overwrite_file(path, opt, ctx, env);
+        bytes_overwritten += bytes;
+        if (res.ok) ++files_wiped;
+        else ++files_failed;
+        res.stats.files_wiped = res.ok ? 1 : 0;
+        res.stats.files_failed = res.ok ? 0 : 1;
+        res.stats.bytes_overwritten = bytes;
+        return res;
+    }
+
+    static void finish(Job& job, WipeResult r) {
+        // Per-path records precede the job's result. Plain file jobs write
+        // none: they keep batching across a wipe_stream.
+        if (job.records) OutputSink::flush_all();
+        if (job.so.on_complete) job.so.on_complete(r);
+        job.promise.set_value(std::move(r));
+    }
+
+    WipeTicket start(const JobPtr& job, bool directory) {
+        StopSource src;
+        job->stop.token = src.get_token();
+        job->stop.external = job->so.stop_token;
+        job->stop.deadline = job->so.deadline;
+        WipeTicket ticket(job->promise.get_future().share(), src);
+
+        if (directory) {
+            post([this, job](detail::WipeContext&) { run_directory(job); }, job->so.priority);
+        } else {
+            post([this, job](detail::WipeContext& ctx) {
+                if (const char* why = job->stop.reason()) {
+                    ++files_skipped;
+                    WipeResult r;
+                    r.message = why;
+                    r.stats.files_skipped = 1;
+                    finish(*job, r);
+                    return;
+                }
+                if (job->so.dry_run) {
+                    finish(*job, dry_run_file(job->path, job->opt));
+                    return;
+                }
+                detail::WipeEnv env;
+                env.stop = &job->stop;
+                if (!job->opt.ledger.path.empty()) {
+                    WipeResult r;
+                    job->ledger = open_ledger(job->opt.ledger, r.message);
+                    if (!job->ledger) {
+                        ++files_failed;
+                        r.stats.files_failed = 1;
+                        finish(*job, r);
+                        return;
+                    }
+                    env.ledger = job->ledger.get();
+                }
+                finish(*job, wipe_one(job->path, job->opt, ctx, env));
+            }, job->so.priority);
+        }
+        return ticket;
+    }
+
+    // A file submitted with so.dry_run: the checks a wipe would make first,
+    // and a "would wipe" record instead of the overwrite.
+    static WipeResult dry_run_file(const std::string& path, const WipeOptions& opt) {
+        WipeResult r;
+        std::error_code ec;
+        const fs::file_status st = fs::symlink_status(path, ec);
+        if (!fs::exists(st)) {
+            r.message = "Path does not exist";
+        } else if (fs::is_symlink(st)) {
+            r.message = "Path is a symlink; refusing to follow it";
+        } else if (!fs::is_regular_file(st)) {
+            r.message = "Path is not a regular file (directories not supported in MVP)";
+        } else {
+            const auto protect = ProtectedPaths::get(opt.protect);
+            if (const char* why = protect->check(protect->normalize(path), false)) r.message = why;
+        }
+        if (!r.message.empty()) {
+            r.stats.files_failed = 1;
+            return r;
+        }
+        OutputSink::out().record(OutputSink::WouldWipe, path);
+        r.ok = true;
+        r.message = "Dry run: would wipe " + std::to_string(fs::file_size(path, ec)) + " bytes";
+        return r;
+    }
+
+    std::shared_ptr<AuditLedger> open_ledger(const LedgerOptions& lo, std::string& err) {
+        auto l = AuditLedger::open(lo, err);
+        if (!l) return l;
+        std::lock_guard<std::mutex> lk(ledger_mu);
+        if (std::find(ledgers.begin(), ledgers.end(), l) == ledgers.end()) ledgers.push_back(l);
+        return l;
+    }
+
+    // `records`: flush the output sink before the result (a dry run on its
+    // own); wipe_stream leaves its records batched.
+    WipeTicket submit_file(const std::string& path, const WipeOptions& opt, const SubmitOptions& so,
+                           bool records = false) {
+        auto job = std::make_shared<Job>();
+        job->path = path;
+        job->opt = opt;
+        job->so = so;
+        job->records = records;
+        return start(job, false);
+    }
+
+    WipeTicket submit_directory(const std::string& dir, const WipeOptions& opt, const SubmitOptions& so,
+                                bool dry_run, bool yes) {
+        auto job = std::make_shared<Job>();
+        job->path = dir;
+        job->opt = opt;
+        job->so = so;
+        job->dry_run = dry_run;
+        job->yes = yes;
+        job->records = true;
+        return start(job, true);
+    }
+
+    // Enumeration step of a directory job; queues one task per file.
+    void run_directory(const JobPtr& job) {
+        WipeResult r = detail::check_directory_target(job->path, job->dry_run, job->yes, job->opt.protect);
+        if (!r.ok) {
+            finish(*job, r);
+            return;
+        }
+
+        // The walk and every later open and unlink happen beneath this one
+        // descriptor, so the tree cannot be swapped for another mid-job; the
+        // protected paths are checked against where it really is.
+        std::string root_real;
+#if defined(__unix__) || defined(__APPLE__)
+        job->root_fd = ::open(job->path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (job->root_fd < 0) {
+            r.ok = false;
+            r.message = (errno == ELOOP || errno == ENOTDIR) ? std::string("Path is a symlink; refusing to follow it")
+                                       : "Cannot open directory: " + std::string(std::strerror(errno));
+            finish(*job, r);
+            return;
+        }
+        job->root_prefix = (fs::path(job->path) / "").string().size();
+        if (fd_path(job->root_fd, root_real)) {
+            const auto paths = ProtectedPaths::get(job->opt.protect);
+            if (const char* why = paths->check(paths->normalize(root_real), true)) {
+                r.ok = false;
+                r.message = why;
+                finish(*job, r);
+                return;
+            }
+        }
+#endif
+
+        PathFilter filter;
+        std::string err;
+        if (!filter.compile(job->opt.filter, err)) {
+            r.ok = false;
+            r.message = err;
+            finish(*job, r);
+            return;
+        }
+        const bool filtered = !job->opt.filter.empty();
+        if (!job->matcher.compile(job->opt.if_contains, err)) {
+            r.ok = false;
+            r.message = err;
+            finish(*job, r);
+            return;
+        }
+
+        if (!job->opt.journal.path.empty() && !job->dry_run) {
+            job->journal.reset(new JobJournal);
+            if (!job->journal->open(job->opt.journal, journal_fingerprint(job->path, job->opt), err)) {
+                r.ok = false;
+                r.message = err;
+                finish(*job, r);
+                return;
+            }
+        }
+        if (!job->opt.ledger.path.empty() && !job->dry_run) {
+            job->ledger = open_ledger(job->opt.ledger, r.message);
+            if (!job->ledger) {
+                r.ok = false;
+                finish(*job, r);
+                return;
+            }
+        }
+
+        job->paths.reset(new PathArena(job->path));
+        PathArena& paths = *job->paths;
+        InodeMap inodes;
+        WalkCallbacks cb;
+        std::vector<std::uint64_t> devs;
+        if (job->dry_run) job->plan.reset(new WipePlan);
+        cb.on_dir = [&](const std::string& d, const EntryInfo& info, std::uint32_t parent) {
+            if (parent != kNoDir) paths.add_dir(parent, leaf(d));
+            if (job->plan) job->plan->add_dir(d, info);
+            if (std::find(devs.begin(), devs.end(), info.dev) != devs.end()) return;
+            devs.push_back(info.dev);
+            const detail::FsStrategy fs_info = fs_cache.lookup(info.dev, d);
+            if (fs_info.copy_on_write) {
+                std::lock_guard<std::mutex> lk(out_mu);
+                std::cerr << "[WARN] " << d << " is on " << fs_info.fs_type
+                          << " (copy-on-write): overwrites do not reach earlier copies or snapshots\n";
+            }
+        };
+
+        std::error_code ec;
+        const fs::path root_abs =
+            root_real.empty() ? fs::weakly_canonical(fs::absolute(job->path, ec), ec) : fs::path(root_real);
+        auto abs_of = [&](const std::string& p) {
+            return (root_abs / fs::path(p).lexically_relative(job->path)).string();
+        };
+
+        // Protected subtrees inside the tree are pruned (lexical, O(depth);
+        // the files are later opened beneath the root without symlinks).
+        const auto protect = ProtectedPaths::get(job->opt.protect);
+        const bool check_protect = !ec && protect->has_below(protect->normalize(root_abs.string()));
+        auto is_protected = [&](const std::string& p) {
+            if (!check_protect || !protect->check(protect->normalize(abs_of(p)), false)) return false;
+            ++job->protected_skipped;
+            OutputSink::out().record(OutputSink::Skip, p, "protected");
+            return true;
+        };
+
+        // With --one-file-system, directories on another device, and mount
+        // points of the same device (bind mounts), are pruned unread.
+        const MountTable& mounts = MountTable::system();
+        EntryInfo root_info;
+#if defined(__unix__) || defined(__APPLE__)
+        stat_entry_at(job->root_fd, std::string(), root_info);
+#else
+        stat_entry(job->path, root_info);
+#endif
+        const bool check_points = job->opt.one_file_system && !ec && mounts.has_mounts_below(root_abs.string());
+        cb.enter_dir = [&](const std::string& d, const EntryInfo& info) {
+            if (is_protected(d)) return false;
+            if (!job->opt.one_file_system) return true;
+            const MountEntry* m = nullptr;
+            if (info.dev == root_info.dev) {
+                if (check_points) m = mounts.at_path(abs_of(d));
+                if (!m) return true;
+            } else {
+                m = mounts.by_dev(info.dev);
+            }
+            ++job->mounts_skipped;
+            OutputSink::out().record(OutputSink::Skip, d, m ? "mount point (" + m->fs_type + ")" : "mount point");
+            return false;
+        };
+        // With --skip-open-files, /proc is scanned once before the walk and
+        // files open (or mapped) in another process are left in place.
+        OpenFileIndex open_files;
+        if (job->opt.skip_open_files && !open_files.scan()) {
+            std::lock_guard<std::mutex> lk(out_mu);
+            std::cerr << "[WARN] --skip-open-files: cannot list open files on this system\n";
+        }
+        std::vector<unsigned char> scan_buf;
+        cb.on_file = [&](const std::string& f, const EntryInfo& info, std::int32_t, std::uint32_t dir) {
+            if (is_protected(f)) return;
+            if (open_files.files() > 0 && open_files.contains(info.dev, info.ino)) {
+                ++job->open_skipped;
+                OutputSink::out().record(OutputSink::Skip, f, "open by a process");
+                return;
+            }
+            // A dry run previews --if-contains here; real runs scan on the workers.
+            if (job->dry_run && !job->matcher.empty() && job->matcher.scan_file(f, scan_buf) == 0) {
+                ++job->unmatched;
+                return;
+            }
+            if (info.nlink > 1) {
+                const std::uint64_t first = inodes.insert(info.dev, info.ino, paths.file_count());
+                if (first != paths.file_count()) {
+                    if (job->dry_run) {
+                        OutputSink::out().record(OutputSink::WouldUnlink, f,
+                                                 paths.file_path(static_cast<std::uint32_t>(first)));
+                        job->plan->add_link(info);
+                    }
+                    job->links.push_back({f, static_cast<std::size_t>(first)});
+                    job->link_bytes += info.size * static_cast<std::uint64_t>(std::max(job->opt.passes, 0));
+                    return;
+                }
+            }
+            if (job->dry_run) {
+                OutputSink::out().record(OutputSink::WouldWipe, f);
+                job->plan->add_file(info);
+            }
+            if (job->so.on_file) job->so.on_file(f, info.size);
+            paths.add_file(dir, leaf(f));
+        };
+        cb.should_stop = [&] { return job->stop.reason() != nullptr; };
+
+        // Incremental mode: reuse the previous run's index unless the full-scan
+        // valve is due.
+        const ScanIndexOptions& ix = job->opt.index;
+        DirIndex prev;
+        std::unique_ptr<DirIndexBuilder> next;
+        WalkIndex walk_index;
+        std::uint64_t fingerprint = 0;
+        bool full_scan = true;
+        if (!ix.path.empty()) {
+            fingerprint = index_fingerprint(job->path, job->opt);
+            full_scan = !prev.load(ix.path, fingerprint) ||
+                        (ix.full_scan_every > 0 && prev.runs_since_full() + 1 >= ix.full_scan_every);
+            next.reset(new DirIndexBuilder(static_cast<std::int64_t>(std::time(nullptr)) - 1));
+            walk_index.prev = full_scan ? nullptr : &prev;
+            walk_index.next = next.get();
+        }
+
+        if (!walk_tree(job->path, filtered ? &filter : nullptr, cb, next ? &walk_index : nullptr, job->root_fd)) {
+            r.ok = false;
+            r.message = job->stop.reason();
+            finish(*job, r);
+            return;
+        }
+        if (next) {
+            job->indexed = true;
+            job->dirs_reused = walk_index.dirs_reused;
+            if (!job->dry_run &&
+                !next->write(ix.path, fingerprint, full_scan ? 0 : prev.runs_since_full() + 1, err)) {
+                std::lock_guard<std::mutex> lk(out_mu);
+                std::cerr << "[WARN] " << err << " (next run will walk everything)\n";
+            }
+        }
+
+        if (job->dry_run) {
+            if (job->opt.calibrate) job->plan->calibrate(job->opt.block_size);
+            r.ok = true;
+            r.message = job->plan->report(job->opt, static_cast<unsigned>(workers.size()));
+            r.message += "Dry-run complete. Files to wipe: " + std::to_string(paths.file_count() + job->links.size());
+            if (!job->links.empty()) {
+                r.message += " (" + std::to_string(job->links.size()) + " further hard links, only unlinked)";
+            }
+            if (job->mounts_skipped > 0) r.message += ", mounts skipped: " + std::to_string(job->mounts_skipped);
+            if (job->protected_skipped > 0) {
+                r.message += ", protected skipped: " + std::to_string(job->protected_skipped);
+            }
+            if (job->open_skipped > 0) r.message += ", open skipped: " + std::to_string(job->open_skipped);
+            if (!job->matcher.empty()) r.message += ", no match: " + std::to_string(job->unmatched.load());
+            r.message += ". Re-run with --yes to execute.";
+            finish(*job, r);
+            return;
+        }
+
+        // Execute: wipe files on the worker pool, opened beneath the root
+        const std::size_t n = paths.file_count();
+        if (n == 0) {
+            finish_directory(*job);
+            return;
+        }
+        job->remaining = n;
+        job->outcome.assign(n, kPending);
+        const std::size_t runners = std::min<std::size_t>(n, workers.size());
+        for (std::size_t i = 0; i < runners; ++i) {
+            post([this, job](detail::WipeContext& ctx) { run_file(job, ctx); }, job->so.priority);
+        }
+    }
+
+    // Wipe the next unclaimed file of a directory job, then queue again.
+    void run_file(const JobPtr& job, detail::WipeContext& ctx) {
+        const std::size_t n = job->paths->file_count();
+        const std::size_t i = job->next++;
+        if (i >= n) return;
+
+        if (job->stop.reason()) {
+            // Claim everything still unclaimed at once.
+            const std::size_t last = job->next.exchange(n);
+            const std::size_t claimed = 1 + (last < n ? n - last : 0);
+            job->skipped += claimed;
+            files_skipped += claimed;
+            if ((job->remaining -= claimed) == 0) finish_directory(*job);
+            return;
+        }
+
+        const std::string f = job->paths->file_path(static_cast<std::uint32_t>(i));
+        // --if-contains: files without a match are kept. A file the journal
+        // shows half-overwritten matched in the interrupted run and is finished.
+        if (!job->matcher.empty() &&
+            !(job->journal && job->journal->started(journal_path_hash(f)))) {
+            const int found = job->matcher.scan_file(f, ctx.buf);
+            if (found <= 0) {
+                if (found == 0) {
+                    job->outcome[i] = kKept;
+                    ++job->unmatched;
+                } else {
+                    job->outcome[i] = kFailed;
+                    ++job->failed;
+                    ++files_failed;
+                    OutputSink::err().record(OutputSink::Fail, f, "Cannot read file to match --if-contains");
+                }
+                if (--job->remaining == 0) {
+                    finish_directory(*job);
+                    return;
+                }
+                post([this, job](detail::WipeContext& c) { run_file(job, c); }, job->so.priority);
+                return;
+            }
+        }
+
+        detail::WipeEnv env;
+        env.stop = &job->stop;
+        env.journal = job->journal.get();
+        env.ledger = job->ledger.get();
+        env.beneath_fd = job->root_fd;
+        env.beneath_prefix = job->root_prefix;
+        auto res = wipe_one(f, job->opt, ctx, env);
+        job->bytes += res.stats.bytes_overwritten;
+        job->outcome[i] = res.ok ? kWiped : kFailed;
+        if (res.ok) ++job->wiped;
+        else {
+            ++job->failed;
+            OutputSink::err().record(OutputSink::Fail, f, res.message);
+        }
+        if (--job->remaining == 0) {
+            finish_directory(*job);
+            return;
+        }
+        post([this, job](detail::WipeContext& c) { run_file(job, c); }, job->so.priority);
+    }
+
+    // Unlink a file of a directory job the way its data was opened: beneath
+    // the root, not following a symlink in any component.
+    static bool unlink_beneath(const Job& job, const std::string& path, std::error_code& ec) {
+#if defined(__unix__) || defined(__APPLE__)
+        if (job.root_fd >= 0 && path.size() > job.root_prefix) {
+            const std::string rel = path.substr(job.root_prefix);
+            const std::size_t slash = rel.rfind('/');
+            int dfd = job.root_fd;
+            if (slash != std::string::npos) {
+                const std::string parent = rel.substr(0, slash);
+                dfd = open_no_symlinks(job.root_fd, parent, O_RDONLY | O_DIRECTORY, true);
+                if (dfd < 0 && errno == ENOSYS) {
+                    dfd = ::openat(job.root_fd, parent.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+                }
+                if (dfd < 0) {
+                    ec.assign(errno, std::generic_category());
+                    return false;
+                }
+            }
+            const char* name = rel.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+            const bool ok = ::unlinkat(dfd, name, 0) == 0;
+            if (!ok) ec.assign(errno, std::generic_category());
+            if (dfd != job.root_fd) ::close(dfd);
+            return ok;
+        }
+#endif
+        return fs::remove(path, ec);
+    }
+
+    void finish_directory(Job& job) {
+        // Remaining names of inodes overwritten through another name.
+        for (const auto& l : job.links) {
+            const unsigned char o = job.outcome[l.primary];
+            if (o == kKept) continue;
+            if (o == kPending) {
+                ++job.skipped;
+                ++files_skipped;
+                continue;
+            }
+            std::error_code ec;
+            const bool removed = o == kWiped && unlink_beneath(job, l.path, ec);
+            if (job.ledger && o == kWiped) {
+                LedgerEntry e;
+                e.action = "unlink";
+                e.ok = removed;
+                if (!removed) e.error = "Failed to delete hard link: " + ec.message();
+                e.started_ms = e.finished_ms = unix_ms();
+                job.ledger->record(l.path, std::move(e));
+            }
+            if (removed) {
+                ++job.wiped;
+                ++files_wiped;
+                continue;
+            }
+            ++job.failed;
+            ++files_failed;
+            OutputSink::err().record(
+                OutputSink::Fail, l.path,
+                o == kWiped ? "Failed to delete hard link: " + ec.message()
+                            : "hard link of " + job.paths->file_path(static_cast<std::uint32_t>(l.primary)) +
+                                  ", which was not wiped");
+        }
+
+        // Optional cleanup: remove directories the walk visited that are now
+        // empty, bottom-up. Pruned (excluded) subtrees are left alone.
+        for (std::size_t d = job.paths->dir_count(); d-- > 1;) {
+            const auto id = static_cast<std::uint32_t>(d);
+#if defined(__unix__) || defined(__APPLE__)
+            if (job.root_fd >= 0) {
+                ::unlinkat(job.root_fd, job.paths->dir_relpath(id).c_str(), AT_REMOVEDIR);
+                continue;
+            }
+#endif
+            std::error_code ec;
+            fs::remove(job.paths->dir_path(id), ec); // removes only if empty
+        }
+
+        WipeResult r;
+        r.ok = (job.failed == 0 && job.skipped == 0);
+        r.stats.files_wiped = job.wiped;
+        r.stats.files_failed = job.failed;
+        r.stats.files_skipped = job.skipped;
+        r.stats.bytes_overwritten = job.bytes;
+        r.message = "wipe-dir complete. total=" + std::to_string(job.paths->file_count() + job.links.size()) +
+                    ", wiped=" + std::to_string(job.wiped.load()) +
+                    ", failed=" + std::to_string(job.failed.load());
+        if (!job.links.empty()) {
+            r.message += ", hardlinks=" + std::to_string(job.links.size()) + " (" +
+                         std::to_string(job.link_bytes) + " bytes not rewritten)";
+        }
+        if (job.mounts_skipped > 0) r.message += ", mounts skipped=" + std::to_string(job.mounts_skipped);
+        if (job.protected_skipped > 0) r.message += ", protected skipped=" + std::to_string(job.protected_skipped);
+        if (job.open_skipped > 0) r.message += ", open skipped=" + std::to_string(job.open_skipped);
+        if (!job.matcher.empty()) r.message += ", no match=" + std::to_string(job.unmatched.load());
+        if (job.indexed) {
+            r.message += ", dirs=" + std::to_string(job.paths->dir_count()) +
+                         " (" + std::to_string(job.dirs_reused) + " unchanged, not re-read)";
+        }
+        if (job.skipped > 0) {
+            const char* why = job.stop.reason();
+            r.message += ", skipped=" + std::to_string(job.skipped.load()) +
+                         " (" + (why ? why : "stopped") + ")";
+        }
+        if (job.journal) {
+            if (job.journal->resumed() > 0) {
+                r.message += ", resumed=" + std::to_string(job.journal->resumed()) + " (from journal)";
+            }
+            // Keep the journal of an incomplete job for --resume.
+            job.journal->close(r.ok);
+        }
+        // The result is reported once the job's records are durable.
+        std::string err;
+        if (job.ledger && !job.ledger->commit(err)) {
+            r.ok = false;
+            r.message += ", ledger: " + err;
+        }
+        finish(job, r);
+    }
+};
+
+WipeSession::WipeSession(const SessionOptions& so) : impl_(new Impl(so.threads)) {}
+
+WipeSession::~WipeSession() = default;
+
+WipeResult WipeSession::wipe_file(const std::string& path, const WipeOptions& opt) {
+    return impl_->submit_file(path, opt, SubmitOptions()).get();
+}
+
+std::vector<WipeResult> WipeSession::wipe_batch(const std::vector<std::string>& paths, const WipeOptions& opt) {
+    std::vector<WipeTicket> tickets;
+    tickets.reserve(paths.size());
+    for (const auto& p : paths) tickets.push_back(impl_->submit_file(p, opt, SubmitOptions()));
+
+    std::vector<WipeResult> results;
+    results.reserve(paths.size());
+    for (const auto& t : tickets) results.push_back(t.get());
+    return results;
+}
+
+WipeResult WipeSession::wipe_stream(const std::function<bool(std::string&)>& next, const WipeOptions& opt,
+                                    std::size_t max_in_flight, bool dry_run) {
+    if (max_in_flight == 0) max_in_flight = 256 * impl_->workers.size();
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::size_t in_flight = 0;
+    std::uint64_t total_files = 0;
+    std::atomic<std::uint64_t> wiped_files{0};
+    std::atomic<std::uint64_t> failed_files{0};
+    std::atomic<std::uint64_t> bytes{0};
+
+    SubmitOptions so;
+    so.dry_run = dry_run;
+    std::string path;
+    while (next(path)) {
+        {
+            std::unique_lock<std::mutex> lk(mu);
+            cv.wait(lk, [&] { return in_flight < max_in_flight; });
+            ++in_flight;
+        }
+        ++total_files;
+        so.on_complete = [&, path](const WipeResult& res) {
+            bytes += res.stats.bytes_overwritten;
+            if (res.ok) ++wiped_files;
+            else {
+                ++failed_files;
+                OutputSink::err().record(OutputSink::Fail, path, res.message);
+            }
+            std::lock_guard<std::mutex> lk(mu);
+            --in_flight;
+            cv.notify_all();
+        };
+        impl_->submit_file(path, opt, so);
+    }
+    {
+        std::unique_lock<std::mutex> lk(mu);
+        cv.wait(lk, [&] { return in_flight == 0; });
+    }
+
+    WipeResult r;
+    r.ok = (failed_files == 0);
+    r.stats.files_wiped = wiped_files;
+    r.stats.files_failed = failed_files;
+    r.stats.bytes_overwritten = bytes;
+    if (dry_run) {
+        r.stats.files_wiped = 0;
+        r.message = "Dry-run complete. Files to wipe: " + std::to_string(wiped_files.load());
+        if (failed_files > 0) r.message += ", failed=" + std::to_string(failed_files.load());
+        return r;
+    }
+    r.message = "wipe complete. total=" + std::to_string(total_files) +
+                ", wiped=" + std::to_string(wiped_files.load()) +
+                ", failed=" + std::to_string(failed_files.load());
+    if (!opt.ledger.path.empty() && total_files > 0) {
+        std::string err;
+        const auto ledger = impl_->open_ledger(opt.ledger, err);
+        if (!ledger || !ledger->commit(err)) {
+            r.ok = false;
+            r.message += ", ledger: " + err;
+        }
+    }
+    return r;
+}
+
+WipeResult WipeSession::wipe_directory(const std::string& dir, const WipeOptions& opt, bool dry_run, bool yes) {
+    return impl_->submit_directory(dir, opt, SubmitOptions(), dry_run, yes).get();
+}
+
+WipeTicket WipeSession::submit(const std::string& path, const WipeOptions& opt, const SubmitOptions& so) {
+    std::error_code ec;
+    if (so.recursive && fs::is_directory(fs::symlink_status(path, ec))) {
+        return impl_->submit_directory(path, opt, so, so.dry_run, true);
+    }
+    // Anything else, a directory included, is a file job: the file is opened
+    // without following symlinks and must be regular when it is wiped.
+    return impl_->submit_file(path, opt, so, so.dry_run);
+}
+
+WipeTicket WipeSession::submit_file(const std::string& path, const WipeOptions& opt, const SubmitOptions& so) {
+    return impl_->submit_file(path, opt, so, so.dry_run);
+}
+
+WipeTicket WipeSession::submit_directory(const std::string& dir, const WipeOptions& opt, bool yes,
+                                         const SubmitOptions& so) {
+    return impl_->submit_directory(dir, opt, so, so.dry_run, yes);
+}
+
+WipeStats WipeSession::stats() const {
+    WipeStats s;
+    s.files_wiped = impl_->files_wiped.load();
+    s.files_failed = impl_->files_failed.load();
+    s.files_skipped = impl_->files_skipped.load();
+    s.bytes_overwritten = impl_->bytes_overwritten.load();
+    return s;
+}
+
+unsigned WipeSession::threads() const {
+    return static_cast<unsigned>(impl_->workers.size());
+}
+
+} // namespace securewipe
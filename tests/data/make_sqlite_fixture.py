@@ -0,0 +1,32 @@
+#!/usr/bin/env python3
+"""Regenerates scrub_fixture.db for the sqlite-scrub tests.
+
+Deleted rows carry the marker GONE-<n>, live rows LIVE-<n>. Whole pages
+of deleted rows end on the freelist; the rest leave freeblocks and gaps
+inside live b-tree pages. secure_delete is off, so the deleted bytes stay
+in the file until scrubbed.
+"""
+import os
+import sqlite3
+
+path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "scrub_fixture.db")
+if os.path.exists(path):
+    os.remove(path)
+db = sqlite3.connect(path)
+db.executescript("""
+    PRAGMA page_size = 1024;
+    PRAGMA auto_vacuum = NONE;
+    PRAGMA journal_mode = DELETE;
+    PRAGMA secure_delete = OFF;
+    CREATE TABLE t (id INTEGER PRIMARY KEY, body TEXT);
+""")
+
+def deleted(i):
+    return i <= 100 or (i <= 120 and i % 2 == 1)
+
+rows = [(i, ("GONE-%d " % i if deleted(i) else "LIVE-%d " % i) * 12) for i in range(1, 141)]
+db.executemany("INSERT INTO t VALUES (?, ?)", rows)
+db.commit()
+db.execute("DELETE FROM t WHERE id <= 100 OR (id <= 120 AND id % 2 = 1)")
+db.commit()
+db.close()
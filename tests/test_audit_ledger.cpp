@@ -0,0 +1,84 @@
+#include "test_util.h"
+#include "audit_ledger.h"
+#include <fstream>
+#include <sstream>
+
+using namespace securewipe;
+
+namespace {
+
+std::string read_all(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+void write_all(const std::string& path, const std::string& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << data;
+}
+
+void write_ledger(const std::string& path, int batches) {
+    LedgerOptions lo;
+    lo.path = path;
+    lo.commit_ms = 0;
+    std::string err;
+    auto ledger = AuditLedger::open(lo, err);
+    if (!ledger) throw std::runtime_error("open: " + err);
+    for (int b = 0; b < batches; ++b) {
+        for (int i = 0; i < 3; ++i) {
+            LedgerEntry e;
+            e.size = 1000 + static_cast<std::uint64_t>(b * 10 + i);
+            e.length = e.size;
+            e.passes = 1;
+            e.ok = true;
+            e.started_ms = unix_ms();
+            e.finished_ms = e.started_ms;
+            ledger->record("/data/file" + std::to_string(b * 10 + i), std::move(e));
+        }
+        if (!ledger->commit(err)) throw std::runtime_error("commit: " + err);
+    }
+}
+
+} // namespace
+
+SW_TEST(audit_ledger_chain_verifies) {
+    test::TempDir tmp;
+    const std::string path = tmp.file("audit.ledger");
+    write_ledger(path, 3);
+    const WipeResult r = verify_ledger(path);
+    CHECK(r.ok);
+
+    // Reopening appends further batches to the same chain.
+    write_ledger(path, 1);
+    CHECK(verify_ledger(path).ok);
+}
+
+SW_TEST(audit_ledger_detects_tampering) {
+    test::TempDir tmp;
+    const std::string path = tmp.file("audit.ledger");
+    write_ledger(path, 2);
+    const std::string good = read_all(path);
+    CHECK(verify_ledger(path).ok);
+
+    // A changed record.
+    std::string edited = good;
+    const std::size_t at = edited.find("\"size\":1001");
+    CHECK(at != std::string::npos);
+    edited[at + 10] = '9';
+    write_all(path, edited);
+    CHECK(!verify_ledger(path).ok);
+
+    // A dropped record line.
+    std::string dropped = good;
+    const std::size_t line = dropped.find("\"seq\":2");
+    CHECK(line != std::string::npos);
+    const std::size_t begin = dropped.rfind('\n', line) + 1;
+    dropped.erase(begin, dropped.find('\n', line) + 1 - begin);
+    write_all(path, dropped);
+    CHECK(!verify_ledger(path).ok);
+
+    write_all(path, good);
+    CHECK(verify_ledger(path).ok);
+}
@@ -0,0 +1,32 @@
+#include "test_util.h"
+#include "blake2b.h"
+
+using namespace securewipe;
+
+// RFC 7693 Appendix A, plus the reference implementation's empty-input and
+// 256-bit digests.
+SW_TEST(blake2b_rfc7693_vectors) {
+    CHECK_EQ(Blake2b::hex_digest("abc", 64),
+             "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1"
+             "7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923");
+    CHECK_EQ(Blake2b::hex_digest("", 64),
+             "786a02f742015903c6c6fd852552d272912f4740e15847618a86e217f71f5419"
+             "d25e1031afee585313896444934eb04b903a685b1448b755d56f701afe9be2ce");
+    CHECK_EQ(Blake2b::hex_digest("abc", 32), "bddd813c634239723171ef3fee98579b94964e3bb1cb3e427262c8c068d52319");
+}
+
+SW_TEST(blake2b_incremental_matches_one_shot) {
+    std::string data;
+    for (int i = 0; i < 512; ++i) data.push_back(static_cast<char>(i & 0xff));
+    CHECK_EQ(Blake2b::hex_digest(data), "540b20132d8aeae54057cb69c24f95d26a1c472cc700dd450defe9bb796d4f14");
+
+    // Odd split points straddle the 128-byte block boundaries.
+    Blake2b h;
+    h.update(data.data(), 1);
+    h.update(data.data() + 1, 127);
+    h.update(data.data() + 128, 200);
+    h.update(data.data() + 328, data.size() - 328);
+    unsigned char out[32];
+    h.final(out);
+    CHECK_EQ(to_hex(out, sizeof(out)), Blake2b::hex_digest(data));
+}
@@ -0,0 +1,95 @@
+#include "test_util.h"
+#include "secure_wipe_c.h"
+#include <fstream>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void write_file(const fs::path& p, std::size_t size) {
+    fs::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary) << std::string(size, 'x');
+}
+
+} // namespace
+
+SW_TEST(c_api_submit_and_poll) {
+    test::TempDir tmp;
+    CHECK_EQ(sw_abi_version(), static_cast<uint32_t>(SW_ABI_VERSION));
+    sw_options opt;
+    sw_options_init(&opt);
+    CHECK_EQ(opt.passes, 1);
+    CHECK_EQ(opt.flags, 0u);
+
+    sw_session* s = sw_session_create(2);
+    CHECK(s != nullptr);
+    write_file(tmp.path() / "f", 4096);
+    const sw_job_id id = sw_submit(s, tmp.file("f").c_str(), &opt);
+    CHECK(id != 0);
+
+    sw_completion c[4];
+    CHECK_EQ(sw_poll(s, c, 4, -1), 1);
+    CHECK_EQ(c[0].job, id);
+    CHECK_EQ(c[0].ok, 1);
+    CHECK(!fs::exists(tmp.path() / "f"));
+    CHECK_EQ(sw_poll(s, c, 4, 0), 0);
+    CHECK_EQ(sw_cancel(s, id), 0);      // already finished
+
+    sw_stats st;
+    sw_get_stats(s, &st);
+    CHECK_EQ(st.files_wiped, 1u);
+    CHECK_EQ(st.bytes_overwritten, 4096u);
+    CHECK_EQ(st.jobs_pending, 0u);
+
+    // A missing file completes with ok = 0 and a message.
+    CHECK(sw_submit(s, tmp.file("missing").c_str(), nullptr) != 0);
+    CHECK_EQ(sw_poll(s, c, 4, -1), 1);
+    CHECK_EQ(c[0].ok, 0);
+    CHECK(c[0].message[0] != '\0');
+
+    CHECK_EQ(sw_submit(s, nullptr, &opt), 0u);
+    CHECK_EQ(sw_submit(nullptr, tmp.file("f").c_str(), &opt), 0u);
+    sw_session_destroy(s);
+}
+
+SW_TEST(c_api_directory_needs_flag) {
+    test::TempDir tmp;
+    const fs::path tree = tmp.path() / "tree";
+    write_file(tree / "a" / "f", 100);
+    write_file(tree / "g", 100);
+
+    sw_session* s = sw_session_create(1);
+    sw_options opt;
+    sw_options_init(&opt);
+    CHECK_EQ(sw_submit(s, tree.string().c_str(), &opt), 0u);
+
+    sw_completion c;
+    opt.flags = SW_SUBMIT_DIRECTORY | SW_SUBMIT_DRY_RUN;
+    CHECK(sw_submit(s, tree.string().c_str(), &opt) != 0);
+    CHECK_EQ(sw_poll(s, &c, 1, -1), 1);
+    CHECK_EQ(c.ok, 1);
+    CHECK(fs::exists(tree / "a" / "f"));
+
+    opt.flags = SW_SUBMIT_DIRECTORY;
+    CHECK(sw_submit(s, tree.string().c_str(), &opt) != 0);
+    CHECK_EQ(sw_poll(s, &c, 1, -1), 1);
+    CHECK_EQ(c.ok, 1);
+    CHECK(!fs::exists(tree / "a" / "f"));
+    CHECK(!fs::exists(tree / "g"));
+    sw_session_destroy(s);
+}
+
+SW_TEST(c_api_destroy_drains_queued_jobs) {
+    test::TempDir tmp;
+    sw_session* s = sw_session_create(1);
+    sw_options opt;
+    sw_options_init(&opt);
+    for (int i = 0; i < 16; ++i) {
+        write_file(tmp.path() / ("f" + std::to_string(i)), 64 * 1024);
+        CHECK(sw_submit(s, tmp.file("f" + std::to_string(i)).c_str(), &opt) != 0);
+    }
+    sw_session_destroy(s);              // drains the queue before returning
+    for (int i = 0; i < 16; ++i) CHECK(!fs::exists(tmp.path() / ("f" + std::to_string(i))));
+}
@@ -0,0 +1,94 @@
+#include "test_util.h"
+#include "content_match.h"
+#include <fstream>
+#include <random>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+ContentMatcher compiled(const std::vector<std::string>& patterns) {
+    ContentMatcher m;
+    std::string err;
+    CHECK(m.compile(patterns, err));
+    return m;
+}
+
+bool matches(const ContentMatcher& m, const std::string& data) {
+    ContentMatcher::State st;
+    return m.feed(st, reinterpret_cast<const unsigned char*>(data.data()), data.size());
+}
+
+} // namespace
+
+SW_TEST(content_match_patterns_and_escapes) {
+    const ContentMatcher m = compiled({"abcd", "bc\\x00", "\\n--key"});
+    CHECK(!matches(m, "xxabcx"));
+    CHECK(matches(m, "zzabcd"));
+    CHECK(matches(m, std::string("ab\x62\x63\0", 5)));     // "bc\0" inside a partial "abcd"
+    CHECK(matches(m, "line\n--key"));
+    CHECK(!matches(m, "line\\n--key"));
+
+    ContentMatcher bad;
+    std::string err;
+    CHECK(!bad.compile({""}, err));
+    CHECK(!bad.compile({std::string(20000, 'a')}, err));
+    CHECK(!err.empty());
+}
+
+SW_TEST(content_match_carries_state_across_chunks) {
+    const ContentMatcher m = compiled({"PRIVATE KEY"});
+    const std::string data = std::string(1000, '.') + "PRIVATE KEY" + std::string(10, '.');
+    // Every split point, including ones inside the pattern.
+    for (std::size_t cut = 990; cut <= 1012; ++cut) {
+        ContentMatcher::State st;
+        const auto* p = reinterpret_cast<const unsigned char*>(data.data());
+        const bool first = m.feed(st, p, cut);
+        CHECK(first || m.feed(st, p + cut, data.size() - cut));
+    }
+}
+
+SW_TEST(content_match_agrees_with_brute_force) {
+    // Sets with more than 8 distinct first bytes skip the SSE2 prefilter,
+    // so random sets cover both scan paths.
+    std::mt19937 rng(12345);
+    for (int round = 0; round < 200; ++round) {
+        std::vector<std::string> pats;
+        const int npats = 1 + static_cast<int>(rng() % 12);
+        for (int i = 0; i < npats; ++i) {
+            std::string p(1 + rng() % 4, '\0');
+            for (auto& c : p) c = static_cast<char>('a' + rng() % 12);
+            pats.push_back(p);
+        }
+        std::string data(200 + rng() % 300, '\0');
+        for (auto& c : data) c = static_cast<char>('a' + rng() % 26);
+        bool want = false;
+        for (const auto& p : pats) want = want || data.find(p) != std::string::npos;
+        CHECK_EQ(matches(compiled(pats), data), want);
+    }
+}
+
+SW_TEST(content_match_scans_files) {
+    test::TempDir tmp;
+    const ContentMatcher m = compiled({"needle"});
+    // Past several reads, with the match at the very end.
+    const std::string big = std::string(9u << 20, 'h') + "needle";
+    std::ofstream(tmp.file("hit"), std::ios::binary) << big;
+    std::ofstream(tmp.file("miss"), std::ios::binary) << std::string(100000, 'h');
+    fs::create_symlink(tmp.file("hit"), tmp.file("link"));
+
+    std::vector<unsigned char> buf;
+    CHECK_EQ(m.scan_file(tmp.file("hit"), buf), 1);
+    CHECK_EQ(m.scan_file(tmp.file("miss"), buf), 0);
+    CHECK_EQ(m.scan_file(tmp.file("absent"), buf), -1);
+    CHECK_EQ(m.scan_file(tmp.file("link"), buf), -1);     // a final symlink is not followed
+
+    std::ofstream(tmp.file("pats")) << "# secrets\n\nneedle\nBEGIN\\x20RSA\n";
+    std::vector<std::string> pats;
+    std::string err;
+    CHECK(ContentMatcher::load_patterns_file(tmp.file("pats"), pats, err));
+    CHECK_EQ(pats.size(), 2u);
+    CHECK(matches(compiled(pats), "-----BEGIN RSA"));
+}
@@ -0,0 +1,128 @@
+// Built as C++20 (securewipe_coro_tests) so the awaitables are compiled.
+#include "test_util.h"
+#include "secure_wipe.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#if !defined(SECUREWIPE_HAS_COROUTINES)
+#error "securewipe_coro_tests needs a compiler with C++20 coroutines"
+#endif
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Fire-and-forget coroutine; the test waits on state it sets.
+struct Task {
+    struct promise_type {
+        Task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Single-threaded event loop: the ResumeExecutor queues handles, run() resumes them.
+class Loop {
+public:
+    ResumeExecutor executor() {
+        return [this](std::coroutine_handle<> h) {
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                ready_.push_back(h);
+            }
+            cv_.notify_one();
+        };
+    }
+    void run(const bool& done) {
+        while (!done) {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&] { return !ready_.empty(); });
+            const std::coroutine_handle<> h = ready_.front();
+            ready_.pop_front();
+            lk.unlock();
+            h.resume();
+        }
+    }
+
+private:
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::coroutine_handle<>> ready_;
+};
+
+void write_file(const fs::path& p, std::size_t size) {
+    fs::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary) << std::string(size, 'x');
+}
+
+} // namespace
+
+SW_TEST(awaitable_resumes_on_executor) {
+    test::TempDir tmp;
+    write_file(tmp.path() / "a", 1000);
+    write_file(tmp.path() / "b", 2000);
+    WipeSession session;
+    Loop loop;
+    bool done = false;
+    std::vector<std::thread::id> resumed_on;
+    std::vector<WipeResult> results;
+
+    auto job = [&]() -> Task {
+        results.push_back(co_await session.wipe_file_async(tmp.file("a"), WipeOptions(), SubmitOptions(),
+                                                           loop.executor()));
+        resumed_on.push_back(std::this_thread::get_id());
+        results.push_back(co_await session.wipe_file_async(tmp.file("b"), WipeOptions(), SubmitOptions(),
+                                                           loop.executor()));
+        resumed_on.push_back(std::this_thread::get_id());
+        done = true;
+    };
+    job();
+    loop.run(done);
+
+    CHECK_EQ(results.size(), 2u);
+    CHECK(results[0].ok && results[1].ok);
+    CHECK_EQ(results[1].stats.bytes_overwritten, 2000u);
+    for (const auto& id : resumed_on) CHECK(id == std::this_thread::get_id());
+    CHECK(!fs::exists(tmp.path() / "a"));
+}
+
+SW_TEST(awaitable_without_executor_resumes_on_worker) {
+    test::TempDir tmp;
+    write_file(tmp.path() / "f", 100);
+    write_file(tmp.path() / "tree" / "x" / "g", 100);
+    WipeSession session;
+    std::mutex mu;
+    std::condition_variable cv;
+    bool done = false;
+    std::thread::id resumed_on;
+    WipeResult file_r, refused, dir_r;
+
+    auto job = [&]() -> Task {
+        file_r = co_await session.wipe_file_async(tmp.file("f"), WipeOptions());
+        resumed_on = std::this_thread::get_id();
+        // Still on the worker: further co_awaits are fine, blocking calls on
+        // the session are not.
+        refused = co_await session.wipe_directory_async(tmp.file("tree"), WipeOptions(), false);
+        dir_r = co_await session.wipe_directory_async(tmp.file("tree"), WipeOptions(), true);
+        std::lock_guard<std::mutex> lk(mu);
+        done = true;
+        cv.notify_all();
+    };
+    job();
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return done; });
+
+    CHECK(file_r.ok);
+    CHECK(resumed_on != std::this_thread::get_id());
+    CHECK(!refused.ok);                 // no `yes`, no dry run
+    CHECK(dir_r.ok);
+    CHECK(!fs::exists(tmp.path() / "tree" / "x" / "g"));
+}
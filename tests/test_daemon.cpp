@@ -0,0 +1,169 @@
+#include "test_util.h"
+#include "daemon.h"
+#include "line_json.h"
+#include "net_util.h"
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A `securewipe daemon` child on a socket in `dir`, stopped with SIGTERM.
+class DaemonProcess {
+public:
+    DaemonProcess(const test::TempDir& dir, const std::vector<std::string>& extra)
+        : socket_(dir.file("d.sock")) {
+        std::vector<std::string> args{"daemon", "--socket", socket_, "--jobs", "2"};
+        args.insert(args.end(), extra.begin(), extra.end());
+        pid_ = test::spawn_cli(args, dir.file("daemon.log"));
+        for (int i = 0; i < 500 && !fs::exists(socket_); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    ~DaemonProcess() { stop(); }
+
+    int stop() {
+        if (pid_ <= 0) return status_;
+        ::kill(pid_, SIGTERM);
+        ::waitpid(pid_, &status_, 0);
+        pid_ = -1;
+        return status_;
+    }
+    const std::string& socket() const { return socket_; }
+
+private:
+    std::string socket_;
+    pid_t pid_ = -1;
+    int status_ = 0;
+};
+
+class Conn {
+public:
+    explicit Conn(const std::string& socket) {
+        std::string err;
+        fd_ = net::connect_unix(socket, err);
+        CHECK(fd_ >= 0);
+        reader_.reset(new net::LineReader(fd_));
+    }
+    ~Conn() { net::close_fd(fd_); }
+
+    JsonObject request(const std::string& line) {
+        CHECK(net::send_line(fd_, line));
+        return next();
+    }
+    JsonObject next() {
+        std::string line, err;
+        JsonObject ev;
+        CHECK(reader_->read_line(line));
+        CHECK(ev.parse(line, err));
+        return ev;
+    }
+
+private:
+    int fd_ = -1;
+    std::unique_ptr<net::LineReader> reader_;
+};
+
+std::string wipe_req(const std::string& id, const std::string& path, const std::string& kind = "file") {
+    return JsonWriter().add("op", "wipe").add("id", id).add("path", path).add("kind", kind).str();
+}
+
+} // namespace
+
+SW_TEST(daemon_protocol_round_trip) {
+    test::TempDir tmp;
+    DaemonProcess d(tmp, {});
+    Conn c(d.socket());
+
+    CHECK_EQ(c.request(R"({"op":"ping"})").get_string("event"), "pong");
+
+    std::ofstream(tmp.path() / "f") << std::string(2048, 'x');
+    JsonObject ev = c.request(wipe_req("j1", tmp.file("f")));
+    CHECK_EQ(ev.get_string("event"), "accepted");
+    CHECK_EQ(ev.get_string("id"), "j1");
+    ev = c.next();
+    CHECK_EQ(ev.get_string("event"), "done");
+    CHECK_EQ(ev.get_string("id"), "j1");
+    CHECK(ev.get_bool("ok"));
+    CHECK(!fs::exists(tmp.path() / "f"));
+
+    ev = c.request(R"({"op":"stats"})");
+    CHECK_EQ(ev.get_string("event"), "stats");
+    CHECK_EQ(ev.get_uint("files_wiped"), 1u);
+    CHECK_EQ(ev.get_uint("bytes_overwritten"), 2048u);
+
+    // Refusals come back as errors for the job id, before anything runs.
+    fs::create_directories(tmp.path() / "tree" / "sub");
+    std::ofstream(tmp.path() / "tree" / "sub" / "g") << "data";
+    CHECK_EQ(c.request(wipe_req("j2", "relative/path")).get_string("event"), "error");
+    CHECK_EQ(c.request(wipe_req("j3", (tmp.path() / "tree").string())).get_string("event"), "error");
+    ev = c.request(wipe_req("j4", (tmp.path() / "tree").string(), "dir"));   // no "yes"
+    CHECK_EQ(ev.get_string("event"), "error");
+    CHECK_EQ(ev.get_string("id"), "j4");
+    CHECK_EQ(c.request(R"({"op":"cancel","id":"nope"})").get_string("event"), "error");
+    CHECK_EQ(c.request(R"({"op":"bogus"})").get_string("event"), "error");
+    CHECK_EQ(c.request("not json").get_string("event"), "error");
+    CHECK(fs::exists(tmp.path() / "tree" / "sub" / "g"));
+
+    // The client helper used by `wipe-dir --daemon`.
+    const WipeResult r = daemon_request(d.socket(), (tmp.path() / "tree").string(), WipeOptions(), true, false,
+                                        true, 0);
+    CHECK(r.ok);
+    CHECK(!fs::exists(tmp.path() / "tree" / "sub" / "g"));
+
+    const int status = d.stop();
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(!fs::exists(d.socket()));
+}
+
+SW_TEST(daemon_rate_limits_each_connection) {
+    test::TempDir tmp;
+    DaemonProcess d(tmp, {"--rate", "0.01", "--burst", "2"});
+    auto dry = [&](const std::string& id) {
+        return JsonWriter()
+            .add("op", "wipe")
+            .add("id", id)
+            .add("path", tmp.file("absent"))
+            .add("dry_run", true)
+            .str();
+    };
+    // Each connection has its own bucket: two jobs, then "rate limited".
+    for (int conn = 0; conn < 2; ++conn) {
+        Conn c(d.socket());
+        int accepted = 0, limited = 0;
+        for (int i = 0; i < 3; ++i) {
+            JsonObject ev = c.request(dry("r" + std::to_string(i)));
+            while (ev.get_string("event") == "done") ev = c.next();
+            if (ev.get_string("event") == "accepted") ++accepted;
+            else if (ev.get_string("message") == "rate limited") ++limited;
+        }
+        CHECK_EQ(accepted, 2);
+        CHECK_EQ(limited, 1);
+    }
+}
+
+SW_TEST(daemon_uid_rate_caps_all_connections) {
+    test::TempDir tmp;
+    DaemonProcess d(tmp, {"--rate", "100", "--uid-rate", "0.01", "--burst", "2"});
+    int accepted = 0;
+    for (int conn = 0; conn < 3; ++conn) {
+        Conn c(d.socket());
+        JsonObject ev = c.request(JsonWriter()
+                                      .add("op", "wipe")
+                                      .add("id", "u")
+                                      .add("path", tmp.file("absent"))
+                                      .add("dry_run", true)
+                                      .str());
+        if (ev.get_string("event") == "accepted") ++accepted;
+        else CHECK_EQ(ev.get_string("message"), "rate limited");
+    }
+    CHECK_EQ(accepted, 2);              // reconnecting does not refill the uid's bucket
+}
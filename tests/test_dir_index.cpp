@@ -0,0 +1,79 @@
+#include "test_util.h"
+#include "dir_index.h"
+
+using namespace securewipe;
+
+namespace {
+
+EntryInfo dir_info(std::uint64_t ino, std::int64_t mtime) {
+    EntryInfo e;
+    e.kind = EntryInfo::Directory;
+    e.dev = 42;
+    e.ino = ino;
+    e.mtime = mtime;
+    e.ctime = mtime;
+    return e;
+}
+
+} // namespace
+
+SW_TEST(dir_index_round_trip) {
+    test::TempDir tmp;
+    const std::string path = tmp.file("index");
+    const std::uint64_t fp = 0x1234;
+
+    // Walked at t=1000; "new" was modified within a second of that.
+    DirIndexBuilder b(999);
+    const std::uint32_t root = b.add(DirIndex::npos, "", dir_info(1, 500));
+    const std::uint32_t a = b.add(root, "a", dir_info(2, 600));
+    const std::uint32_t c = b.add(root, "c", dir_info(3, 700));
+    b.add(a, "deep", dir_info(4, 800));
+    b.add(root, "new", dir_info(5, 999));
+    b.set_pending(c, 2);
+    std::string err;
+    CHECK(b.write(path, fp, 5, err));
+
+    DirIndex idx;
+    CHECK(idx.load(path, fp));
+    CHECK(!idx.empty());
+    CHECK_EQ(idx.runs_since_full(), 5u);
+    const std::uint32_t r = idx.root();
+    CHECK_EQ(r, 0u);
+    CHECK_EQ(idx.at(r).child_count, 3u);
+
+    const std::uint32_t ia = idx.find_child(r, "a");
+    const std::uint32_t ic = idx.find_child(r, "c");
+    const std::uint32_t in = idx.find_child(r, "new");
+    CHECK(ia != DirIndex::npos && ic != DirIndex::npos && in != DirIndex::npos);
+    CHECK_EQ(idx.find_child(r, "b"), DirIndex::npos);
+    CHECK_EQ(idx.name(ia), "a");
+    CHECK_EQ(idx.at(ic).pending, 2u);
+    CHECK(idx.find_child(ia, "deep") != DirIndex::npos);
+
+    CHECK(idx.unchanged(ia, dir_info(2, 600)));
+    CHECK(!idx.unchanged(ia, dir_info(2, 601)));    // modified since
+    CHECK(!idx.unchanged(ia, dir_info(9, 600)));    // replaced by another directory
+    CHECK(!idx.unchanged(in, dir_info(5, 999)));    // racy: always re-read
+}
+
+SW_TEST(dir_index_rejects_other_fingerprint_and_garbage) {
+    test::TempDir tmp;
+    const std::string path = tmp.file("index");
+    DirIndexBuilder b(0);
+    b.add(DirIndex::npos, "", dir_info(1, 1));
+    std::string err;
+    CHECK(b.write(path, 7, 0, err));
+
+    DirIndex other;
+    CHECK(!other.load(path, 8));
+    CHECK(other.empty());
+
+    DirIndex missing;
+    CHECK(!missing.load(tmp.file("nope"), 7));
+
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    std::fputs("not an index", f);
+    std::fclose(f);
+    DirIndex garbage;
+    CHECK(!garbage.load(path, 7));
+}
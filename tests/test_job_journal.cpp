@@ -0,0 +1,95 @@
+#include "test_util.h"
+#include "job_journal.h"
+
+using namespace securewipe;
+
+namespace {
+
+JournalOptions journal_at(const std::string& path, bool resume) {
+    JournalOptions jo;
+    jo.path = path;
+    jo.resume = resume;
+    jo.sync_ms = 0;
+    jo.checkpoint_bytes = 4096;
+    return jo;
+}
+
+} // namespace
+
+SW_TEST(job_journal_resume) {
+    test::TempDir tmp;
+    const std::string path = tmp.file("job.journal");
+    const std::uint64_t fp = 99;
+    const JournalKey big{journal_path_hash("/data/big"), 11, 1 << 20};
+    const JournalKey gone{journal_path_hash("/data/gone"), 12, 1 << 20};
+    std::string err;
+    {
+        JobJournal j;
+        CHECK(j.open(journal_at(path, false), fp, err));
+        j.progress(big, 1, 8192);
+        j.progress(big, 2, 4096);       // superseded checkpoints keep the last one
+        j.progress(gone, 1, 4096);
+        j.done(gone);
+        j.close(false);                 // killed mid-job: the file stays
+    }
+
+    JobJournal fresh;
+    CHECK(!fresh.open(journal_at(path, false), fp, err));   // never clobber an unfinished job
+
+    JobJournal wrong;
+    CHECK(!wrong.open(journal_at(path, true), fp + 1, err));
+
+    JobJournal j;
+    CHECK(j.open(journal_at(path, true), fp, err));
+    CHECK(j.started(big.path));
+    CHECK(!j.started(gone.path));
+    int pass = 0;
+    std::uint64_t offset = 0;
+    j.resume_point(big, pass, offset);
+    CHECK_EQ(pass, 2);
+    CHECK_EQ(offset, 4096u);
+    CHECK_EQ(j.resumed(), 1u);
+
+    // Same name, different file: start over.
+    const JournalKey replaced{big.path, 13, big.size};
+    j.resume_point(replaced, pass, offset);
+    CHECK_EQ(pass, 1);
+    CHECK_EQ(offset, 0u);
+
+    j.close(true);
+    CHECK(!std::filesystem::exists(path));
+}
+
+SW_TEST(job_journal_ignores_torn_tail) {
+    test::TempDir tmp;
+    const std::string path = tmp.file("job.journal");
+    const JournalKey k{journal_path_hash("/f"), 1, 1 << 20};
+    std::string err;
+    {
+        JobJournal j;
+        CHECK(j.open(journal_at(path, false), 5, err));
+        j.progress(k, 1, 4096);
+        j.close(false);
+    }
+    std::FILE* f = std::fopen(path.c_str(), "ab");
+    std::fputs("torn", f);
+    std::fclose(f);
+
+    JobJournal j;
+    CHECK(j.open(journal_at(path, true), 5, err));
+    int pass = 0;
+    std::uint64_t offset = 0;
+    j.resume_point(k, pass, offset);
+    CHECK_EQ(offset, 4096u);
+    j.close(true);
+}
+
+SW_TEST(job_journal_fingerprint) {
+    WipeOptions a;
+    WipeOptions b;
+    b.passes = 3;
+    CHECK(journal_fingerprint("/x", a) == journal_fingerprint("/x", a));
+    CHECK(journal_fingerprint("/x", a) != journal_fingerprint("/x", b));
+    CHECK(journal_fingerprint("/x", a) != journal_fingerprint("/y", a));
+    CHECK(journal_fingerprint("/x", a, 0, 100) != journal_fingerprint("/x", a));
+}
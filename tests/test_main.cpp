@@ -0,0 +1,75 @@
+#include "test_util.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace securewipe {
+namespace test {
+
+namespace {
+
+struct Failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace
+
+std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void fail(const char* file, int line, const std::string& what) {
+    throw Failure(std::string(file) + ":" + std::to_string(line) + ": CHECK failed: " + what);
+}
+
+TempDir::TempDir() {
+    std::string tmpl = (std::filesystem::temp_directory_path() / "securewipe-test-XXXXXX").string();
+    if (!::mkdtemp(&tmpl[0])) throw std::runtime_error("mkdtemp failed");
+    path_ = tmpl;
+}
+
+TempDir::~TempDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+}
+
+pid_t spawn_cli(const std::vector<std::string>& args, const std::string& out) {
+    const pid_t pid = ::fork();
+    if (pid != 0) return pid;
+    const int fd = ::open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) ::_exit(126);
+    ::dup2(fd, 1);
+    ::dup2(fd, 2);
+    std::vector<char*> argv{const_cast<char*>(SECUREWIPE_CLI)};
+    for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+    ::execv(SECUREWIPE_CLI, argv.data());
+    ::_exit(127);
+}
+
+} // namespace test
+} // namespace securewipe
+
+int main(int argc, char** argv) {
+    using securewipe::test::registry;
+    int failed = 0, ran = 0;
+    for (const auto& c : registry()) {
+        if (argc > 1 && std::strcmp(argv[1], c.name) != 0) continue;
+        ++ran;
+        try {
+            c.fn();
+            std::printf("[PASS] %s\n", c.name);
+        } catch (const std::exception& e) {
+            ++failed;
+            std::printf("[FAIL] %s: %s\n", c.name, e.what());
+        }
+    }
+    if (ran == 0) {
+        std::fprintf(stderr, "No test named %s\n", argc > 1 ? argv[1] : "(any)");
+        return 2;
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#include "test_util.h"
+#include "path_filter.h"
+#include <sstream>
+
+using namespace securewipe;
+
+namespace {
+
+PathFilter compiled(const FilterRules& rules) {
+    PathFilter f;
+    std::string err;
+    if (!f.compile(rules, err)) throw std::runtime_error("compile: " + err);
+    return f;
+}
+
+// Walk `rel` ("a/b/c.txt") the way the traversal does; false if a directory
+// on the way is pruned or the file is not selected by name.
+bool selects(const PathFilter& f, const std::string& rel) {
+    std::vector<std::string> parts;
+    std::stringstream ss(rel);
+    for (std::string p; std::getline(ss, p, '/');) parts.push_back(p);
+    FilterState st = f.root_state();
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        const bool is_dir = i + 1 < parts.size();
+        FilterState next;
+        f.step(st, parts[i], is_dir, next);
+        if (is_dir && f.prune_dir(next)) return false;
+        st = std::move(next);
+    }
+    return f.name_selected(st);
+}
+
+} // namespace
+
+SW_TEST(path_filter_component_glob) {
+    CHECK(ComponentGlob("*.log").match("app.log"));
+    CHECK(!ComponentGlob("*.log").match("app.log.1"));
+    CHECK(ComponentGlob("file?.txt").match("file1.txt"));
+    CHECK(ComponentGlob("[a-c]x").match("bx"));
+    CHECK(!ComponentGlob("[!a-c]x").match("bx"));
+    CHECK(ComponentGlob("\\*").match("*"));
+    CHECK(!ComponentGlob("\\*").match("a"));
+    CHECK(ComponentGlob("plain").is_literal());
+}
+
+SW_TEST(path_filter_exclude_last_rule_wins) {
+    FilterRules r;
+    r.exclude = {"*.log", "!keep.log", "build/"};
+    const PathFilter f = compiled(r);
+    CHECK(selects(f, "a.txt"));
+    CHECK(!selects(f, "a.log"));
+    CHECK(!selects(f, "sub/deep/b.log"));
+    CHECK(selects(f, "sub/keep.log"));
+    CHECK(!selects(f, "build/x.txt"));
+    CHECK(selects(f, "src/build"));     // dir-only rule: a file named build is kept
+}
+
+SW_TEST(path_filter_anchored_and_globstar) {
+    FilterRules r;
+    r.include = {"/cache/**/*.tmp"};
+    const PathFilter f = compiled(r);
+    CHECK(selects(f, "cache/a.tmp"));
+    CHECK(selects(f, "cache/x/y/b.tmp"));
+    CHECK(!selects(f, "other/cache/a.tmp"));
+    CHECK(!selects(f, "cache/a.txt"));
+}
+
+SW_TEST(path_filter_prunes_dirs_without_matches) {
+    FilterRules r;
+    r.include = {"/logs/*.log"};
+    const PathFilter f = compiled(r);
+    FilterState st;
+    f.step(f.root_state(), "src", true, st);
+    CHECK(f.prune_dir(st));
+    f.step(f.root_state(), "logs", true, st);
+    CHECK(!f.prune_dir(st));
+}
+
+SW_TEST(path_filter_include_tags) {
+    FilterRules r;
+    const PathFilter base = compiled(r);
+    PathFilter f = base;
+    std::string err;
+    CHECK(f.add_include("*.a", 3, err));
+    CHECK(f.add_include("x.*", 7, err));
+    FilterState st;
+    f.step(f.root_state(), "x.a", false, st);
+    CHECK_EQ(st.tag, 3);                // first matching rule wins
+    f.step(f.root_state(), "x.b", false, st);
+    CHECK_EQ(st.tag, 7);
+    f.step(f.root_state(), "y.b", false, st);
+    CHECK(!f.name_selected(st));
+}
+
+SW_TEST(path_filter_parse_size_and_duration) {
+    std::uint64_t n = 0;
+    CHECK(parse_size("4096", n) && n == 4096);
+    CHECK(parse_size("10K", n) && n == 10 * 1024);
+    CHECK(!parse_size("ten", n));
+    CHECK(parse_size("16777215T", n) && n == 16777215ull << 40);
+    CHECK(!parse_size("16777216T", n));
+    CHECK(!parse_size("18446744073709551616", n));
+    CHECK(!parse_size("-1", n));
+    CHECK(!parse_size("nan", n));
+    CHECK(!parse_size("inf", n));
+    CHECK(!parse_size("1e30", n));
+    std::int64_t s = 0;
+    CHECK(parse_duration("90", s) && s == 90);
+    CHECK(parse_duration("30m", s) && s == 30 * 60);
+    CHECK(parse_duration("7d", s) && s == 7 * 86400);
+    CHECK(!parse_duration("7x", s));
+    CHECK(!parse_duration("9223372036854775807d", s));
+}
+
+SW_TEST(path_filter_trailing_globstar_matches_inside_only) {
+    // gitignore: "foo/**" ignores what is inside foo, not foo itself, so a
+    // negation can still re-include a file in it.
+    FilterRules r;
+    r.exclude = {"foo/**", "!foo/keep.txt"};
+    const PathFilter f = compiled(r);
+    FilterState st;
+    f.step(f.root_state(), "foo", true, st);
+    CHECK(!st.excluded);
+    CHECK(!f.prune_dir(st));
+    CHECK(selects(f, "foo/keep.txt"));
+    CHECK(!selects(f, "foo/other.txt"));
+    CHECK(!selects(f, "foo/sub/deep.txt"));
+    CHECK(selects(f, "bar/other.txt"));
+
+    FilterRules inc;
+    inc.include = {"/cache/**"};
+    const PathFilter g = compiled(inc);
+    g.step(g.root_state(), "cache", false, st);
+    CHECK(!g.name_selected(st));        // a file named "cache" is not inside it
+    CHECK(selects(g, "cache/a"));
+    CHECK(selects(g, "cache/x/y"));
+}
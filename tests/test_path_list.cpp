@@ -0,0 +1,83 @@
+#include "test_util.h"
+#include "path_list.h"
+#include "secure_wipe.h"
+#include <fstream>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void write_raw(const std::string& path, const std::string& body) {
+    std::ofstream(path, std::ios::binary) << body;
+}
+
+std::vector<std::string> read_list(const std::string& path, char delim) {
+    PathListReader reader;
+    std::string err, line;
+    std::vector<std::string> out;
+    CHECK(reader.open(path, delim, err));
+    while (reader.next(line)) out.push_back(line);
+    CHECK(!reader.error());
+    return out;
+}
+
+} // namespace
+
+SW_TEST(path_list_delimiters_and_empty_entries) {
+    test::TempDir tmp;
+    write_raw(tmp.file("lines"), "/a\n\n/b c\n/d");     // no trailing newline
+    const std::vector<std::string> lines = read_list(tmp.file("lines"), '\n');
+    CHECK_EQ(lines.size(), 3u);
+    CHECK_EQ(lines[1], "/b c");
+    CHECK_EQ(lines[2], "/d");
+
+    // NUL-delimited entries may contain newlines.
+    write_raw(tmp.file("nul"), std::string("/x\ny\0\0/z\0", 9));
+    const std::vector<std::string> nul = read_list(tmp.file("nul"), '\0');
+    CHECK_EQ(nul.size(), 2u);
+    CHECK_EQ(nul[0], "/x\ny");
+    CHECK_EQ(nul[1], "/z");
+
+    PathListReader missing;
+    std::string err;
+    CHECK(!missing.open(tmp.file("absent"), '\n', err));
+    CHECK(!err.empty());
+}
+
+SW_TEST(path_list_entries_span_read_chunks) {
+    // Larger than the reader's 1 MiB buffer, so entries straddle refills.
+    test::TempDir tmp;
+    std::string body;
+    std::size_t n = 0;
+    while (body.size() < (3u << 20)) {
+        body += "/data/" + std::string(n % 97, 'p') + std::to_string(n) + '\n';
+        ++n;
+    }
+    write_raw(tmp.file("big"), body);
+    const std::vector<std::string> got = read_list(tmp.file("big"), '\n');
+    CHECK_EQ(got.size(), n);
+    CHECK_EQ(got[n - 1], "/data/" + std::string((n - 1) % 97, 'p') + std::to_string(n - 1));
+}
+
+SW_TEST(path_list_drives_wipe_stream) {
+    test::TempDir tmp;
+    std::string list;
+    for (int i = 0; i < 10; ++i) {
+        write_raw(tmp.file("f" + std::to_string(i)), std::string(512, 'x'));
+        if (i % 2 == 0) list += tmp.file("f" + std::to_string(i)) + '\0';
+    }
+    list += tmp.file("missing") + '\0';
+    write_raw(tmp.file("list0"), list);
+
+    PathListReader reader;
+    std::string err;
+    CHECK(reader.open(tmp.file("list0"), '\0', err));
+    WipeSession session;
+    const WipeResult r = session.wipe_stream([&](std::string& p) { return reader.next(p); }, WipeOptions(), 2);
+    CHECK(!r.ok);                       // the missing entry fails, the rest still run
+    CHECK_EQ(r.stats.files_wiped, 5u);
+    CHECK_EQ(r.stats.files_failed, 1u);
+    for (int i = 0; i < 10; ++i) CHECK_EQ(fs::exists(tmp.path() / ("f" + std::to_string(i))), i % 2 == 1);
+}
@@ -0,0 +1,61 @@
+#include "test_util.h"
+#include <fstream>
+#include <sstream>
+#include <sys/wait.h>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string read_all(const std::string& path) {
+    std::ifstream ifs(path);
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+} // namespace
+
+SW_TEST(shard_lease_dir_processes_merge_totals) {
+    test::TempDir tmp;
+    const fs::path tree = tmp.path() / "tree";
+    const std::string leases = tmp.file("leases");
+    std::uint64_t files = 0;
+    for (const char* d : {"a/x", "a/y", "b", "c/z/deep", "d"}) {
+        fs::create_directories(tree / d);
+        for (int i = 0; i < 4; ++i) {
+            std::ofstream(tree / d / ("f" + std::to_string(i))) << std::string(100 * (i + 1), 'x');
+            ++files;
+        }
+    }
+    std::ofstream(tree / "top.txt") << "loose";
+    ++files;
+
+    std::vector<pid_t> pids;
+    for (int w = 0; w < 3; ++w) {
+        pids.push_back(test::spawn_cli({"wipe-dir", tree.string(), "--yes", "--lease-dir", leases, "--worker-id",
+                                  "w" + std::to_string(w), "--shard-depth", "2"},
+                                 tmp.file("out" + std::to_string(w))));
+        CHECK(pids.back() > 0);
+    }
+    for (int w = 0; w < 3; ++w) {
+        int status = 0;
+        CHECK_EQ(::waitpid(pids[w], &status, 0), pids[w]);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        // Every participant reports the merged totals, each unit counted once.
+        const std::string out = read_all(tmp.file("out" + std::to_string(w)));
+        CHECK(out.find("wiped=" + std::to_string(files) + ",") != std::string::npos);
+        CHECK(out.find("failed=0") != std::string::npos);
+    }
+
+    std::uint64_t left = 0;
+    for (const auto& e : fs::recursive_directory_iterator(tree)) left += e.is_regular_file() ? 1 : 0;
+    CHECK_EQ(left, 0u);
+    for (const auto& e : fs::directory_iterator(leases)) {
+        const std::string name = e.path().filename().string();
+        CHECK(e.path().extension() == ".done");     // no leases, temp records or clock probes left
+        CHECK(name.find(".tmp.") == std::string::npos);
+    }
+}
@@ -0,0 +1,93 @@
+#include "test_util.h"
+#include "sqlite_scrub.h"
+#include <fstream>
+#include <sstream>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// tests/data/scrub_fixture.db (see make_sqlite_fixture.py): 30 live rows
+// whose text repeats LIVE-<n> 12 times, and deleted rows marked GONE-<n>
+// left on the freelist and in freeblocks.
+const std::size_t kLiveMarkers = 30 * 12;
+
+std::string read_all(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+std::size_t count(const std::string& hay, const std::string& needle) {
+    std::size_t n = 0;
+    for (std::size_t at = hay.find(needle); at != std::string::npos; at = hay.find(needle, at + 1)) ++n;
+    return n;
+}
+
+std::string fixture_copy(const test::TempDir& tmp) {
+    const std::string db = tmp.file("scrub.db");
+    fs::copy_file(fs::path(SECUREWIPE_TEST_DATA) / "scrub_fixture.db", db);
+    return db;
+}
+
+} // namespace
+
+SW_TEST(sqlite_scrub_clears_deleted_rows_only) {
+    test::TempDir tmp;
+    const std::string db = fixture_copy(tmp);
+    const std::string before = read_all(db);
+    CHECK(count(before, "GONE-") > 0);
+
+    SqliteScrubOptions so;
+    so.dry_run = true;
+    CHECK(sqlite_scrub(db, WipeOptions(), so).ok);
+    CHECK(read_all(db) == before);      // a dry run changes nothing
+
+    so.dry_run = false;
+    const WipeResult r = sqlite_scrub(db, WipeOptions(), so);
+    CHECK(r.ok);
+    const std::string after = read_all(db);
+    CHECK_EQ(after.size(), before.size());
+    CHECK_EQ(after.compare(0, 16, std::string("SQLite format 3\0", 16)), 0);
+    CHECK_EQ(count(after, "GONE-"), 0u);
+    CHECK_EQ(count(after, "LIVE-"), kLiveMarkers);  // stale copies of live rows go too
+    // Page size and page count in the header are unchanged.
+    CHECK_EQ(after.compare(16, 2, before, 16, 2), 0);
+    CHECK_EQ(after.compare(28, 4, before, 28, 4), 0);
+}
+
+SW_TEST(sqlite_scrub_freelist_only_leaves_btree_gaps) {
+    test::TempDir tmp;
+    const std::string db = fixture_copy(tmp);
+    const std::size_t gone = count(read_all(db), "GONE-");
+    SqliteScrubOptions so;
+    so.freelist_only = true;
+    CHECK(sqlite_scrub(db, WipeOptions(), so).ok);
+    const std::string after = read_all(db);
+    const std::size_t left = count(after, "GONE-");
+    CHECK(left > 0 && left < gone);     // the freeblocks inside live pages remain
+    CHECK(count(after, "LIVE-") >= kLiveMarkers);
+}
+
+SW_TEST(sqlite_scrub_refuses_unsafe_states) {
+    test::TempDir tmp;
+    const std::string db = fixture_copy(tmp);
+    const std::string before = read_all(db);
+
+    std::ofstream(db + "-wal") << "frames";
+    CHECK(!sqlite_scrub(db, WipeOptions(), SqliteScrubOptions()).ok);
+    fs::remove(db + "-wal");
+
+    std::ofstream(db + "-journal", std::ios::binary) << std::string("\xd9\xd5\x05\xf9", 4);
+    const WipeResult hot = sqlite_scrub(db, WipeOptions(), SqliteScrubOptions());
+    CHECK(!hot.ok);
+    CHECK(hot.message.find("Hot rollback journal") != std::string::npos);
+    fs::remove(db + "-journal");
+    CHECK(read_all(db) == before);
+
+    std::ofstream(tmp.file("plain")) << std::string(4096, 'x');
+    CHECK(!sqlite_scrub(tmp.file("plain"), WipeOptions(), SqliteScrubOptions()).ok);
+}
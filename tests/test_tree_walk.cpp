@@ -0,0 +1,55 @@
+#include "test_util.h"
+#include "secure_wipe.h"
+#include "tree_walk.h"
+#include <fstream>
+#include <sstream>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+SW_TEST(inode_map_keeps_first_value) {
+    InodeMap m;
+    CHECK(!m.contains(1, 1));
+    // Enough keys to make the table grow several times.
+    for (std::uint64_t i = 0; i < 5000; ++i) CHECK_EQ(m.insert(i % 3, i, i * 10), i * 10);
+    CHECK_EQ(m.size(), 5000u);
+    for (std::uint64_t i = 0; i < 5000; ++i) {
+        CHECK(m.contains(i % 3, i));
+        CHECK_EQ(m.insert(i % 3, i, 7), i * 10);
+    }
+    CHECK(!m.contains(1, 0));           // same inode number, other device
+    CHECK_EQ(m.size(), 5000u);
+}
+
+SW_TEST(wipe_dir_overwrites_hard_linked_inode_once) {
+    test::TempDir tmp;
+    const fs::path tree = tmp.path() / "tree";
+    fs::create_directories(tree / "b");
+    fs::create_directories(tree / "c");
+    std::ofstream(tree / "a", std::ios::binary) << std::string(4096, 'x');
+    std::ofstream(tree / "lone", std::ios::binary) << std::string(100, 'y');
+    fs::create_hard_link(tree / "a", tree / "b" / "a2");
+    fs::create_hard_link(tree / "a", tree / "c" / "a3");
+    // A name outside the tree shares the inode; it is overwritten with it.
+    fs::create_hard_link(tree / "a", tmp.path() / "outside");
+
+    WipeSession session;
+    const WipeResult dry = session.wipe_directory(tree.string(), WipeOptions(), true, false);
+    CHECK(dry.ok);
+    CHECK(dry.message.find("2 further hard links") != std::string::npos);
+
+    const WipeResult r = session.wipe_directory(tree.string(), WipeOptions(), false, true);
+    CHECK(r.ok);
+    CHECK_EQ(r.stats.files_wiped, 4u);              // every name is removed...
+    CHECK_EQ(r.stats.bytes_overwritten, 4096u + 100u);   // ...but the shared inode is written once
+    CHECK(r.message.find("hardlinks=2") != std::string::npos);
+    CHECK(!fs::exists(tree / "a"));
+    CHECK(!fs::exists(tree / "b" / "a2"));
+    CHECK(!fs::exists(tree / "c" / "a3"));
+
+    std::ifstream ifs(tmp.path() / "outside", std::ios::binary);
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    CHECK(ss.str() == std::string(4096, '\0'));
+}
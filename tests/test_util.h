@@ -0,0 +1,58 @@
+#pragma once
+// Minimal test harness: each test is a function registered by name; the
+// runner executes one test (argv[1]) or all of them, and CTest runs each
+// registered name as its own test.
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace securewipe {
+namespace test {
+
+struct Case {
+    const char* name;
+    void (*fn)();
+};
+
+std::vector<Case>& registry();
+void fail(const char* file, int line, const std::string& what);
+
+struct Register {
+    Register(const char* name, void (*fn)()) { registry().push_back(Case{name, fn}); }
+};
+
+// A fresh, empty directory below the system temp dir, removed at scope exit.
+class TempDir {
+public:
+    TempDir();
+    ~TempDir();
+    const std::filesystem::path& path() const { return path_; }
+    std::string file(const std::string& name) const { return (path_ / name).string(); }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Starts the securewipe binary built alongside the tests with `args`, its
+// stdout and stderr sent to the file `out`. Returns the child's pid.
+pid_t spawn_cli(const std::vector<std::string>& args, const std::string& out);
+
+} // namespace test
+} // namespace securewipe
+
+#define SW_TEST(name)                                                          \
+    static void name();                                                        \
+    static ::securewipe::test::Register name##_reg(#name, &name);              \
+    static void name()
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) ::securewipe::test::fail(__FILE__, __LINE__, #cond);      \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+    do {                                                                       \
+        if (!((a) == (b))) ::securewipe::test::fail(__FILE__, __LINE__, #a " == " #b); \
+    } while (0)
@@ -0,0 +1,74 @@
+#include "test_util.h"
+#include "secure_wipe.h"
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string read_all(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+std::string pattern_body(std::size_t n) {
+    std::string s(n, '\0');
+    for (std::size_t i = 0; i < n; ++i) s[i] = static_cast<char>('a' + i % 26);
+    return s;
+}
+
+} // namespace
+
+SW_TEST(wipe_range_overwrites_only_the_span) {
+    test::TempDir tmp;
+    const std::string f = tmp.file("f");
+    const std::string body = pattern_body(10000);
+    std::ofstream(f, std::ios::binary) << body;
+
+    WipeOptions opt;
+    opt.block_size = 4096;              // the span crosses block boundaries
+    const WipeResult r = wipe_range(f, 1000, 5000, opt);
+    CHECK(r.ok);
+    const std::string after = read_all(f);
+    CHECK_EQ(after.size(), body.size());
+    CHECK_EQ(after.compare(0, 1000, body, 0, 1000), 0);
+    CHECK(after.substr(1000, 5000) == std::string(5000, '\0'));
+    CHECK_EQ(after.compare(6000, 4000, body, 6000, 4000), 0);
+}
+
+SW_TEST(wipe_range_clamps_at_end_and_never_extends) {
+    test::TempDir tmp;
+    const std::string f = tmp.file("f");
+    const std::string body = pattern_body(3000);
+    std::ofstream(f, std::ios::binary) << body;
+
+    CHECK(wipe_range(f, 2000, UINT64_MAX, WipeOptions()).ok);
+    std::string after = read_all(f);
+    CHECK_EQ(after.size(), 3000u);
+    CHECK_EQ(after.compare(0, 2000, body, 0, 2000), 0);
+    CHECK(after.substr(2000) == std::string(1000, '\0'));
+
+    CHECK(wipe_range(f, 3000, 10, WipeOptions()).ok);        // empty span at the end
+    CHECK_EQ(fs::file_size(f), 3000u);
+    const WipeResult past = wipe_range(f, 3001, 10, WipeOptions());
+    CHECK(!past.ok);
+    CHECK_EQ(fs::file_size(f), 3000u);
+}
+
+SW_TEST(wipe_range_can_delete_afterwards) {
+    test::TempDir tmp;
+    const std::string f = tmp.file("f");
+    std::ofstream(f, std::ios::binary) << pattern_body(4096);
+    CHECK(wipe_range(f, 0, 512, WipeOptions(), false).ok);
+    CHECK(!fs::exists(f));
+
+    fs::create_directories(tmp.path() / "d");
+    CHECK(!wipe_range(tmp.file("d"), 0, 1, WipeOptions()).ok);
+    CHECK(!wipe_range(tmp.file("missing"), 0, 1, WipeOptions()).ok);
+}
@@ -0,0 +1,148 @@
+#include "test_util.h"
+#include "secure_wipe.h"
+#include <atomic>
+#include <fstream>
+
+using namespace securewipe;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void write_file(const fs::path& p, std::size_t size) {
+    fs::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary) << std::string(size, 'x');
+}
+
+} // namespace
+
+SW_TEST(wipe_session_reuses_workers_across_calls) {
+    test::TempDir tmp;
+    SessionOptions so;
+    so.threads = 3;
+    WipeSession session(so);
+    CHECK_EQ(session.threads(), 3u);
+
+    WipeOptions opt;
+    write_file(tmp.path() / "one", 5000);
+    const WipeResult r = session.wipe_file(tmp.file("one"), opt);
+    CHECK(r.ok);
+    CHECK(!fs::exists(tmp.path() / "one"));
+
+    // Results come back in input order; a failure does not stop the batch.
+    std::vector<std::string> batch;
+    for (int i = 0; i < 8; ++i) {
+        batch.push_back(tmp.file("b" + std::to_string(i)));
+        if (i != 5) write_file(batch.back(), 1000 * (i + 1));
+    }
+    const std::vector<WipeResult> rs = session.wipe_batch(batch, opt);
+    CHECK_EQ(rs.size(), batch.size());
+    for (std::size_t i = 0; i < rs.size(); ++i) {
+        CHECK_EQ(rs[i].ok, i != 5);
+        CHECK(!fs::exists(batch[i]));
+    }
+
+    // Session counters are cumulative over every call.
+    const WipeStats s = session.stats();
+    CHECK_EQ(s.files_wiped, 8u);
+    CHECK_EQ(s.files_failed, 1u);
+    CHECK_EQ(s.bytes_overwritten, 5000u + 1000u * (1 + 2 + 3 + 4 + 5 + 7 + 8));
+}
+
+SW_TEST(wipe_session_directory_needs_confirmation) {
+    test::TempDir tmp;
+    WipeSession session;
+    WipeOptions opt;
+    const fs::path tree = tmp.path() / "tree";
+    write_file(tree / "a" / "f", 100);
+    write_file(tree / "g", 200);
+
+    CHECK(!session.wipe_directory(tree.string(), opt, false, false).ok);
+    CHECK(fs::exists(tree / "a" / "f"));
+
+    const WipeResult dry = session.wipe_directory(tree.string(), opt, true, false);
+    CHECK(dry.ok);
+    CHECK(fs::exists(tree / "g"));
+
+    const WipeResult r = session.wipe_directory(tree.string(), opt, false, true);
+    CHECK(r.ok);
+    CHECK(!fs::exists(tree / "a" / "f"));
+    CHECK(!fs::exists(tree / "g"));
+}
+
+SW_TEST(wipe_session_submit_reports_through_ticket_and_callback) {
+    test::TempDir tmp;
+    WipeSession session;
+    WipeOptions opt;
+    write_file(tmp.path() / "f", 3000);
+
+    std::atomic<int> calls{0};
+    SubmitOptions so;
+    so.on_complete = [&](const WipeResult& r) {
+        if (r.ok) ++calls;
+    };
+    WipeTicket t = session.submit(tmp.file("f"), opt, so);
+    CHECK(t.valid());
+    const WipeResult r = t.get();
+    CHECK(r.ok);
+    CHECK_EQ(r.stats.files_wiped, 1u);
+    CHECK_EQ(r.stats.bytes_overwritten, 3000u);
+    CHECK_EQ(calls.load(), 1);          // runs before the ticket becomes ready
+    CHECK(!fs::exists(tmp.path() / "f"));
+
+    // A directory is refused unless the submission says recursive.
+    const fs::path tree = tmp.path() / "tree";
+    write_file(tree / "x" / "a", 10);
+    write_file(tree / "b", 20);
+    CHECK(!session.submit(tree.string(), opt).get().ok);
+    CHECK(fs::exists(tree / "b"));
+
+    SubmitOptions dry;
+    dry.recursive = true;
+    dry.dry_run = true;
+    CHECK(session.submit(tree.string(), opt, dry).get().ok);
+    CHECK(fs::exists(tree / "x" / "a"));
+
+    SubmitOptions rec;
+    rec.recursive = true;
+    const WipeResult d = session.submit(tree.string(), opt, rec).get();
+    CHECK(d.ok);
+    CHECK_EQ(d.stats.files_wiped, 2u);
+    CHECK(!fs::exists(tree / "x" / "a"));
+}
+
+SW_TEST(wipe_session_submit_honours_stop_and_deadline) {
+    test::TempDir tmp;
+    WipeSession session;
+    WipeOptions opt;
+    write_file(tmp.path() / "stopped", 100);
+    write_file(tmp.path() / "late", 100);
+
+    StopSource stop;
+    stop.request_stop();
+    SubmitOptions so;
+    so.stop_token = stop.get_token();
+    const WipeResult r = session.submit(tmp.file("stopped"), opt, so).get();
+    CHECK(!r.ok);
+    CHECK_EQ(r.stats.files_skipped, 1u);
+    CHECK(fs::exists(tmp.path() / "stopped"));  // never started, so left intact
+
+    SubmitOptions late;
+    late.deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    const WipeResult l = session.submit(tmp.file("late"), opt, late).get();
+    CHECK(!l.ok);
+    CHECK_EQ(l.stats.files_skipped, 1u);
+    CHECK(fs::exists(tmp.path() / "late"));
+
+    // A directory job stopped before it runs wipes nothing.
+    const fs::path tree = tmp.path() / "tree";
+    for (int i = 0; i < 20; ++i) write_file(tree / ("f" + std::to_string(i)), 100);
+    SubmitOptions rec = so;
+    rec.recursive = true;
+    const WipeResult d = session.submit(tree.string(), opt, rec).get();
+    CHECK(!d.ok);
+    CHECK_EQ(d.stats.files_wiped, 0u);
+    CHECK(fs::exists(tree / "f0"));
+    CHECK(fs::exists(tree / "f19"));
+    CHECK_EQ(session.stats().files_wiped, 0u);
+}